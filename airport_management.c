@@ -8,22 +8,112 @@
  #include <ctype.h>
  #include <gtk/gtk.h>
  #include <limits.h>
- 
- #define MAX_FLIGHTS 100
- #define MAX_RUNWAYS 5
- #define MAX_CREW 30
- #define MAX_USERS 10
- #define BUFFER_TIME 15
- #define MAX_DUTY_TIME 480
- #define MIN_REST_TIME 60
+ #include <errno.h>
+ #include <unistd.h>
+ #include <sys/socket.h>
+ #include <sys/un.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <fcntl.h>
+ #include <sys/file.h>
+ 
+ #define DEFAULT_MAX_FLIGHTS 100
+ #define DEFAULT_MAX_RUNWAYS 5
+ #define DEFAULT_MAX_CREW 30
+ #define DEFAULT_MAX_USERS 10
+ #define DEFAULT_RUNWAYS 3
+ #define DEFAULT_BUFFER_TIME 15
+ #define DEFAULT_MAX_DUTY_TIME 480
+ #define DEFAULT_MIN_REST_TIME 60
+ #define DUTY_WATCH_THRESHOLD (config.maxDutyTime * 8 / 10)
+ #define DUTY_WATCH_WORDS ((config.maxCrew + 63) / 64)
  #define CREW_BUFFER_TIME 30
  #define STR_LEN 50
  #define MAX_ACTIONS 100
- #define NOTIFICATION_BUFFER 100
+ #define UNDO_MAX_BYTES (64 * 1024 * 1024)
+ #define HISTORY_SNAPSHOT_INTERVAL 256
+ #define HISTORY_RETENTION_HOURS 26
+ #define HISTORY_MAX_BYTES (256 * 1024 * 1024)
+ #define FILENAME_ARCHIVE "archive.dat"
+ #define ARCHIVE_MAGIC 0x464d5343
+ #define ARCHIVE_MAGIC_V2 0x464d5342
+ #define ARCHIVE_MAGIC_V1 0x464d5341
+ #define ARCHIVE_SEGMENT_FLIGHTS 4096
+ #define ARCHIVE_GRACE_MINUTES 30
+ #define ARCHIVE_SWEEP_MINUTES 60
+ #define ARCHIVE_SEARCH_LIMIT 5000
+ #define ARCHIVE_ROW_FIELDS 12
+ #define EXPORT_ROW_GROUP_ROWS 65536
+ #define EXPORT_COLUMNS 13
+ #define DEFAULT_NOTIFICATION_BUFFER 100
+ #define FILENAME_CONFIG "fms.conf"
+ #define MAX_STATE_READERS 32
+ #define MAX_AIRPORTS 16
+ #define MAX_AIRPORT_LINKS 200
+ #define MAX_PLANNER_THREADS 8
  #define FILENAME_FLIGHTS "flights.dat"
  #define FILENAME_RUNWAYS "runways.dat"
  #define FILENAME_CREW "crew.dat"
  #define FILENAME_USERS "users.dat"
+ #define REPLICATION_SOCKET "fms_replication.sock"
+ #define FILENAME_REPLICATION_METRICS "replication_metrics.txt"
+ #define MAX_REPLICA_FOLLOWERS 4
+ #define REPLICATION_QUEUE_LIMIT 256
+ #define REPLICATION_BUFFER_LIMIT (32 * 1024 * 1024)
+ #define REPLICATION_HEARTBEAT_MS 500
+ #define REPLICATION_TIMEOUT_MS 5000
+ #define REPLICATION_FLUSH_MS 10
+ #define FILENAME_NOTIFICATION_LOG "notifications.log"
+ #define FILENAME_BENCHMARK_RESULTS "benchmark_results.json"
+ #define BENCHMARK_SCRATCH_FILE "benchmark_scratch.dat"
+ #define ORACLE_MAX_FLIGHTS 40
+ #define ORACLE_MAX_RUNWAYS 6
+ #define ORACLE_MAX_CREW 24
+ #define ORACLE_BATCH 256
+ #define FILENAME_METRICS "metrics.prom"
+ #define METRICS_EXPORT_SECONDS 10
+ #define LATENCY_BUCKETS 26
+ #define TRACE_BUFFER_EVENTS 4096
+ #define ARENA_BLOCK_SIZE (64 * 1024)
+ #define ARENA_ALIGN 16
+ #define MAX_NOTIFICATION_SUBSCRIBERS 8
+ #define SHARED_SCHEDULE_NAME "/fms_schedule"
+ #define SHARED_SCHEDULE_MAGIC 0x464d5333
+ #define SHARED_SCHEDULE_READ_SPINS 1000
+ #define SHARED_SCHEDULE_READ_ATTEMPTS 8
+ #define SEARCH_PAGE_SIZE 50
+ #define MAX_FILTER_PREDICATES 16
+ #define MINUTES_PER_DAY 1440
+ #define REPORT_BUFFER_SIZE 65536
+ #define REPORT_PREVIEW_ROWS 500
+ #define DELAY_SKETCH_LINEAR 64
+ #define DELAY_SKETCH_SUB 32
+ #define DELAY_SKETCH_OCTAVES 8
+ #define DELAY_SKETCH_BUCKETS (DELAY_SKETCH_LINEAR + DELAY_SKETCH_OCTAVES * DELAY_SKETCH_SUB)
+ #define TIMELINE_SPAN_MINUTES (2 * MINUTES_PER_DAY)
+ #define TIMELINE_BUCKET_MINUTES 5
+ #define TIMELINE_BUCKETS (TIMELINE_SPAN_MINUTES / TIMELINE_BUCKET_MINUTES)
+ #define TIMELINE_ROW_HEIGHT 22
+ #define TIMELINE_HEADER_HEIGHT 20
+ #define TIMELINE_LABEL_WIDTH 110
+ #define TIMELINE_LABEL_MIN_WIDTH 48
+ #define TIMELINE_LOD_PIXELS 3
+ #define TIMELINE_MIN_MINUTES_PER_PIXEL 0.05
+ 
+ typedef struct {
+     int maxFlights;
+     int maxRunways;
+     int maxCrew;
+     int maxUsers;
+     int notificationBuffer;
+     int runways;
+     int bufferTime;
+     int maxDutyTime;
+     int minRestTime;
+     char **airportCodes;
+     int airportRunways;
+     int plannerThreads;
+ } FmsConfig;
  
  typedef enum {
      ADMIN,
@@ -32,6 +122,12 @@
      VIEWER
  } UserRole;
  
+ typedef struct {
+     GtkWidget *grid;
+     GtkWidget *welcome_label;
+     GtkWidget *time_label;
+ } MainMenu;
+ 
  typedef enum {
      EMERGENCY = 1,
      INTERNATIONAL = 2,
@@ -69,6 +165,8 @@
      int crewAssigned;
      int delayMinutes;
      bool isCargo;
+     Time scheduledDeparture;
+     int operatingDay;
  } Flight;
  
  typedef struct {
@@ -96,36 +194,567 @@
  typedef struct {
      char description[STR_LEN];
      void (*undoFunction)(void*);
+     void (*redoFunction)(void*);
      void *data;
      size_t dataSize;
  } Action;
  
  typedef struct {
+     guint64 sequence;
      char message[STR_LEN*2];
      Time timestamp;
      bool isWarning;
      bool isError;
  } Notification;
  
- Flight flights[MAX_FLIGHTS];
- Runway runways[MAX_RUNWAYS];
- Crew crews[MAX_CREW];
- User users[MAX_USERS];
- Notification notifications[NOTIFICATION_BUFFER];
+ typedef struct {
+     bool inUse;
+     guint64 cursor;
+     guint64 dropped;
+ } NotificationSubscriber;
+ 
+ typedef struct {
+     int keyCount;
+     int *offsets;
+     int *rows;
+ } RowBuckets;
+ 
+ typedef struct {
+     RowBuckets byStatus;
+     RowBuckets byPriority;
+     RowBuckets byRunway;
+     RowBuckets byCrew;
+     RowBuckets byDeparture;
+ } FlightIndexes;
+ 
+ typedef enum {
+     FIELD_STATUS,
+     FIELD_PRIORITY,
+     FIELD_RUNWAY,
+     FIELD_CREW,
+     FIELD_DEPARTURE,
+     FIELD_ARRIVAL,
+     FIELD_DELAY,
+     FIELD_CARGO,
+     FIELD_ID,
+     FIELD_ORIGIN,
+     FIELD_DESTINATION,
+     FIELD_AIRCRAFT
+ } FilterField;
+ 
+ typedef enum {
+     OP_EQ,
+     OP_NE,
+     OP_LT,
+     OP_LE,
+     OP_GT,
+     OP_GE,
+     OP_CONTAINS
+ } FilterOp;
+ 
+ typedef struct {
+     FilterField field;
+     FilterOp op;
+     int value;
+     char text[STR_LEN];
+ } FilterPredicate;
+ 
+ typedef struct {
+     int predicateCount;
+     FilterPredicate predicates[MAX_FILTER_PREDICATES];
+ } FilterPlan;
+ 
+ typedef struct {
+     int statusCounts[4];
+     int priorityCounts[4];
+     int departuresByHour[24];
+     int arrivalsByHour[24];
+     int *runwayFlights;
+     int *runwayBusyMinutes;
+     int runwaysAvailable;
+     int crewAvailable;
+     int crewOnDuty;
+     int dutyWatchCount;
+     guint64 *dutyWatch;
+ } ScheduleAggregates;
+ 
+ typedef struct {
+     gint64 count;
+     gint64 totalMinutes;
+     gint32 buckets[DELAY_SKETCH_BUCKETS];
+ } DelaySketch;
+ 
+ typedef struct {
+     char key[3 * STR_LEN + 8];
+     char route[2 * STR_LEN + 1];
+     char aircraftType[STR_LEN];
+     int hour;
+     DelaySketch sketch;
+ } DelaySketchEntry;
+ 
+ typedef struct {
+     int start;
+     int end;
+     int flight;
+ } TimelineInterval;
+ 
+ typedef struct {
+     GArray *intervals;
+     int maxLength;
+     guint16 busy[TIMELINE_BUCKETS];
+ } TimelineRow;
+ 
+ typedef enum {
+     METRIC_ASSIGN_RUNWAYS,
+     METRIC_SCHEDULE_CREW,
+     METRIC_RESCHEDULE,
+     METRIC_PUBLISH,
+     METRIC_SAVE,
+     METRIC_LOAD,
+     METRIC_UI_REFRESH,
+     METRIC_TIMELINE_DRAW,
+     METRIC_REPORT,
+     LATENCY_METRIC_COUNT
+ } LatencyMetric;
+ 
+ typedef enum {
+     COUNTER_RUNWAY_CANDIDATES,
+     COUNTER_CREW_CANDIDATES,
+     COUNTER_SAVE_BYTES,
+     COUNTER_LOAD_BYTES,
+     COUNTER_NOTIFICATIONS,
+     COUNTER_ARENA_BLOCKS,
+     COUNTER_METRIC_COUNT
+ } CounterMetric;
+ 
+ typedef struct {
+     gsize buckets[LATENCY_BUCKETS];
+     gsize count;
+     gsize sumMicroseconds;
+ } LatencyHistogram;
+ 
+ typedef struct {
+     LatencyMetric id;
+     gint64 start;
+ } ScopedTimer;
+ 
+ typedef struct {
+     const char *name;
+     const char *category;
+     gint64 start;
+     gint64 duration;
+ } TraceEvent;
+ 
+ typedef struct {
+     int tid;
+     const char *threadName;
+     gint used;
+     TraceEvent events[TRACE_BUFFER_EVENTS];
+ } TraceBuffer;
+ 
+ typedef struct {
+     const char *name;
+     const char *category;
+     gint64 start;
+ } TraceScope;
+ 
+ typedef struct ArenaBlock {
+     struct ArenaBlock *previous;
+     gsize size;
+     gsize used;
+     char data[];
+ } ArenaBlock;
+ 
+ typedef struct {
+     ArenaBlock *block;
+     gsize inUse;
+     gsize highWater;
+     int depth;
+ } Arena;
+ 
+ typedef struct {
+     Arena *arena;
+     ArenaBlock *block;
+     gsize used;
+     gsize inUse;
+ } ArenaMark;
+ 
+ typedef struct ScheduleState {
+     unsigned long version;
+     int flightCount;
+     int runwayCount;
+     int crewCount;
+     Flight *flights;
+     Runway *runways;
+     Crew *crews;
+     FlightIndexes *indexes;
+     ScheduleAggregates aggregates;
+     gint retireEpoch;
+     struct ScheduleState *nextRetired;
+ } ScheduleState;
+ 
+ typedef enum {
+     REPORT_FLIGHTS,
+     REPORT_RUNWAYS,
+     REPORT_CREW,
+     REPORT_DELAYS,
+     REPORT_CHANGES,
+     REPORT_ARCHIVE
+ } ReportKind;
+ 
+ typedef enum {
+     REPORT_TEXT,
+     REPORT_CSV,
+     REPORT_JSON,
+     REPORT_HTML
+ } ReportFormat;
+ 
+ typedef struct {
+     ReportFormat format;
+     FILE *file;
+     GString *text;
+     char buffer[REPORT_BUFFER_SIZE];
+     size_t used;
+     bool failed;
+     const char *const *columns;
+     int field;
+     int rows;
+     int summaryFields;
+ } ReportWriter;
+ 
+ typedef struct {
+     guint32 seed;
+     const char *outputPath;
+     const char *baselinePath;
+     int maxFlights;
+     int budgetSeconds;
+     int tolerancePercent;
+ } BenchOptions;
+ 
+ typedef struct {
+     const char *name;
+     void (*assignRunways)(Flight *flightSet, int nFlights, Runway *runwaySet, int nRunways);
+     void (*scheduleCrew)(Flight *flightSet, int nFlights, Crew *crewSet, int nCrew);
+ } PlannerEngine;
+ 
+ typedef struct {
+     guint32 seed;
+     int cases;
+     int threads;
+     int budgetSeconds;
+     const char *engineName;
+ } OracleOptions;
+ 
+ typedef struct {
+     ReportKind kind;
+     ReportFormat format;
+     char path[64];
+     bool hasFilter;
+     FilterPlan filter;
+     gint64 asOf;
+     gint64 compareTo;
+     const ScheduleState *before;
+     GString *preview;
+     int rows;
+     guint64 version;
+     gint64 elapsedUs;
+     char error[128];
+ } ReportJob;
+ 
+ typedef struct {
+     int table;
+     int before;
+     int after;
+ } ScheduleChange;
+ 
+ typedef struct {
+     GByteArray *rows;
+     GPtrArray *strings;
+     GHashTable *stringIndex;
+     int rowCount;
+     int firstDay;
+     int lastDay;
+     gsize stringBytes;
+     // How much of the segment is already in the archive file.
+     int savedRows;
+     guint savedStrings;
+     guint savedRowBytes;
+ } ArchiveSegment;
+ 
+ typedef struct {
+     Flight flight;
+     int day;
+ } ArchivedFlight;
+ 
+ typedef struct {
+     ReportWriter *w;
+     const ReportJob *job;
+     int rowLimit;
+     int rows;
+ } ArchiveReportScan;
+ 
+ typedef enum {
+     THRIFT_TRUE = 1,
+     THRIFT_FALSE = 2,
+     THRIFT_I32 = 5,
+     THRIFT_I64 = 6,
+     THRIFT_BINARY = 8,
+     THRIFT_LIST = 9,
+     THRIFT_STRUCT = 12
+ } ThriftType;
+ 
+ typedef enum {
+     PARQUET_BOOLEAN = 0,
+     PARQUET_INT32 = 1,
+     PARQUET_BYTE_ARRAY = 6
+ } ParquetType;
+ 
+ typedef struct {
+     const char *name;
+     ParquetType type;
+     int convertedType;
+ } ExportColumn;
+ 
+ typedef struct {
+     const char *path;
+     int fromDay;
+     int toDay;
+ } ExportOptions;
+ 
+ typedef struct {
+     FILE *file;
+     gint64 offset;
+     bool failed;
+     int rows;
+     gint32 *values[EXPORT_COLUMNS];
+     GPtrArray *dictionaries[EXPORT_COLUMNS];
+     GHashTable *dictionaryIndex[EXPORT_COLUMNS];
+     GByteArray *rowGroups;
+     int rowGroupCount;
+     gint64 totalRows;
+ } ParquetWriter;
+ 
+ typedef struct {
+     gint inUse;
+     gint pinnedEpoch;
+ } StateReaderSlot;
+ 
+ typedef enum {
+     REPL_COUNTS,
+     REPL_FLIGHT,
+     REPL_RUNWAY,
+     REPL_CREW,
+     REPL_COMMIT,
+     REPL_HEARTBEAT
+ } ReplicationRecordType;
+ 
+ typedef struct {
+     guint32 type;
+     guint32 index;
+     guint64 version;
+     gint64 leaderTime;
+     union {
+         struct {
+             gint32 flightCount;
+             gint32 runwayCount;
+             gint32 crewCount;
+         } counts;
+         Flight flight;
+         Runway runway;
+         Crew crew;
+     } body;
+ } ReplicationRecord;
+ 
+ typedef struct {
+     int count;
+     ReplicationRecord *records;
+ } ReplicationBatch;
+ 
+ typedef struct {
+     int fd;
+     GByteArray *pending;
+     gsize sent;
+     bool needsSnapshot;
+     bool stalled;
+     gint64 lastProgress;
+ } ReplicaFollower;
+ 
+ typedef struct {
+     guint32 magic;
+     gint sequence;
+     guint64 version;
+     int flightCount;
+     int runwayCount;
+     int crewCount;
+     int flightCapacity;
+     int runwayCapacity;
+     int crewCapacity;
+ } SharedSchedule;
+ 
+ typedef enum {
+     CHANGED_FLIGHTS = 1 << 0,
+     CHANGED_RUNWAYS = 1 << 1,
+     CHANGED_CREW = 1 << 2
+ } ChangeSet;
+ 
+ enum {
+     FLIGHT_COL_ID,
+     FLIGHT_COL_INDEX,
+     FLIGHT_COL_DEPARTURE,
+     FLIGHT_COL_ARRIVAL,
+     FLIGHT_COL_ORIGIN,
+     FLIGHT_COL_DESTINATION,
+     FLIGHT_COL_STATUS,
+     FLIGHT_COL_RUNWAY,
+     FLIGHT_COL_CREW,
+     FLIGHT_MODEL_N_COLUMNS
+ };
+ 
+ typedef struct {
+     GObject parent;
+     gint stamp;
+     int rowCount;
+ } FlightModel;
+ 
+ typedef struct {
+     GObjectClass parent_class;
+ } FlightModelClass;
+ 
+ typedef struct {
+     char code[STR_LEN];
+     Flight *flights;
+     Runway *runways;
+     Crew *crews;
+     int flightCount;
+     int runwayCount;
+     int crewCount;
+     int shard;
+     // mirrored[i] marks a copy of a flight that is also in the main
+     // schedule; liveDelaySketches already counts it, so delaySketches
+     // holds only the airport's own flights.
+     bool *mirrored;
+     GHashTable *delaySketches;
+     GMutex lock;
+ } Airport;
+ 
+ typedef struct {
+     int originAirport;
+     char departureID[STR_LEN];
+     int destinationAirport;
+     char arrivalID[STR_LEN];
+ } AirportLink;
+ 
+ typedef enum {
+     PLAN_AIRPORT,
+     DELAY_AIRPORT_FLIGHT,
+     STOP_PLANNER
+ } PlannerMessageType;
+ 
+ typedef struct {
+     PlannerMessageType type;
+     int airport;
+     char flightID[STR_LEN];
+     int delayMinutes;
+     guint32 visited;
+ } PlannerMessage;
+ 
+ typedef struct {
+     GThread *thread;
+     GAsyncQueue *queue;
+ } PlannerShard;
+ 
+ FmsConfig config = {
+     DEFAULT_MAX_FLIGHTS, DEFAULT_MAX_RUNWAYS, DEFAULT_MAX_CREW, DEFAULT_MAX_USERS, DEFAULT_NOTIFICATION_BUFFER,
+     DEFAULT_RUNWAYS, DEFAULT_BUFFER_TIME, DEFAULT_MAX_DUTY_TIME, DEFAULT_MIN_REST_TIME,
+     NULL, DEFAULT_RUNWAYS, 1
+ };
+ Flight *flights = NULL;
+ Runway *runways = NULL;
+ Crew *crews = NULL;
+ User *users = NULL;
+ Notification *notifications = NULL;
  Action undoStack[MAX_ACTIONS];
  int flightCount = 0;
  int runwayCount = 0;
  int crewCount = 0;
  int userCount = 0;
- int notificationCount = 0;
+ guint64 notificationSequence = 0;
  int undoCount = 0;
  User currentUser;
  int selectedFlightIndex = -1;
  
+ NotificationSubscriber notificationSubscribers[MAX_NOTIFICATION_SUBSCRIBERS];
+ FILE *notificationSpill = NULL;
+ GMutex notificationLock;
+ int labelSubscriber = -1;
+ 
+ ScheduleState *publishedState = NULL;
+ ScheduleState *retiredStates = NULL;
+ StateReaderSlot stateReaders[MAX_STATE_READERS];
+ gint stateEpoch = 1;
+ GMutex stateWriteLock;
+ 
+ GHashTable *liveDelaySketches = NULL;
+ GHashTable *delayHistory = NULL;
+ GMutex delaySketchLock;
+ 
+ GPtrArray *archiveSegments = NULL;
+ int archivedFlightCount = 0;
+ bool archiveFileLoaded = false;
+ long archiveSavedEnd = -1;
+ GMutex archiveLock;
+ 
+ Airport *airports[MAX_AIRPORTS];
+ int airportCount = 0;
+ AirportLink airportLinks[MAX_AIRPORT_LINKS];
+ int airportLinkCount = 0;
+ GMutex airportLock;
+ PlannerShard plannerShards[MAX_PLANNER_THREADS];
+ int plannerShardCount = 0;
+ 
+ int replicationListenFd = -1;
+ int replicaFollowerCount = 0;
+ gint replicaResyncPending = 0;
+ GAsyncQueue *replicationQueue = NULL;
+ GAsyncQueue *replicaJoinQueue = NULL;
+ guint64 replicationShippedRecords = 0;
+ 
+ SharedSchedule *sharedSchedule = NULL;
+ int sharedScheduleFd = -1;
+ const SharedSchedule *viewerSchedule = NULL;
+ guint64 viewerScheduleVersion = 0;
+ // A viewer reads the segment into these and copies them into the globals
+ // only once a read is known to be consistent.
+ Flight *viewerFlights = NULL;
+ Runway *viewerRunways = NULL;
+ Crew *viewerCrew = NULL;
+ bool viewerProcess = false;
+ 
+ FlightModel *flightModel = NULL;
+ 
+ gint pendingChanges = 0;
+ gint refreshScheduled = 0;
+ 
+ GHashTable *searchPostings = NULL;
+ guint32 *searchRowSlots = NULL;
+ guint32 nextSearchSlot = 1;
+ int searchDeadSlots = 0;
+ bool searchIndexStale = true;
+ GArray *searchResultRows = NULL;
+ guint64 searchResultVersion = 0;
+ char *searchTerm = NULL;
+ int searchReaderSlot = -1;
+ GArray *searchArchiveRows = NULL;
+ int searchPage = 0;
+ 
  GtkWidget *window;
  GtkWidget *stack;
  GtkWidget *login_grid;
  GtkWidget *main_menu_grid;
+ MainMenu mainMenus[VIEWER + 1];
+ GThread *scheduleLoader = NULL;
+ bool scheduleLoaded = false;
+ bool loginPending = false;
  GtkWidget *flight_management_grid;
  GtkWidget *runway_management_grid;
  GtkWidget *crew_management_grid;
@@ -142,9 +771,33 @@
  GtkWidget *runway_list;
  GtkWidget *crew_list;
  GtkWidget *schedule_list;
+ GtkWidget *schedule_filter_entry;
+ GtkWidget *schedule_status_combo;
+ GtkTreeModel *scheduleFilterModel = NULL;
  GtkWidget *search_entry;
  GtkWidget *search_results;
+ GtkWidget *search_page_label;
+ GtkWidget *search_prev_button;
+ GtkWidget *search_next_button;
+ GtkListStore *searchPageStore;
  GtkWidget *report_text;
+ GtkWidget *report_format_combo;
+ GtkWidget *report_filter_entry;
+ GtkWidget *report_as_of_entry;
+ GtkWidget *report_compare_entry;
+ GtkWidget *report_status_label;
+ bool reportJobRunning = false;
+ GtkWidget *timeline_grid;
+ GtkWidget *timeline_area;
+ 
+ TimelineRow *timelineRows = NULL;
+ int timelineRowCount = 0;
+ int timelineRunwayRows = 0;
+ bool timelineStale = true;
+ double timelineViewStart = 6 * 60;
+ double timelineMinutesPerPixel = 1.0;
+ double timelineDragX;
+ double timelineDragStart;
  GtkWidget *flight_id_entry;
  GtkWidget *origin_entry;
  GtkWidget *destination_entry;
@@ -156,6 +809,72 @@
  GtkWidget *cargo_check;
  GtkWidget *delay_spin;
  
+ // Instrumentation. Latency histograms use power-of-two microsecond buckets
+ // and counters are plain atomics, so recording costs a clock read and a few
+ // atomic adds. SCOPED_TIMER records when the enclosing block exits. Building
+ // with -DFMS_NO_METRICS compiles every probe and the exporter away.
+ #ifndef FMS_NO_METRICS
+ LatencyHistogram latencyMetrics[LATENCY_METRIC_COUNT];
+ gsize counterMetrics[COUNTER_METRIC_COUNT];
+ 
+ static inline void observeLatency(LatencyMetric id, gint64 microseconds) {
+     int bucket = microseconds <= 1 ? 0 : MIN((int)g_bit_storage(microseconds - 1), LATENCY_BUCKETS - 1);
+     g_atomic_pointer_add(&latencyMetrics[id].buckets[bucket], 1);
+     g_atomic_pointer_add(&latencyMetrics[id].count, 1);
+     g_atomic_pointer_add(&latencyMetrics[id].sumMicroseconds, MAX(microseconds, 0));
+ }
+ 
+ static inline void endScopedTimer(ScopedTimer *timer) {
+     observeLatency(timer->id, g_get_monotonic_time() - timer->start);
+ }
+ 
+ #define SCOPED_TIMER(id) \
+     ScopedTimer G_PASTE(scopedTimer, __LINE__) __attribute__((cleanup(endScopedTimer))) = {id, g_get_monotonic_time()}
+ #define METRIC_ADD(id, n) g_atomic_pointer_add(&counterMetrics[id], (gssize)(n))
+ #else
+ #define SCOPED_TIMER(id) do {} while (0)
+ #define METRIC_ADD(id, n) ((void)(n))
+ #endif
+ 
+ // Trace recording (--trace FILE). Each thread appends complete events to its
+ // own TraceBuffer without locking and publishes them with an atomic store of
+ // the fill count. A full buffer is handed to the trace writer thread, which
+ // formats Chrome trace-event JSON off the hot path; traceLock is only taken
+ // when a buffer is swapped or retired. TRACE_SCOPE records its block as one
+ // event. Building with -DFMS_NO_TRACING compiles the probes away.
+ #ifndef FMS_NO_TRACING
+ gint tracingEnabled = 0;
+ 
+ bool startTracing(const char *path);
+ void stopTracing();
+ void traceThreadName(const char *name);
+ void traceRecord(const char *name, const char *category, gint64 start, gint64 end);
+ 
+ static inline void endTraceScope(TraceScope *scope) {
+     if (scope->start != 0 && g_atomic_int_get(&tracingEnabled)) {
+         traceRecord(scope->name, scope->category, scope->start, g_get_monotonic_time());
+     }
+ }
+ 
+ #define TRACE_SCOPE(name, category) \
+     TraceScope G_PASTE(traceScope, __LINE__) __attribute__((cleanup(endTraceScope))) = \
+         {name, category, g_atomic_int_get(&tracingEnabled) ? g_get_monotonic_time() : 0}
+ #else
+ #define TRACE_SCOPE(name, category) do {} while (0)
+ #define traceThreadName(name) do {} while (0)
+ #endif
+ 
+ extern gsize arenaHighWaterBytes;
+ extern gsize arenaReservedBytes;
+ Arena* threadArena();
+ void* arenaAlloc(Arena *arena, gsize size);
+ ArenaMark arenaMark(Arena *arena);
+ void arenaRelease(ArenaMark *mark);
+ 
+ #define ARENA_PASS(name) \
+     ArenaMark G_PASTE(arenaPass, __LINE__) __attribute__((cleanup(arenaRelease))) = arenaMark(threadArena()); \
+     Arena *name __attribute__((unused)) = G_PASTE(arenaPass, __LINE__).arena
+ 
  void addNotification(const char* message, bool isWarning, bool isError);
  void update_flight_list(void);
  void update_runway_list(void);
@@ -172,24 +891,121 @@
  
  void initializeSystem();
  void initializeUsers();
+ bool loadConfig(const char *path, bool required);
+ void allocateScheduleStorage();
  bool authenticateUser(const char* username, const char* password, User* user);
  void saveDataToFiles();
+ bool saveRecordFile(const char *path, const void *records, size_t recordSize, int count);
+ int loadRecordFile(const char *path, void *records, size_t recordSize, int maxCount);
  void loadDataFromFiles();
  void addNotification(const char* message, bool isWarning, bool isError);
+ int subscribeNotifications(bool fromOldest);
+ void unsubscribeNotifications(int subscriber);
+ bool readNotification(int subscriber, Notification *notification);
+ bool enableNotificationSpill(const char *path);
+ 
+ void beginScheduleWrite();
+ void cancelScheduleWrite();
+ void beginScheduleAction(const char *description);
+ bool undoScheduleAction();
+ bool redoScheduleAction();
+ void clearUndoHistory();
+ ScheduleState* materializeScheduleAt(gint64 time);
+ void freeScheduleState(ScheduleState *state);
+ void commitScheduleWrite();
+ void publishScheduleState();
+ void reclaimRetiredStates();
+ int registerStateReader();
+ void unregisterStateReader(int slot);
+ const ScheduleState* pinScheduleState(int slot);
+ void unpinScheduleState(int slot);
+ 
+ void shipScheduleDelta(const ScheduleState *prev, const ScheduleState *next);
+ bool startReplicationLeader(const char *socketPath);
+ bool runReplicationFollower(const char *socketPath);
+ 
+ bool createSharedSchedule();
+ void destroySharedSchedule();
+ void publishSharedSchedule(const ScheduleState *state);
+ const SharedSchedule* mapSharedSchedule();
+ void unmapSharedSchedule(const SharedSchedule *segment);
+ Flight* sharedScheduleFlights(const SharedSchedule *segment);
+ Runway* sharedScheduleRunways(const SharedSchedule *segment);
+ Crew* sharedScheduleCrew(const SharedSchedule *segment);
+ bool sharedScheduleReadBegin(const SharedSchedule *segment, gint *start);
+ bool sharedScheduleReadRetry(const SharedSchedule *segment, gint start);
  
  void addFlight();
  void modifyFlight();
  void deleteFlight();
  bool validateFlightID(char* flightID);
  
+ void indexFlight(int row);
+ void unindexFlight(int row);
+ void invalidateSearchIndex();
+ void rebuildSearchIndex();
+ void searchFlights(const char *term, GArray *rows);
+ 
+ bool assignOperatingDay(Flight *f);
+ int archiveFinishedFlightsNow();
+ void scanArchive(const char *term, int fromDay, int toDay,
+                  bool (*visit)(const ArchivedFlight *row, void *context), void *context);
+ void archiveStats(int *segments, int *rows, gsize *storedBytes);
+ void formatArchiveDay(int day, char *buffer, size_t size);
+ void searchArchive(const char *term, GArray *rows);
+ bool saveArchive(const char *path);
+ bool loadArchive(const char *path);
+ gboolean archive_sweep_tick(gpointer data);
+ int exportArchiveColumnar(const ExportOptions *options);
+ 
+ bool compileFilter(const char *query, FilterPlan *plan, char *error, size_t errorSize);
+ int runFilter(const FilterPlan *plan, const ScheduleState *state, GArray *rows);
+ bool flightMatchesFilter(const FilterPlan *plan, const Flight *flight);
+ const FlightIndexes* scheduleIndexes(const ScheduleState *state);
+ void freeFlightIndexes(FlightIndexes *indexes);
+ bool crewOnDutyWatch(const ScheduleAggregates *a, int crewIndex);
+ 
+ void delaySketchAdd(DelaySketch *sketch, int minutes, int weight);
+ void mergeDelaySketch(DelaySketch *into, const DelaySketch *from);
+ int delaySketchQuantile(const DelaySketch *sketch, double q);
+ GHashTable* newDelaySketchTable();
+ void recordFlightDelay(GHashTable *table, const Flight *flight, int weight);
+ void mergeDelaySketchTable(GHashTable *into, GHashTable *from);
+ void queryDelaySketch(const char *route, const char *aircraftType, int hourFrom, int hourTo, DelaySketch *out);
+ GHashTable* collectRouteDelays();
+ 
  void assignRunways();
+ void assignRunwaysFor(Flight *flightSet, int nFlights, Runway *runwaySet, int nRunways);
  
  void scheduleCrew();
+ void scheduleCrewFor(Flight *flightSet, int nFlights, Crew *crewSet, int nCrew);
+ void assignRunwaysIndexed(Flight *flightSet, int nFlights, Runway *runwaySet, int nRunways);
+ void scheduleCrewIndexed(Flight *flightSet, int nFlights, Crew *crewSet, int nCrew);
  
  void handleWeatherDelay(int delayMinutes);
  void handleEmergencyLanding();
  void handleFlightCancellation();
  void rescheduleFlights();
+ void rescheduleFlightsFor(Flight *flightSet, int nFlights, Runway *runwaySet, int nRunways,
+                           Crew *crewSet, int nCrew);
+ 
+ void generateSyntheticFlights(GRand *rng, Flight *flightSet, int n);
+ void generateSyntheticCrew(GRand *rng, Crew *crewSet, int n);
+ int runBenchmarks(const BenchOptions *options);
+ int runPlannerOracle(const OracleOptions *options);
+ 
+ void initializeRunways(Runway *runwaySet, int count);
+ int addAirport(const char *code, int nRunways);
+ bool addAirportFlight(int airport, const Flight *flight, bool mirrored);
+ bool linkAirportLeg(int originAirport, const char *departureID,
+                     int destinationAirport, const char *arrivalID);
+ void startAirportPlanners(int threadCount);
+ void stopAirportPlanners();
+ void requestAirportPlanning(int airport);
+ void requestAirportDelay(int airport, const char *flightID, int delayMinutes);
+ int findAirport(const char *code);
+ void startHostedAirports();
+ void requestHostedDelay(const Flight *flight, int delayMinutes);
  
  void on_login_clicked(GtkWidget *widget, gpointer data);
  void on_back_clicked(GtkWidget *widget, gpointer data);
@@ -203,11 +1019,21 @@
  void on_emergency_landing_clicked(GtkWidget *widget, gpointer data);
  void on_flight_cancellation_clicked(GtkWidget *widget, gpointer data);
  void on_reschedule_clicked(GtkWidget *widget, gpointer data);
+ void on_undo_clicked(GtkWidget *widget, gpointer data);
+ void on_redo_clicked(GtkWidget *widget, gpointer data);
+ gboolean on_window_key_press(GtkWidget *widget, GdkEventKey *event, gpointer data);
  void on_search_clicked(GtkWidget *widget, gpointer data);
+ void on_search_page_clicked(GtkWidget *widget, gpointer data);
  void on_generate_flights_report_clicked(GtkWidget *widget, gpointer data);
  void on_generate_runways_report_clicked(GtkWidget *widget, gpointer data);
  void on_generate_crew_report_clicked(GtkWidget *widget, gpointer data);
+ void on_generate_delays_report_clicked(GtkWidget *widget, gpointer data);
+ void on_generate_changes_report_clicked(GtkWidget *widget, gpointer data);
+ void on_generate_archive_report_clicked(GtkWidget *widget, gpointer data);
+ void start_report_job(ReportKind kind);
+ gboolean report_job_finished(gpointer data);
  void on_flight_selected(GtkTreeSelection *selection, gpointer data);
+ void on_schedule_filter_changed(GtkWidget *widget, gpointer data);
  void on_delay_dialog_response(GtkDialog *dialog, gint response_id, gpointer user_data);
  
  void update_flight_list();
@@ -215,7 +1041,26 @@
  void update_crew_list();
  void update_schedule_list();
  void show_notification(const char *message);
+ 
+ FlightModel* flight_model_new();
+ void flight_model_row_inserted(int index);
+ void flight_model_row_deleted(int index);
+ void flight_model_row_changed(int index);
+ void flight_model_rows_changed(int from, int to);
+ void flight_model_apply_delta(const ScheduleState *prev, const ScheduleState *next);
+ gboolean drain_notifications_to_label(gpointer data);
+ gboolean refresh_from_shared_schedule(gpointer data);
+ gpointer load_schedule_thread(gpointer data);
+ #ifndef FMS_NO_METRICS
+ bool writeMetricsFile(const char *path);
+ gboolean export_metrics_tick(gpointer data);
+ void finishMetricsExport();
+ #endif
+ gboolean on_schedule_loaded(gpointer data);
+ void markScheduleChanged(guint changes);
+ gboolean flush_ui_refresh(gpointer data);
  void switch_to_screen(GtkWidget *widget, gpointer data);
+ void ensure_screen(const char *screen_name);
  void show_delay_dialog();
 
  void create_login_screen();
@@ -227,8 +1072,23 @@
  void create_schedule();
  void create_search_flight();
  void create_reports();
+ void create_timeline();
+ void update_timeline();
+ void rebuildTimeline();
+ gboolean on_timeline_draw(GtkWidget *widget, cairo_t *cr, gpointer data);
+ gboolean on_timeline_scroll(GtkWidget *widget, GdkEventScroll *event, gpointer data);
+ gboolean on_timeline_button_press(GtkWidget *widget, GdkEventButton *event, gpointer data);
+ gboolean on_timeline_motion(GtkWidget *widget, GdkEventMotion *event, gpointer data);
  void create_logout_screen();
  
+ static bool textContainsIgnoreCase(const char *text, const char *term) {
+     size_t termLength = strlen(term);
+     for (; *text; text++) {
+         if (g_ascii_strncasecmp(text, term, termLength) == 0) return true;
+     }
+     return termLength == 0;
+ }
+ 
  Time addMinutesToTime(Time t, int minutes) {
      Time result = t;
      result.minute += minutes;
@@ -245,6 +1105,34 @@
      return result;
  }
  
+ // Screens other than login are built the first time they are opened.
+ static const struct {
+     const char *name;
+     void (*create)(void);
+ } screenBuilders[] = {
+     {"flight_management", create_flight_management},
+     {"runway_management", create_runway_management},
+     {"crew_management", create_crew_management},
+     {"realtime_events", create_realtime_events},
+     {"schedule", create_schedule},
+     {"search_flight", create_search_flight},
+     {"reports", create_reports},
+     {"timeline", create_timeline},
+     {"logout", create_logout_screen}
+ };
+ 
+ void ensure_screen(const char *screen_name) {
+     if (gtk_stack_get_child_by_name(GTK_STACK(stack), screen_name)) return;
+ 
+     for (size_t i = 0; i < G_N_ELEMENTS(screenBuilders); i++) {
+         if (strcmp(screenBuilders[i].name, screen_name) == 0) {
+             screenBuilders[i].create();
+             gtk_widget_show_all(gtk_stack_get_child_by_name(GTK_STACK(stack), screen_name));
+             return;
+         }
+     }
+ }
+ 
  void switch_to_screen(GtkWidget *widget, gpointer data) {
     const char *screen_name = (const char *)data;
     
@@ -263,7 +1151,8 @@
         has_access = (currentUser.role == ADMIN);
     }
     else if (strcmp(screen_name, "schedule") == 0 || 
-             strcmp(screen_name, "search_flight") == 0) {
+             strcmp(screen_name, "search_flight") == 0 ||
+             strcmp(screen_name, "timeline") == 0) {
         has_access = true; 
     }
     else if (strcmp(screen_name, "reports") == 0) {
@@ -280,6 +1169,7 @@
         return;
     }
     
+    ensure_screen(screen_name);
     gtk_stack_set_visible_child_name(GTK_STACK(stack), screen_name);
     
     if (strcmp(screen_name, "flight_management") == 0) {
@@ -340,8 +1230,83 @@
  }
  
  
+ // Capacities and planning rules. The defaults are the values the system has
+ // always been built with; FILENAME_CONFIG (or --config PATH) overrides them
+ // from [capacity] and [rules] groups, for example:
+ //
+ //   [capacity]
+ //   max_flights=2000
+ //   runways=4
+ //   [rules]
+ //   min_rest_time=90
+ //   [airports]
+ //   hosted=JFK;LAX
+ //   runways=3
+ //   planner_threads=2
+ static int configInt(GKeyFile *file, const char *group, const char *key, int fallback, int minimum) {
+     GError *error = NULL;
+     int value = g_key_file_get_integer(file, group, key, &error);
+     if (error) {
+         if (!g_error_matches(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_KEY_NOT_FOUND) &&
+             !g_error_matches(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_GROUP_NOT_FOUND)) {
+             fprintf(stderr, "Config %s.%s: %s; using %d\n", group, key, error->message, fallback);
+         }
+         g_error_free(error);
+         return fallback;
+     }
+     if (value < minimum) {
+         fprintf(stderr, "Config %s.%s=%d is below %d; using %d\n", group, key, value, minimum, fallback);
+         return fallback;
+     }
+     return value;
+ }
+ 
+ bool loadConfig(const char *path, bool required) {
+     GKeyFile *file = g_key_file_new();
+     GError *error = NULL;
+     if (!g_key_file_load_from_file(file, path, G_KEY_FILE_NONE, &error)) {
+         bool missing = g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT);
+         if (required || !missing) fprintf(stderr, "Cannot read %s: %s\n", path, error->message);
+         g_error_free(error);
+         g_key_file_free(file);
+         return !required;
+     }
+ 
+     config.maxFlights = configInt(file, "capacity", "max_flights", config.maxFlights, 1);
+     config.maxRunways = configInt(file, "capacity", "max_runways", config.maxRunways, 1);
+     config.maxCrew = configInt(file, "capacity", "max_crew", config.maxCrew, 1);
+     // The built-in accounts need four user slots.
+     config.maxUsers = configInt(file, "capacity", "max_users", config.maxUsers, 4);
+     config.notificationBuffer = configInt(file, "capacity", "notification_buffer", config.notificationBuffer, 1);
+     config.runways = configInt(file, "capacity", "runways", config.runways, 1);
+     config.bufferTime = configInt(file, "rules", "buffer_time", config.bufferTime, 0);
+     config.maxDutyTime = configInt(file, "rules", "max_duty_time", config.maxDutyTime, 1);
+     config.minRestTime = configInt(file, "rules", "min_rest_time", config.minRestTime, 0);
+     config.airportCodes = g_key_file_get_string_list(file, "airports", "hosted", NULL, NULL);
+     config.airportRunways = configInt(file, "airports", "runways", config.runways, 1);
+     config.plannerThreads = configInt(file, "airports", "planner_threads", config.plannerThreads, 1);
+     g_key_file_free(file);
+ 
+     if (config.runways > config.maxRunways) {
+         fprintf(stderr, "Config capacity.runways=%d exceeds max_runways; using %d\n", config.runways, config.maxRunways);
+         config.runways = config.maxRunways;
+     }
+     return true;
+ }
+ 
+ // Allocates the live tables to the configured capacities. Runs once at
+ // startup, before anything reads them.
+ void allocateScheduleStorage() {
+     flights = g_new0(Flight, config.maxFlights);
+     runways = g_new0(Runway, config.maxRunways);
+     crews = g_new0(Crew, config.maxCrew);
+     users = g_new0(User, config.maxUsers);
+     notifications = g_new0(Notification, config.notificationBuffer);
+     searchRowSlots = g_new0(guint32, config.maxFlights);
+ }
+ 
  void initializeSystem() {
-     for (int i = 0; i < MAX_FLIGHTS; i++) {
+     for (int i = 0; i < config.maxFlights; i++) {
         flights[i].runwayAssigned = -1;
         flights[i].crewAssigned = -1;
         flights[i].delayMinutes = 0;
@@ -349,21 +1314,8 @@
     }
 
     
-    runwayCount = 3; 
-    for (int i = 0; i < runwayCount; i++) {
-        runways[i].id = i;
-        runways[i].isAvailable = true;
-        runways[i].nextAvailableTime.hour = 0;
-        runways[i].nextAvailableTime.minute = 0;
-
-        if (i == 0) {
-            runways[i].type = ALL_FLIGHTS;
-        } else if (i == 1) {
-            runways[i].type = INTERNATIONAL_ONLY;
-        } else if (i == 2) {
-            runways[i].type = CARGO_ONLY;
-        }
-    }
+    runwayCount = config.runways;
+    initializeRunways(runways, runwayCount);
      
     char* crewNames[] = {"Capt. Smith", "F/O Johnson", "Capt. Williams", 
                           "F/O Brown", "Capt. Davis", "F/O Miller", "Capt. Wilson",
@@ -374,7 +1326,8 @@
                                "Boeing787,AirbusA350", "Boeing747,AirbusA380",
                                "Embraer190,Embraer195", "Boeing737,AirbusA320"};
      
-     for (int i = 0; i < 10; i++) {
+     crewCount = MIN((int)G_N_ELEMENTS(crewNames), config.maxCrew);
+     for (int i = 0; i < crewCount; i++) {
          crews[i].id = i;
          strcpy(crews[i].name, crewNames[i]);
          crews[i].dutyMinutesToday = 0;
@@ -383,12 +1336,30 @@
          crews[i].isAvailable = true;
          strcpy(crews[i].qualifications, qualifications[i]);
      }
-     crewCount = 10;
      
-     notificationCount = 0;
-     undoCount = 0;
+     notificationSequence = 0;
+     clearUndoHistory();
      
-     addNotification("System initialized with 5 runways and 10 crew members", false, false);
+     char msg[STR_LEN*2];
+     snprintf(msg, sizeof(msg), "System initialized with %d runways and %d crew members", runwayCount, crewCount);
+     addNotification(msg, false, false);
+ }
+ 
+ void initializeRunways(Runway *runwaySet, int count) {
+     for (int i = 0; i < count; i++) {
+         runwaySet[i].id = i;
+         runwaySet[i].isAvailable = true;
+         runwaySet[i].nextAvailableTime.hour = 0;
+         runwaySet[i].nextAvailableTime.minute = 0;
+ 
+         if (i % 3 == 0) {
+             runwaySet[i].type = ALL_FLIGHTS;
+         } else if (i % 3 == 1) {
+             runwaySet[i].type = INTERNATIONAL_ONLY;
+         } else {
+             runwaySet[i].type = CARGO_ONLY;
+         }
+     }
  }
  
  void initializeUsers() {
@@ -430,780 +1401,5091 @@ bool authenticateUser(const char* username, const char* password, User* user) {
 }
 
  
- void saveDataToFiles() {
-     FILE *file;
-     
-     file = fopen(FILENAME_FLIGHTS, "wb");
-     if (file) {
-         fwrite(&flightCount, sizeof(int), 1, file);
-         fwrite(flights, sizeof(Flight), flightCount, file);
-         fclose(file);
-     }
-     
-     file = fopen(FILENAME_RUNWAYS, "wb");
-     if (file) {
-         fwrite(&runwayCount, sizeof(int), 1, file);
-         fwrite(runways, sizeof(Runway), runwayCount, file);
-         fclose(file);
-     }
-     
-     file = fopen(FILENAME_CREW, "wb");
-     if (file) {
-         fwrite(&crewCount, sizeof(int), 1, file);
-         fwrite(crews, sizeof(Crew), crewCount, file);
-         fclose(file);
-     }
-     
-     file = fopen(FILENAME_USERS, "wb");
-     if (file) {
-         fwrite(&userCount, sizeof(int), 1, file);
-         fwrite(users, sizeof(User), userCount, file);
-         fclose(file);
+ // Data files are a record count followed by the raw records.
+ bool saveRecordFile(const char *path, const void *records, size_t recordSize, int count) {
+     SCOPED_TIMER(METRIC_SAVE);
+     TRACE_SCOPE("saveRecordFile", "io");
+     FILE *file = fopen(path, "wb");
+     if (!file) return false;
+ 
+     bool ok = fwrite(&count, sizeof(int), 1, file) == 1 &&
+               fwrite(records, recordSize, count, file) == (size_t)count;
+     METRIC_ADD(COUNTER_SAVE_BYTES, sizeof(int) + recordSize * count);
+     return fclose(file) == 0 && ok;
+ }
+ 
+ // Returns the number of records read, at most maxCount, or -1 if the file
+ // cannot be opened.
+ int loadRecordFile(const char *path, void *records, size_t recordSize, int maxCount) {
+     SCOPED_TIMER(METRIC_LOAD);
+     TRACE_SCOPE("loadRecordFile", "io");
+     FILE *file = fopen(path, "rb");
+     if (!file) return -1;
+ 
+     int count = 0;
+     if (fread(&count, sizeof(int), 1, file) != 1) count = 0;
+     count = CLAMP(count, 0, maxCount);
+     count = fread(records, recordSize, count, file);
+     METRIC_ADD(COUNTER_LOAD_BYTES, sizeof(int) + recordSize * count);
+     fclose(file);
+     return count;
+ }
+ 
+ // Flight files written before flights carried scheduledDeparture or
+ // operatingDay have shorter records. Those are widened on load: the booked
+ // departure is taken back out of the delay, which is exact for everything
+ // but planner delays, and a missing day means the current one.
+ static int loadFlightFile(const char *path) {
+     SCOPED_TIMER(METRIC_LOAD);
+     TRACE_SCOPE("loadFlightFile", "io");
+     FILE *file = fopen(path, "rb");
+     if (!file) return -1;
+ 
+     int count = 0;
+     if (fread(&count, sizeof(int), 1, file) != 1) count = 0;
+     size_t legacySize = G_STRUCT_OFFSET(Flight, scheduledDeparture);
+     size_t undatedSize = G_STRUCT_OFFSET(Flight, operatingDay);
+     struct stat info;
+     gint64 bytes = count > 0 && fstat(fileno(file), &info) == 0 ? (gint64)info.st_size - (gint64)sizeof(int) : -1;
+     bool legacy = bytes == (gint64)legacySize * count;
+     size_t recordSize = legacy ? legacySize : bytes == (gint64)undatedSize * count ? undatedSize : sizeof(Flight);
+ 
+     count = CLAMP(count, 0, config.maxFlights);
+     int loaded = 0;
+     while (loaded < count) {
+         Flight *f = &flights[loaded];
+         memset(f, 0, sizeof(Flight));
+         if (fread(f, recordSize, 1, file) != 1) break;
+         if (legacy) {
+             int booked = f->departureTime.hour * 60 + f->departureTime.minute - f->delayMinutes;
+             booked = ((booked % MINUTES_PER_DAY) + MINUTES_PER_DAY) % MINUTES_PER_DAY;
+             f->scheduledDeparture.hour = booked / 60;
+             f->scheduledDeparture.minute = booked % 60;
+         }
+         loaded++;
      }
+     METRIC_ADD(COUNTER_LOAD_BYTES, sizeof(int) + recordSize * loaded);
+     fclose(file);
+     return loaded;
+ }
+ 
+ void saveDataToFiles() {
+     saveRecordFile(FILENAME_FLIGHTS, flights, sizeof(Flight), flightCount);
+     saveRecordFile(FILENAME_RUNWAYS, runways, sizeof(Runway), runwayCount);
+     saveRecordFile(FILENAME_CREW, crews, sizeof(Crew), crewCount);
+     saveRecordFile(FILENAME_USERS, users, sizeof(User), userCount);
+     saveArchive(FILENAME_ARCHIVE);
      
      addNotification("Data saved to files", false, false);
+ 
+     g_mutex_lock(&notificationLock);
+     if (notificationSpill) fflush(notificationSpill);
+     g_mutex_unlock(&notificationLock);
  }
  
  void loadDataFromFiles() {
-     FILE *file;
-     
-    
-    file = fopen(FILENAME_FLIGHTS, "rb");
-    if (file) {
-        fread(&flightCount, sizeof(int), 1, file);
-        if (flightCount > MAX_FLIGHTS) flightCount = MAX_FLIGHTS;
-        fread(flights, sizeof(Flight), flightCount, file);
-        fclose(file);
-    }
-    
-    file = fopen(FILENAME_RUNWAYS, "rb");
-    if (file) {
-        fread(&runwayCount, sizeof(int), 1, file);
-        if (runwayCount > MAX_RUNWAYS) runwayCount = MAX_RUNWAYS; 
-        fread(runways, sizeof(Runway), runwayCount, file);
-        fclose(file);
-    } else {
-        runwayCount = 3;
-        for (int i = 0; i < runwayCount; i++) {
-            runways[i].id = i;
-            runways[i].isAvailable = true;
-            runways[i].nextAvailableTime.hour = 0;
-            runways[i].nextAvailableTime.minute = 0;
-            if (i == 0) runways[i].type = ALL_FLIGHTS;
-            else if (i == 1) runways[i].type = INTERNATIONAL_ONLY;
-            else if (i == 2) runways[i].type = CARGO_ONLY;
-        }
-    }
-     
-     file = fopen(FILENAME_CREW, "rb");
-     if (file) {
-         fread(&crewCount, sizeof(int), 1, file);
-         fread(crews, sizeof(Crew), crewCount, file);
-         fclose(file);
-     }
-     
-     file = fopen(FILENAME_USERS, "rb");
-     if (file) {
-         fread(&userCount, sizeof(int), 1, file);
-         fread(users, sizeof(User), userCount, file);
-         fclose(file);
+     int loaded;
+ 
+     loaded = loadFlightFile(FILENAME_FLIGHTS);
+     if (loaded >= 0) flightCount = loaded;
+ 
+     loaded = loadRecordFile(FILENAME_RUNWAYS, runways, sizeof(Runway), config.maxRunways);
+     if (loaded >= 0) {
+         runwayCount = loaded;
+     } else {
+         runwayCount = config.runways;
+         initializeRunways(runways, runwayCount);
      }
+ 
+     loaded = loadRecordFile(FILENAME_CREW, crews, sizeof(Crew), config.maxCrew);
+     if (loaded >= 0) crewCount = loaded;
+ 
+     loaded = loadRecordFile(FILENAME_USERS, users, sizeof(User), config.maxUsers);
+     if (loaded >= 0) userCount = loaded;
+ 
+     loadArchive(FILENAME_ARCHIVE);
      
+     invalidateSearchIndex();
      addNotification("Data loaded from files", false, false);
  }
  
+ // Wall-clock minute for notification stamps; localtime() only runs when the
+ // minute rolls over. Called with notificationLock held.
+ static Time notificationClock() {
+     static time_t minuteEnd = 0;
+     static Time cached;
+ 
+     time_t now = time(NULL);
+     if (now >= minuteEnd) {
+         struct tm *timeinfo = localtime(&now);
+         cached.hour = timeinfo->tm_hour;
+         cached.minute = timeinfo->tm_min;
+         minuteEnd = now - timeinfo->tm_sec + 60;
+     }
+     return cached;
+ }
+ 
+ // Notifications live in a fixed ring indexed by sequence number. Adding one
+ // overwrites the oldest slot; subscribers keep their own cursor and copy
+ // entries out under the lock.
  void addNotification(const char* message, bool isWarning, bool isError) {
-     if (notificationCount >= NOTIFICATION_BUFFER) {
-         for (int i = 0; i < NOTIFICATION_BUFFER - 1; i++) {
-             notifications[i] = notifications[i + 1];
+     METRIC_ADD(COUNTER_NOTIFICATIONS, 1);
+     g_mutex_lock(&notificationLock);
+ 
+     guint64 sequence = ++notificationSequence;
+     Notification *n = &notifications[sequence % config.notificationBuffer];
+     n->sequence = sequence;
+     strncpy(n->message, message, STR_LEN*2 - 1);
+     n->message[STR_LEN*2 - 1] = '\0';
+     n->timestamp = notificationClock();
+     n->isWarning = isWarning;
+     n->isError = isError;
+ 
+     if (notificationSpill) {
+         fprintf(notificationSpill, "%" G_GUINT64_FORMAT " %02d:%02d %s %s\n",
+                 sequence, n->timestamp.hour, n->timestamp.minute,
+                 isError ? "ERROR" : isWarning ? "WARN" : "INFO", n->message);
+     }
+ 
+     g_mutex_unlock(&notificationLock);
+ }
+ 
+ int subscribeNotifications(bool fromOldest) {
+     int subscriber = -1;
+     g_mutex_lock(&notificationLock);
+     for (int i = 0; i < MAX_NOTIFICATION_SUBSCRIBERS; i++) {
+         if (!notificationSubscribers[i].inUse) {
+             notificationSubscribers[i].inUse = true;
+             notificationSubscribers[i].dropped = 0;
+             if (fromOldest && notificationSequence > (guint64)config.notificationBuffer) {
+                 notificationSubscribers[i].cursor = notificationSequence - config.notificationBuffer;
+             } else {
+                 notificationSubscribers[i].cursor = fromOldest ? 0 : notificationSequence;
+             }
+             subscriber = i;
+             break;
          }
-         notificationCount--;
      }
-     
-     strncpy(notifications[notificationCount].message, message, STR_LEN*2 - 1);
-     notifications[notificationCount].timestamp = getCurrentTime();
-     notifications[notificationCount].isWarning = isWarning;
-     notifications[notificationCount].isError = isError;
-     notificationCount++;
+     g_mutex_unlock(&notificationLock);
+     return subscriber;
  }
  
+ void unsubscribeNotifications(int subscriber) {
+     if (subscriber < 0 || subscriber >= MAX_NOTIFICATION_SUBSCRIBERS) return;
+     g_mutex_lock(&notificationLock);
+     notificationSubscribers[subscriber].inUse = false;
+     g_mutex_unlock(&notificationLock);
+ }
  
- void addFlight() {
-     if (flightCount >= MAX_FLIGHTS) {
-         addNotification("Failed to add flight: Maximum limit reached", false, true);
-         return;
+ // Copies out the next unread entry. Other threads keep adding notifications,
+ // so the slot may be overwritten as soon as the lock is dropped. A
+ // subscriber that fell more than config.notificationBuffer entries behind
+ // skips ahead to the oldest retained entry and has the gap added to its
+ // dropped count.
+ bool readNotification(int subscriber, Notification *notification) {
+     if (subscriber < 0 || subscriber >= MAX_NOTIFICATION_SUBSCRIBERS) return false;
+ 
+     bool found = false;
+     g_mutex_lock(&notificationLock);
+     NotificationSubscriber *sub = &notificationSubscribers[subscriber];
+     if (sub->inUse && sub->cursor < notificationSequence) {
+         if (notificationSequence - sub->cursor > (guint64)config.notificationBuffer) {
+             guint64 oldest = notificationSequence - config.notificationBuffer;
+             sub->dropped += oldest - sub->cursor;
+             sub->cursor = oldest;
+         }
+         sub->cursor++;
+         *notification = notifications[sub->cursor % config.notificationBuffer];
+         found = true;
      }
-     
-
-     const char *flightID = gtk_entry_get_text(GTK_ENTRY(flight_id_entry));
-     const char *origin = gtk_entry_get_text(GTK_ENTRY(origin_entry));
-     const char *destination = gtk_entry_get_text(GTK_ENTRY(destination_entry));
-const char *aircraftType = NULL;
-GtkTreeIter aircraft_iter;
-if (gtk_combo_box_get_active_iter(GTK_COMBO_BOX(aircraft_entry), &aircraft_iter)) {
-    GtkTreeModel *model = gtk_combo_box_get_model(GTK_COMBO_BOX(aircraft_entry));
-    gtk_tree_model_get(model, &aircraft_iter, 0, &aircraftType, -1);
-}
-if (aircraftType == NULL) {
-    addNotification("Please select an aircraft type", false, true);
-    return;
-}
-     
-     int dep_hour = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(dep_hour_spin));
-     int dep_min = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(dep_min_spin));
-     int duration = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(duration_spin));
-     
-     gint priority_index = gtk_combo_box_get_active(GTK_COMBO_BOX(priority_combo_text));
-     
-     bool isCargo = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(cargo_check));
-     
-     if (strlen(flightID) == 0 || strlen(origin) == 0 || strlen(destination) == 0 || strlen(aircraftType) == 0) {
-         addNotification("Please fill in all flight details", false, true);
-         return;
+     g_mutex_unlock(&notificationLock);
+     return found;
+ }
+ 
+ bool enableNotificationSpill(const char *path) {
+     FILE *file = fopen(path, "a");
+     if (!file) return false;
+     setvbuf(file, NULL, _IOFBF, 64 * 1024);
+ 
+     g_mutex_lock(&notificationLock);
+     if (notificationSpill) fclose(notificationSpill);
+     notificationSpill = file;
+     g_mutex_unlock(&notificationLock);
+     return true;
+ }
+ 
+ // Scheduling state is versioned: the writer mutates the live globals under
+ // stateWriteLock and publishes an immutable copy on commit. Readers on other
+ // threads pin the current epoch, read the published copy without locking and
+ // unpin; a retired copy is freed once no reader is pinned at or before the
+ // epoch it was retired in.
+ void beginScheduleWrite() {
+     TRACE_SCOPE("stateWriteLock wait", "lock");
+     g_mutex_lock(&stateWriteLock);
+ }
+ 
+ void commitScheduleWrite() {
+     publishScheduleState();
+     g_mutex_unlock(&stateWriteLock);
+ }
+ 
+ // Releases the write lock without publishing, for writers that found
+ // nothing to change.
+ void cancelScheduleWrite() {
+     g_mutex_unlock(&stateWriteLock);
+ }
+ 
+ static guint scheduleChangeSet(const ScheduleState *prev, const ScheduleState *next) {
+     if (!prev) return CHANGED_FLIGHTS | CHANGED_RUNWAYS | CHANGED_CREW;
+ 
+     guint changes = 0;
+     if (prev->flightCount != next->flightCount ||
+         memcmp(prev->flights, next->flights, sizeof(Flight) * next->flightCount) != 0) {
+         changes |= CHANGED_FLIGHTS;
      }
-     
-     if (!validateFlightID((char*)flightID)) {
-         addNotification("Flight ID already exists", false, true);
-         return;
+     if (prev->runwayCount != next->runwayCount ||
+         memcmp(prev->runways, next->runways, sizeof(Runway) * next->runwayCount) != 0) {
+         changes |= CHANGED_RUNWAYS;
      }
-     
-     Flight newFlight;
-     strncpy(newFlight.flightID, flightID, STR_LEN - 1);
-     strncpy(newFlight.origin, origin, STR_LEN - 1);
-     strncpy(newFlight.destination, destination, STR_LEN - 1);
-     strncpy(newFlight.aircraftType, aircraftType, STR_LEN - 1);
-     
-     newFlight.departureTime.hour = dep_hour;
-     newFlight.departureTime.minute = dep_min;
-     newFlight.arrivalTime = addMinutesToTime(newFlight.departureTime, duration);
-     newFlight.priority = (FlightPriority)(priority_index + 1);
-     newFlight.status = SCHEDULED;
-     newFlight.runwayAssigned = -1;
-     newFlight.crewAssigned = -1;
-     newFlight.delayMinutes = 0;
-     newFlight.isCargo = isCargo;
-     
-     flights[flightCount] = newFlight;
-     flightCount++;
-     
-     char msg[STR_LEN*2];
-     sprintf(msg, "Flight %s added successfully", newFlight.flightID);
-     addNotification(msg, false, false);
-     
-     gtk_entry_set_text(GTK_ENTRY(flight_id_entry), "");
-     gtk_entry_set_text(GTK_ENTRY(origin_entry), "");
-     gtk_entry_set_text(GTK_ENTRY(destination_entry), "");
-     gtk_entry_set_text(GTK_ENTRY(aircraft_entry), "");
-     gtk_spin_button_set_value(GTK_SPIN_BUTTON(dep_hour_spin), 0);
-     gtk_spin_button_set_value(GTK_SPIN_BUTTON(dep_min_spin), 0);
-     gtk_spin_button_set_value(GTK_SPIN_BUTTON(duration_spin), 0);
-     gtk_combo_box_set_active(GTK_COMBO_BOX(priority_combo_text), 0);
-     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(cargo_check), FALSE);
+     if (prev->crewCount != next->crewCount ||
+         memcmp(prev->crews, next->crews, sizeof(Crew) * next->crewCount) != 0) {
+         changes |= CHANGED_CREW;
+     }
+     return changes;
  }
  
- void modifyFlight() {
-     if (selectedFlightIndex == -1 || selectedFlightIndex >= flightCount) {
-         addNotification("No flight selected for modification", false, true);
-         return;
+ // Operational aggregates are materialized on each published version. The
+ // previous version's totals are carried forward and only rows that differ
+ // between the two versions are subtracted and re-added, so reports read
+ // counts, utilization and the duty watchlist without rescanning.
+ static void accumulateFlight(ScheduleAggregates *a, const Flight *f, int sign) {
+     a->statusCounts[CLAMP((int)f->status, 0, 3)] += sign;
+     a->priorityCounts[CLAMP((int)f->priority, 0, 3)] += sign;
+     if (f->status == CANCELLED) return;
+ 
+     a->departuresByHour[CLAMP(f->departureTime.hour, 0, 23)] += sign;
+     a->arrivalsByHour[CLAMP(f->arrivalTime.hour, 0, 23)] += sign;
+     if (f->runwayAssigned >= 0 && f->runwayAssigned < config.maxRunways) {
+         a->runwayFlights[f->runwayAssigned] += sign;
+         a->runwayBusyMinutes[f->runwayAssigned] +=
+             sign * calculateTimeDifferenceInMinutes(f->departureTime, f->arrivalTime);
      }
-
-     int delayMinutes = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(delay_spin));
-     
-     if (delayMinutes <= 0) {
-         addNotification("Please enter a valid delay time", false, true);
-         return;
+ }
+ 
+ static void accumulateCrew(ScheduleAggregates *a, const Crew *c, int index, int sign) {
+     if (c->isAvailable) a->crewAvailable += sign;
+     else a->crewOnDuty += sign;
+ 
+     if (c->dutyMinutesToday > DUTY_WATCH_THRESHOLD) {
+         guint64 bit = G_GUINT64_CONSTANT(1) << (index % 64);
+         if (sign > 0) a->dutyWatch[index / 64] |= bit;
+         else a->dutyWatch[index / 64] &= ~bit;
+         a->dutyWatchCount += sign;
      }
-     
-     flights[selectedFlightIndex].departureTime = 
-         addMinutesToTime(flights[selectedFlightIndex].departureTime, delayMinutes);
-     flights[selectedFlightIndex].arrivalTime = 
-         addMinutesToTime(flights[selectedFlightIndex].arrivalTime, delayMinutes);
-     flights[selectedFlightIndex].delayMinutes += delayMinutes;
-     flights[selectedFlightIndex].status = DELAYED;
-     
-     char msg[STR_LEN*2];
-     sprintf(msg, "Flight %s delayed by %d minutes", flights[selectedFlightIndex].flightID, delayMinutes);
-     addNotification(msg, false, false);
-     
-     gtk_spin_button_set_value(GTK_SPIN_BUTTON(delay_spin), 0);
  }
  
- void deleteFlight() {
-     if (selectedFlightIndex == -1 || selectedFlightIndex >= flightCount) {
-         addNotification("No flight selected for deletion", false, true);
-         return;
+ static void updateScheduleAggregates(const ScheduleState *prev, ScheduleState *next) {
+     ScheduleAggregates *a = &next->aggregates;
+     int prevFlights = prev ? prev->flightCount : 0;
+     int prevRunways = prev ? prev->runwayCount : 0;
+     int prevCrew = prev ? prev->crewCount : 0;
+ 
+     int *runwayFlights = a->runwayFlights, *runwayBusyMinutes = a->runwayBusyMinutes;
+     guint64 *dutyWatch = a->dutyWatch;
+     if (prev) {
+         *a = prev->aggregates;
+         memcpy(runwayFlights, a->runwayFlights, sizeof(int) * config.maxRunways);
+         memcpy(runwayBusyMinutes, a->runwayBusyMinutes, sizeof(int) * config.maxRunways);
+         memcpy(dutyWatch, a->dutyWatch, sizeof(guint64) * DUTY_WATCH_WORDS);
+     } else {
+         memset(a, 0, sizeof(ScheduleAggregates));
+         memset(runwayFlights, 0, sizeof(int) * config.maxRunways);
+         memset(runwayBusyMinutes, 0, sizeof(int) * config.maxRunways);
+         memset(dutyWatch, 0, sizeof(guint64) * DUTY_WATCH_WORDS);
      }
-     
-     char flightID[STR_LEN];
-     strcpy(flightID, flights[selectedFlightIndex].flightID);
-     
-     for (int i = selectedFlightIndex; i < flightCount - 1; i++) {
-         flights[i] = flights[i + 1];
+     a->runwayFlights = runwayFlights;
+     a->runwayBusyMinutes = runwayBusyMinutes;
+     a->dutyWatch = dutyWatch;
+ 
+     for (int i = 0; i < MAX(prevFlights, next->flightCount); i++) {
+         bool inPrev = i < prevFlights, inNext = i < next->flightCount;
+         if (inPrev && inNext && memcmp(&prev->flights[i], &next->flights[i], sizeof(Flight)) == 0) continue;
+         if (inPrev) accumulateFlight(a, &prev->flights[i], -1);
+         if (inNext) accumulateFlight(a, &next->flights[i], 1);
      }
-     flightCount--;
+ 
+     for (int i = 0; i < MAX(prevRunways, next->runwayCount); i++) {
+         bool inPrev = i < prevRunways, inNext = i < next->runwayCount;
+         if (inPrev && inNext && memcmp(&prev->runways[i], &next->runways[i], sizeof(Runway)) == 0) continue;
+         if (inPrev && prev->runways[i].isAvailable) a->runwaysAvailable--;
+         if (inNext && next->runways[i].isAvailable) a->runwaysAvailable++;
+     }
+ 
+     for (int i = 0; i < MAX(prevCrew, next->crewCount); i++) {
+         bool inPrev = i < prevCrew, inNext = i < next->crewCount;
+         if (inPrev && inNext && memcmp(&prev->crews[i], &next->crews[i], sizeof(Crew)) == 0) continue;
+         if (inPrev) accumulateCrew(a, &prev->crews[i], i, -1);
+         if (inNext) accumulateCrew(a, &next->crews[i], i, 1);
+     }
+ }
+ 
+ bool crewOnDutyWatch(const ScheduleAggregates *a, int crewIndex) {
+     if (crewIndex < 0 || crewIndex >= config.maxCrew) return false;
+     return (a->dutyWatch[crewIndex / 64] >> (crewIndex % 64)) & 1;
+ }
+ 
+ // Delay sketches. Each sketch is a log-linear histogram of delay minutes:
+ // exact buckets below 64, then 32 buckets per power of two, which bounds
+ // the quantile error to about 2%. Sketches are plain bucket counts, so two
+ // of them merge by addition and a flight's old delay can be subtracted
+ // when it changes. Entries are keyed by route, aircraft type and scheduled
+ // departure hour; queries merge whichever entries match. The live table
+ // follows each published version, planner shards keep their own tables,
+ // and delayHistory holds flights that have left the live schedule.
+ static int delaySketchBucket(int minutes) {
+     if (minutes < 0) minutes = 0;
+     if (minutes < DELAY_SKETCH_LINEAR) return minutes;
+     int octave = g_bit_storage(minutes) - 1;
+     if (octave >= 6 + DELAY_SKETCH_OCTAVES) return DELAY_SKETCH_BUCKETS - 1;
+     return DELAY_SKETCH_LINEAR + (octave - 6) * DELAY_SKETCH_SUB +
+            ((minutes >> (octave - 5)) & (DELAY_SKETCH_SUB - 1));
+ }
+ 
+ static int delaySketchBucketValue(int bucket) {
+     if (bucket < DELAY_SKETCH_LINEAR) return bucket;
+     int octave = (bucket - DELAY_SKETCH_LINEAR) / DELAY_SKETCH_SUB + 6;
+     int sub = (bucket - DELAY_SKETCH_LINEAR) % DELAY_SKETCH_SUB;
+     int width = 1 << (octave - 5);
+     return (1 << octave) + sub * width + width / 2;
+ }
+ 
+ void delaySketchAdd(DelaySketch *sketch, int minutes, int weight) {
+     sketch->buckets[delaySketchBucket(minutes)] += weight;
+     sketch->count += weight;
+     sketch->totalMinutes += (gint64)MAX(minutes, 0) * weight;
+ }
+ 
+ void mergeDelaySketch(DelaySketch *into, const DelaySketch *from) {
+     for (int b = 0; b < DELAY_SKETCH_BUCKETS; b++) into->buckets[b] += from->buckets[b];
+     into->count += from->count;
+     into->totalMinutes += from->totalMinutes;
+ }
+ 
+ int delaySketchQuantile(const DelaySketch *sketch, double q) {
+     if (sketch->count <= 0) return 0;
+     gint64 rank = (gint64)(CLAMP(q, 0.0, 1.0) * (sketch->count - 1)) + 1;
+     gint64 seen = 0;
+     for (int b = 0; b < DELAY_SKETCH_BUCKETS; b++) {
+         seen += sketch->buckets[b];
+         if (seen >= rank) return delaySketchBucketValue(b);
+     }
+     return delaySketchBucketValue(DELAY_SKETCH_BUCKETS - 1);
+ }
+ 
+ GHashTable* newDelaySketchTable() {
+     return g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+ }
+ 
+ static DelaySketchEntry* delaySketchEntry(GHashTable *table, const char *route,
+                                          const char *aircraftType, int hour) {
+     char key[sizeof(((DelaySketchEntry *)0)->key)];
+     snprintf(key, sizeof(key), "%s|%s|%02d", route, aircraftType, hour);
+ 
+     DelaySketchEntry *entry = g_hash_table_lookup(table, key);
+     if (!entry) {
+         entry = g_new0(DelaySketchEntry, 1);
+         strcpy(entry->key, key);
+         strncpy(entry->route, route, sizeof(entry->route) - 1);
+         strncpy(entry->aircraftType, aircraftType, STR_LEN - 1);
+         entry->hour = hour;
+         g_hash_table_insert(table, entry->key, entry);
+     }
+     return entry;
+ }
+ 
+ // Keyed on the departure as booked. Manual delays move departureTime but the
+ // planners only add to delayMinutes, so the hour cannot be derived from them.
+ void recordFlightDelay(GHashTable *table, const Flight *flight, int weight) {
+     if (flight->status == CANCELLED) return;
+ 
+     char route[2 * STR_LEN + 1];
+     snprintf(route, sizeof(route), "%s-%s", flight->origin, flight->destination);
+     int hour = CLAMP(flight->scheduledDeparture.hour, 0, 23);
+ 
+     DelaySketchEntry *entry = delaySketchEntry(table, route, flight->aircraftType, hour);
+     delaySketchAdd(&entry->sketch, flight->delayMinutes, weight);
+     if (entry->sketch.count <= 0) g_hash_table_remove(table, entry->key);
+ }
+ 
+ void mergeDelaySketchTable(GHashTable *into, GHashTable *from) {
+     GHashTableIter iter;
+     gpointer value;
+     g_hash_table_iter_init(&iter, from);
+     while (g_hash_table_iter_next(&iter, NULL, &value)) {
+         DelaySketchEntry *source = value;
+         DelaySketchEntry *target = delaySketchEntry(into, source->route, source->aircraftType, source->hour);
+         mergeDelaySketch(&target->sketch, &source->sketch);
+     }
+ }
+ 
+ static void updateDelaySketches(const ScheduleState *prev, const ScheduleState *next) {
+     int prevFlights = prev ? prev->flightCount : 0;
+ 
+     g_mutex_lock(&delaySketchLock);
+     if (!liveDelaySketches) liveDelaySketches = newDelaySketchTable();
+     for (int i = 0; i < MAX(prevFlights, next->flightCount); i++) {
+         bool inPrev = i < prevFlights, inNext = i < next->flightCount;
+         if (inPrev && inNext && memcmp(&prev->flights[i], &next->flights[i], sizeof(Flight)) == 0) continue;
+         if (inPrev) recordFlightDelay(liveDelaySketches, &prev->flights[i], -1);
+         if (inNext) recordFlightDelay(liveDelaySketches, &next->flights[i], 1);
+     }
+     g_mutex_unlock(&delaySketchLock);
+ }
+ 
+ static bool hourInRange(int hour, int hourFrom, int hourTo) {
+     if (hourFrom <= hourTo) return hour >= hourFrom && hour <= hourTo;
+     return hour >= hourFrom || hour <= hourTo;
+ }
+ 
+ static void mergeMatchingDelays(DelaySketch *out, GHashTable *table, const char *route,
+                                 const char *aircraftType, int hourFrom, int hourTo) {
+     if (!table) return;
+     GHashTableIter iter;
+     gpointer value;
+     g_hash_table_iter_init(&iter, table);
+     while (g_hash_table_iter_next(&iter, NULL, &value)) {
+         DelaySketchEntry *entry = value;
+         if (route && g_ascii_strcasecmp(entry->route, route) != 0) continue;
+         if (aircraftType && g_ascii_strcasecmp(entry->aircraftType, aircraftType) != 0) continue;
+         if (!hourInRange(entry->hour, hourFrom, hourTo)) continue;
+         mergeDelaySketch(out, &entry->sketch);
+     }
+ }
+ 
+ // Merges every sketch matching the route ("DEL-BOM") and aircraft type, or
+ // any when NULL, whose scheduled departure hour lies in hourFrom..hourTo
+ // (wrapping past midnight when hourFrom > hourTo).
+ void queryDelaySketch(const char *route, const char *aircraftType, int hourFrom, int hourTo, DelaySketch *out) {
+     memset(out, 0, sizeof(DelaySketch));
+ 
+     g_mutex_lock(&delaySketchLock);
+     mergeMatchingDelays(out, liveDelaySketches, route, aircraftType, hourFrom, hourTo);
+     mergeMatchingDelays(out, delayHistory, route, aircraftType, hourFrom, hourTo);
+     g_mutex_unlock(&delaySketchLock);
+ 
+     int hosted = g_atomic_int_get(&airportCount);
+     for (int i = 0; i < hosted; i++) {
+         g_mutex_lock(&airports[i]->lock);
+         mergeMatchingDelays(out, airports[i]->delaySketches, route, aircraftType, hourFrom, hourTo);
+         g_mutex_unlock(&airports[i]->lock);
+     }
+ }
+ 
+ static void mergeByRoute(GHashTable *routes, GHashTable *table) {
+     if (!table) return;
+     GHashTableIter iter;
+     gpointer value;
+     g_hash_table_iter_init(&iter, table);
+     while (g_hash_table_iter_next(&iter, NULL, &value)) {
+         DelaySketchEntry *entry = value;
+         mergeDelaySketch(&delaySketchEntry(routes, entry->route, "*", 0)->sketch, &entry->sketch);
+     }
+ }
+ 
+ // Merges all sketches into one entry per route, for reporting.
+ GHashTable* collectRouteDelays() {
+     GHashTable *routes = newDelaySketchTable();
+ 
+     g_mutex_lock(&delaySketchLock);
+     mergeByRoute(routes, liveDelaySketches);
+     mergeByRoute(routes, delayHistory);
+     g_mutex_unlock(&delaySketchLock);
+ 
+     int hosted = g_atomic_int_get(&airportCount);
+     for (int i = 0; i < hosted; i++) {
+         g_mutex_lock(&airports[i]->lock);
+         mergeByRoute(routes, airports[i]->delaySketches);
+         g_mutex_unlock(&airports[i]->lock);
+     }
+     return routes;
+ }
+ 
+ // Undo and redo. A user action runs between beginScheduleAction() and
+ // commitScheduleWrite(). At publish time its effect is stored on undoStack
+ // as a delta against the previous version, with one record per changed row:
+ //   - an edited row keeps only the changed byte span, XORed old against new;
+ //   - a row inserted or removed in the middle keeps one copy of that row;
+ //   - rows added or dropped at the end of a table keep one copy each.
+ // Undo replays the records backwards with inverse operations and redo
+ // replays them forwards, so both cost O(delta). A re-plan of 10k flights
+ // touches status through delayMinutes of each row, about 32 bytes per
+ // flight. Commits that change the schedule without an action (loads,
+ // replication, archive sweeps) clear the history, because the deltas only apply to the
+ // exact version they were recorded against.
+ typedef enum {
+     UNDO_FLIGHTS,
+     UNDO_RUNWAYS,
+     UNDO_CREW
+ } UndoTable;
+ 
+ typedef enum {
+     UNDO_PATCH,
+     UNDO_INSERT,
+     UNDO_REMOVE
+ } UndoOp;
+ 
+ typedef struct {
+     guint8 table;
+     guint8 op;
+     guint16 offset;
+     guint16 length;
+     gint32 index;
+ } UndoRecord;
+ 
+ // The tables a delta is applied to, indexed by UndoTable: the live globals
+ // for undo and redo, or a private copy when history is replayed.
+ typedef struct {
+     void *rows[3];
+     int count[3];
+     int capacity[3];
+ } ScheduleTables;
+ 
+ static const size_t undoRowSizes[] = {sizeof(Flight), sizeof(Runway), sizeof(Crew)};
+ 
+ const char *pendingActionDescription = NULL;
+ bool replayingAction = false;
+ int redoCount = 0;
+ gsize undoBytes = 0;
+ 
+ 
+ static void appendUndoRecord(GByteArray *delta, UndoTable table, UndoOp op, int index,
+                              size_t offset, size_t length, const guint8 *bytes) {
+     UndoRecord record = {table, op, (guint16)offset, (guint16)length, index};
+     g_byte_array_append(delta, (const guint8 *)&record, sizeof(record));
+     g_byte_array_append(delta, bytes, length);
+     // Keep the next header aligned.
+     static const guint8 padding[sizeof(UndoRecord)] = {0};
+     g_byte_array_append(delta, padding, (guint)(-length & (G_ALIGNOF(UndoRecord) - 1)));
+ }
+ 
+ static void diffUndoTable(GByteArray *delta, UndoTable table, const void *prevRows, int prevCount,
+                           const void *nextRows, int nextCount, size_t rowSize) {
+     const guint8 *prev = prevRows, *next = nextRows;
+     int common = MIN(prevCount, nextCount);
+ 
+     // A single row inserted or removed anywhere shifts everything after it;
+     // store that as one structural record instead of patching the tail.
+     if (nextCount == prevCount + 1 || nextCount == prevCount - 1) {
+         int k = 0;
+         while (k < common && memcmp(prev + k * rowSize, next + k * rowSize, rowSize) == 0) k++;
+         bool removed = nextCount < prevCount;
+         const guint8 *longer = removed ? prev : next, *shorter = removed ? next : prev;
+         if (memcmp(longer + (k + 1) * rowSize, shorter + k * rowSize, (common - k) * rowSize) == 0) {
+             appendUndoRecord(delta, table, removed ? UNDO_REMOVE : UNDO_INSERT, k, 0, rowSize, longer + k * rowSize);
+             return;
+         }
+     }
+ 
+     guint8 span[sizeof(Flight) > sizeof(Crew) ? sizeof(Flight) : sizeof(Crew)];
+     for (int i = 0; i < common; i++) {
+         const guint8 *a = prev + i * rowSize, *b = next + i * rowSize;
+         if (memcmp(a, b, rowSize) == 0) continue;
+         size_t first = 0, last = rowSize;
+         while (a[first] == b[first]) first++;
+         while (a[last - 1] == b[last - 1]) last--;
+         for (size_t j = first; j < last; j++) span[j - first] = a[j] ^ b[j];
+         appendUndoRecord(delta, table, UNDO_PATCH, i, first, last - first, span);
+     }
+     for (int i = prevCount - 1; i >= common; i--) {
+         appendUndoRecord(delta, table, UNDO_REMOVE, i, 0, rowSize, prev + i * rowSize);
+     }
+     for (int i = common; i < nextCount; i++) {
+         appendUndoRecord(delta, table, UNDO_INSERT, i, 0, rowSize, next + i * rowSize);
+     }
+ }
+ 
+ static GByteArray* buildScheduleDelta(const ScheduleState *prev, const ScheduleState *next) {
+     GByteArray *delta = g_byte_array_new();
+     diffUndoTable(delta, UNDO_FLIGHTS, prev->flights, prev->flightCount, next->flights, next->flightCount, sizeof(Flight));
+     diffUndoTable(delta, UNDO_RUNWAYS, prev->runways, prev->runwayCount, next->runways, next->runwayCount, sizeof(Runway));
+     diffUndoTable(delta, UNDO_CREW, prev->crews, prev->crewCount, next->crews, next->crewCount, sizeof(Crew));
+     return delta;
+ }
+ 
+ static void applyUndoRecord(ScheduleTables *tables, const UndoRecord *record, bool forward) {
+     int *count = &tables->count[record->table], capacity = tables->capacity[record->table];
+     size_t rowSize = undoRowSizes[record->table];
+     guint8 *rows = tables->rows[record->table];
+     const guint8 *bytes = (const guint8 *)(record + 1);
+     UndoOp op = record->op;
+     if (!forward && op != UNDO_PATCH) op = op == UNDO_INSERT ? UNDO_REMOVE : UNDO_INSERT;
+ 
+     guint8 *row = rows + (size_t)record->index * rowSize;
+     switch (op) {
+         case UNDO_PATCH:
+             for (size_t j = 0; j < record->length; j++) row[record->offset + j] ^= bytes[j];
+             break;
+         case UNDO_INSERT:
+             if (*count >= capacity || record->index > *count) return;
+             memmove(row + rowSize, row, (*count - record->index) * rowSize);
+             memcpy(row, bytes, rowSize);
+             (*count)++;
+             break;
+         case UNDO_REMOVE:
+             if (record->index >= *count) return;
+             memmove(row, row + rowSize, (*count - record->index - 1) * rowSize);
+             (*count)--;
+             break;
+     }
+ }
+ 
+ static void applyScheduleDelta(ScheduleTables *tables, const guint8 *data, size_t size, bool forward) {
+     ARENA_PASS(arena);
+     // Records are variable length, so walk them once to find each start.
+     int records = 0;
+     const UndoRecord **starts = arenaAlloc(arena, sizeof(UndoRecord *) * (size / sizeof(UndoRecord) + 1));
+     for (size_t at = 0; at < size; ) {
+         const UndoRecord *record = (const UndoRecord *)(data + at);
+         starts[records++] = record;
+         at += sizeof(UndoRecord) + ((record->length + G_ALIGNOF(UndoRecord) - 1) & ~(G_ALIGNOF(UndoRecord) - 1));
+     }
+ 
+     if (forward) {
+         for (int i = 0; i < records; i++) applyUndoRecord(tables, starts[i], true);
+     } else {
+         for (int i = records - 1; i >= 0; i--) applyUndoRecord(tables, starts[i], false);
+     }
+ }
+ 
+ static void replayScheduleDelta(Action *action, bool forward) {
+     ScheduleTables live = {
+         {flights, runways, crews},
+         {flightCount, runwayCount, crewCount},
+         {config.maxFlights, config.maxRunways, config.maxCrew}
+     };
+     applyScheduleDelta(&live, action->data, action->dataSize, forward);
+     flightCount = live.count[UNDO_FLIGHTS];
+     runwayCount = live.count[UNDO_RUNWAYS];
+     crewCount = live.count[UNDO_CREW];
+     replayingAction = true;
      selectedFlightIndex = -1;
-     
+     invalidateSearchIndex();
+ }
+ 
+ static void undoScheduleDelta(void *data) {
+     replayScheduleDelta(data, false);
+ }
+ 
+ static void redoScheduleDelta(void *data) {
+     replayScheduleDelta(data, true);
+ }
+ 
+ static void freeAction(Action *action) {
+     undoBytes -= action->dataSize;
+     g_free(action->data);
+     action->data = NULL;
+     action->dataSize = 0;
+ }
+ 
+ void clearUndoHistory() {
+     for (int i = 0; i < undoCount + redoCount; i++) freeAction(&undoStack[i]);
+     undoCount = 0;
+     redoCount = 0;
+ }
+ 
+ static void pushAction(const char *description, GByteArray *delta) {
+     for (int i = undoCount; i < undoCount + redoCount; i++) freeAction(&undoStack[i]);
+     redoCount = 0;
+ 
+     // Drop the oldest actions past the depth or memory limit.
+     while (undoCount > 0 && (undoCount == MAX_ACTIONS || undoBytes + delta->len > UNDO_MAX_BYTES)) {
+         freeAction(&undoStack[0]);
+         memmove(&undoStack[0], &undoStack[1], sizeof(Action) * (undoCount - 1));
+         undoCount--;
+     }
+ 
+     Action *action = &undoStack[undoCount++];
+     g_strlcpy(action->description, description, sizeof(action->description));
+     action->undoFunction = undoScheduleDelta;
+     action->redoFunction = redoScheduleDelta;
+     action->dataSize = delta->len;
+     action->data = g_byte_array_free(delta, FALSE);
+     undoBytes += action->dataSize;
+ }
+ 
+ // Called from publishScheduleState() with the write lock held. delta is
+ // prev -> next, or NULL for the first version.
+ static void recordScheduleAction(const GByteArray *delta) {
+     const char *description = pendingActionDescription;
+     bool replaying = replayingAction;
+     pendingActionDescription = NULL;
+     replayingAction = false;
+     if (!delta || replaying) return;
+ 
+     if (!description) {
+         if (undoCount + redoCount > 0 && delta->len > 0) clearUndoHistory();
+         return;
+     }
+     if (delta->len == 0) return;
+ 
+     GByteArray *copy = g_byte_array_sized_new(delta->len);
+     g_byte_array_append(copy, delta->data, delta->len);
+     pushAction(description, copy);
+ }
+ 
+ void beginScheduleAction(const char *description) {
+     beginScheduleWrite();
+     pendingActionDescription = description;
+ }
+ 
+ // Both run with the write lock held; the caller commits.
+ bool undoScheduleAction() {
+     if (undoCount == 0) {
+         addNotification("Nothing to undo", false, true);
+         return false;
+     }
+     Action *action = &undoStack[--undoCount];
+     redoCount++;
+     action->undoFunction(action);
+ 
      char msg[STR_LEN*2];
-     sprintf(msg, "Flight %s deleted", flightID);
+     snprintf(msg, sizeof(msg), "Undone: %s", action->description);
      addNotification(msg, false, false);
+     return true;
  }
  
- bool validateFlightID(char* flightID) {
-     for (int i = 0; i < flightCount; i++) {
-         if (strcmp(flights[i].flightID, flightID) == 0) {
-             return false;
-         }
+ bool redoScheduleAction() {
+     if (redoCount == 0) {
+         addNotification("Nothing to redo", false, true);
+         return false;
      }
+     Action *action = &undoStack[undoCount++];
+     redoCount--;
+     action->redoFunction(action);
+ 
+     char msg[STR_LEN*2];
+     snprintf(msg, sizeof(msg), "Redone: %s", action->description);
+     addNotification(msg, false, false);
      return true;
  }
  
+ // A published state lives in one allocation sized to its own rows, with the
+ // per-runway and per-crew aggregate arrays sized to the configured capacity.
+ static ScheduleState* newScheduleState(int nFlights, int nRunways, int nCrew) {
+     gsize size = sizeof(ScheduleState) + sizeof(Flight) * nFlights + sizeof(Runway) * nRunways +
+                  sizeof(Crew) * nCrew + sizeof(int) * 2 * config.maxRunways + sizeof(guint64) * DUTY_WATCH_WORDS;
+     ScheduleState *state = g_malloc(size);
+     char *cursor = (char *)(state + 1);
+ 
+     state->aggregates.dutyWatch = (guint64 *)cursor;
+     cursor += sizeof(guint64) * DUTY_WATCH_WORDS;
+     state->flights = (Flight *)cursor;
+     cursor += sizeof(Flight) * nFlights;
+     state->runways = (Runway *)cursor;
+     cursor += sizeof(Runway) * nRunways;
+     state->crews = (Crew *)cursor;
+     cursor += sizeof(Crew) * nCrew;
+     state->aggregates.runwayFlights = (int *)cursor;
+     state->aggregates.runwayBusyMinutes = (int *)cursor + config.maxRunways;
+ 
+     state->flightCount = nFlights;
+     state->runwayCount = nRunways;
+     state->crewCount = nCrew;
+     return state;
+ }
  
- void assignRunways() {
-    for (int i = 0; i < flightCount; i++) {
-        if (flights[i].runwayAssigned == -1 && flights[i].status != CANCELLED) {
-           
-            for (int r = 0; r < runwayCount; r++) {
-                
-                bool isCompatible = false;
-                
-                if (runways[r].isAvailable) {
-                    switch(runways[r].type) {
-                        case ALL_FLIGHTS:
-                            isCompatible = true;
-                            break;
-                        case INTERNATIONAL_ONLY:
-                            isCompatible = (flights[i].priority == INTERNATIONAL);
-                            break;
-                        case CARGO_ONLY:
-                            isCompatible = flights[i].isCargo;
-                            break;
-                    }
-                }
-                
-           
-                if (isCompatible && (compareTime(flights[i].departureTime, 
-                                     runways[r].nextAvailableTime) >= 0)) {
-                   
-                    flights[i].runwayAssigned = r;
-                    runways[r].isAvailable = false;
-                    runways[r].nextAvailableTime = 
-                        addMinutesToTime(flights[i].arrivalTime, BUFFER_TIME);
-                    break; 
-                }
-            }
-            
-           
-            if (flights[i].runwayAssigned == -1) {
-                flights[i].status = DELAYED;
-                flights[i].delayMinutes += 15; 
-            }
-        }
-    }
-}
+ void freeScheduleState(ScheduleState *state) {
+     if (!state) return;
+     freeFlightIndexes(state->indexes);
+     g_free(state);
+ }
  
+ // Schedule history. Every published version is appended to scheduleHistory
+ // with its wall-clock time, either as the delta from the version before it
+ // (same record format as undo) or as a full snapshot. A snapshot is taken
+ // every HISTORY_SNAPSHOT_INTERVAL versions, or sooner once the deltas since
+ // the last one add up to more than a snapshot would cost, so replaying to
+ // any instant touches at most one snapshot and a bounded run of deltas.
+ // Whole segments (a snapshot and its deltas) are dropped once the next
+ // segment starts before the retention window or the history is over its
+ // memory limit. Entries are reference counted so a replay can hold the ones
+ // it needs without holding historyLock.
+ typedef struct {
+     gint refs;
+     gint64 time;
+     guint64 version;
+     guint8 *delta;
+     gsize deltaSize;
+     ScheduleState *snapshot;
+ } HistoryEntry;
+ 
+ GMutex historyLock;
+ GPtrArray *scheduleHistory = NULL;
+ gsize historyBytes = 0;
+ gsize historyDeltaBytes = 0;
+ int historyDeltasSinceSnapshot = 0;
+ 
+ static gsize scheduleStateRowBytes(const ScheduleState *state) {
+     return sizeof(Flight) * state->flightCount + sizeof(Runway) * state->runwayCount + sizeof(Crew) * state->crewCount;
+ }
  
-void scheduleCrew() {
-    for (int i = 0; i < flightCount; i++) {
-        if (flights[i].crewAssigned == -1 && flights[i].status != CANCELLED) {
-           
-            int bestCrewIndex = -1;
-            int bestScore = -1;
-            
-            for (int c = 0; c < crewCount; c++) {
-                if (!crews[c].isAvailable) continue;
-                if (crews[c].dutyMinutesToday >= MAX_DUTY_TIME) continue;
-                Time earliestStart = addMinutesToTime(crews[c].lastFlightEnd, MIN_REST_TIME);
-                if (compareTime(flights[i].departureTime, earliestStart) < 0) continue;
-              
-                char qualStr[STR_LEN*2];
-                snprintf(qualStr, sizeof(qualStr), ",%s,", crews[c].qualifications);
-                char aircraftStr[STR_LEN*2];
-                snprintf(aircraftStr, sizeof(aircraftStr), ",%s,", flights[i].aircraftType);
-                
-                int score = 0;
-                if (strstr(qualStr, aircraftStr) != NULL) {
-                    score = 100; 
-                } else if (strstr(flights[i].aircraftType, "Boeing") && 
-                          strstr(qualStr, ",Boeing,")) {
-                    score = 50; 
-                } else if (strstr(flights[i].aircraftType, "Airbus") && 
-                          strstr(qualStr, ",Airbus,")) {
-                    score = 50; 
-                }
-
-                score += (MAX_DUTY_TIME - crews[c].dutyMinutesToday)/10;
-                
-                if (score > bestScore) {
-                    bestScore = score;
-                    bestCrewIndex = c;
-                }
-            }
-            
-            if (bestCrewIndex != -1) {
-                flights[i].crewAssigned = bestCrewIndex;
-                crews[bestCrewIndex].isAvailable = false;
-                crews[bestCrewIndex].lastFlightEnd = flights[i].arrivalTime;
-                
-                int flightDuration = calculateTimeDifferenceInMinutes(
-                    flights[i].departureTime, flights[i].arrivalTime);
-                crews[bestCrewIndex].dutyMinutesToday += flightDuration;
-            } else {
-              
-                flights[i].status = DELAYED;
-                flights[i].delayMinutes += 30; 
-            }
-
-        }
-    }
-}
+ static void releaseHistoryEntry(HistoryEntry *entry) {
+     if (!g_atomic_int_dec_and_test(&entry->refs)) return;
+     g_free(entry->delta);
+     g_free(entry->snapshot);
+     g_free(entry);
+ }
  
+ // Called with historyLock held.
+ static void dropHistoryEntry(HistoryEntry *entry) {
+     historyBytes -= entry->deltaSize;
+     if (entry->snapshot) historyBytes -= scheduleStateRowBytes(entry->snapshot);
+     releaseHistoryEntry(entry);
+ }
  
- void handleWeatherDelay(int delayMinutes) {
-     if (flightCount == 0) {
-         addNotification("No flights to delay", false, true);
+ static HistoryEntry* historyEntryAt(guint i) {
+     return g_ptr_array_index(scheduleHistory, i);
+ }
+ 
+ // Called with historyLock held.
+ static void pruneScheduleHistory(gint64 now) {
+     gint64 cutoff = now - (gint64)HISTORY_RETENTION_HOURS * 3600 * G_USEC_PER_SEC;
+     for (;;) {
+         guint next = 1;
+         while (next < scheduleHistory->len && !historyEntryAt(next)->snapshot) next++;
+         if (next >= scheduleHistory->len) return;
+         if (historyEntryAt(next)->time > cutoff && historyBytes <= HISTORY_MAX_BYTES) return;
+ 
+         for (guint i = 0; i < next; i++) dropHistoryEntry(historyEntryAt(i));
+         g_ptr_array_remove_range(scheduleHistory, 0, next);
+     }
+ }
+ 
+ // Called from publishScheduleState() with the write lock held.
+ static void recordScheduleHistory(const ScheduleState *next, GByteArray *delta) {
+     if (delta && delta->len == 0) return;
+ 
+     HistoryEntry *entry = g_new0(HistoryEntry, 1);
+     entry->refs = 1;
+     entry->time = g_get_real_time();
+     entry->version = next->version;
+     gsize snapshotBytes = scheduleStateRowBytes(next);
+     if (!delta || historyDeltasSinceSnapshot >= HISTORY_SNAPSHOT_INTERVAL ||
+         historyDeltaBytes + delta->len > snapshotBytes) {
+         entry->snapshot = newScheduleState(next->flightCount, next->runwayCount, next->crewCount);
+         memcpy(entry->snapshot->flights, next->flights, sizeof(Flight) * next->flightCount);
+         memcpy(entry->snapshot->runways, next->runways, sizeof(Runway) * next->runwayCount);
+         memcpy(entry->snapshot->crews, next->crews, sizeof(Crew) * next->crewCount);
+         entry->snapshot->version = next->version;
+         entry->snapshot->indexes = NULL;
+         historyDeltaBytes = 0;
+         historyDeltasSinceSnapshot = 0;
+         historyBytes += snapshotBytes;
+     } else {
+         entry->deltaSize = delta->len;
+         entry->delta = g_malloc(delta->len);
+         memcpy(entry->delta, delta->data, delta->len);
+         historyDeltaBytes += delta->len;
+         historyDeltasSinceSnapshot++;
+         historyBytes += delta->len;
+     }
+ 
+     g_mutex_lock(&historyLock);
+     if (!scheduleHistory) scheduleHistory = g_ptr_array_new();
+     g_ptr_array_add(scheduleHistory, entry);
+     if (entry->snapshot) pruneScheduleHistory(entry->time);
+     g_mutex_unlock(&historyLock);
+ }
+ 
+ // Rebuilds the schedule as it was published at the given wall-clock time
+ // (microseconds, as g_get_real_time()). The result is private to the caller,
+ // has its aggregates filled in and is released with freeScheduleState().
+ // Returns NULL when the time is older than the retained history.
+ ScheduleState* materializeScheduleAt(gint64 time) {
+     TRACE_SCOPE("materializeScheduleAt", "schedule");
+     g_mutex_lock(&historyLock);
+     if (!scheduleHistory || scheduleHistory->len == 0 || historyEntryAt(0)->time > time) {
+         g_mutex_unlock(&historyLock);
+         return NULL;
+     }
+ 
+     // Last entry published at or before the requested time.
+     guint low = 0, high = scheduleHistory->len;
+     while (high - low > 1) {
+         guint mid = low + (high - low) / 2;
+         if (historyEntryAt(mid)->time <= time) low = mid;
+         else high = mid;
+     }
+     guint base = low;
+     while (!historyEntryAt(base)->snapshot) base--;
+ 
+     // Only the snapshot and the deltas after it are taken under the lock;
+     // the references keep them alive through the replay.
+     guint replayed = low - base + 1;
+     HistoryEntry **entries = g_new(HistoryEntry *, replayed);
+     for (guint i = 0; i < replayed; i++) {
+         entries[i] = historyEntryAt(base + i);
+         g_atomic_int_inc(&entries[i]->refs);
+     }
+     g_mutex_unlock(&historyLock);
+ 
+     // Replay in place into a state sized to the full capacities, then trim
+     // the counts to what the replay produced.
+     const ScheduleState *snapshot = entries[0]->snapshot;
+     ScheduleState *state = newScheduleState(config.maxFlights, config.maxRunways, config.maxCrew);
+     memcpy(state->flights, snapshot->flights, sizeof(Flight) * snapshot->flightCount);
+     memcpy(state->runways, snapshot->runways, sizeof(Runway) * snapshot->runwayCount);
+     memcpy(state->crews, snapshot->crews, sizeof(Crew) * snapshot->crewCount);
+     ScheduleTables tables = {
+         {state->flights, state->runways, state->crews},
+         {snapshot->flightCount, snapshot->runwayCount, snapshot->crewCount},
+         {config.maxFlights, config.maxRunways, config.maxCrew}
+     };
+     for (guint i = 1; i < replayed; i++) {
+         applyScheduleDelta(&tables, entries[i]->delta, entries[i]->deltaSize, true);
+     }
+     state->version = entries[replayed - 1]->version;
+     for (guint i = 0; i < replayed; i++) releaseHistoryEntry(entries[i]);
+     g_free(entries);
+ 
+     state->flightCount = tables.count[UNDO_FLIGHTS];
+     state->runwayCount = tables.count[UNDO_RUNWAYS];
+     state->crewCount = tables.count[UNDO_CREW];
+     state->indexes = NULL;
+     state->retireEpoch = 0;
+     state->nextRetired = NULL;
+     updateScheduleAggregates(NULL, state);
+     return state;
+ }
+ 
+ void publishScheduleState() {
+     SCOPED_TIMER(METRIC_PUBLISH);
+     TRACE_SCOPE("publishScheduleState", "schedule");
+     ScheduleState *prev = g_atomic_pointer_get(&publishedState);
+     ScheduleState *next = newScheduleState(flightCount, runwayCount, crewCount);
+ 
+     next->version = prev ? prev->version + 1 : 1;
+     memcpy(next->flights, flights, sizeof(Flight) * flightCount);
+     memcpy(next->runways, runways, sizeof(Runway) * runwayCount);
+     memcpy(next->crews, crews, sizeof(Crew) * crewCount);
+     next->indexes = NULL;
+     next->retireEpoch = 0;
+     next->nextRetired = NULL;
+     updateScheduleAggregates(prev, next);
+     updateDelaySketches(prev, next);
+     GByteArray *delta = prev ? buildScheduleDelta(prev, next) : NULL;
+     recordScheduleAction(delta);
+     recordScheduleHistory(next, delta);
+     if (delta) g_byte_array_free(delta, TRUE);
+ 
+     g_atomic_pointer_set(&publishedState, next);
+     shipScheduleDelta(prev, next);
+     publishSharedSchedule(next);
+     flight_model_apply_delta(prev, next);
+     markScheduleChanged(scheduleChangeSet(prev, next));
+ 
+     if (prev) {
+         prev->retireEpoch = g_atomic_int_get(&stateEpoch);
+         prev->nextRetired = retiredStates;
+         retiredStates = prev;
+         g_atomic_int_inc(&stateEpoch);
+     }
+ 
+     reclaimRetiredStates();
+ }
+ 
+ void reclaimRetiredStates() {
+     gint oldestPinned = G_MAXINT;
+     for (int i = 0; i < MAX_STATE_READERS; i++) {
+         gint epoch = g_atomic_int_get(&stateReaders[i].pinnedEpoch);
+         if (epoch != 0 && epoch < oldestPinned) {
+             oldestPinned = epoch;
+         }
+     }
+ 
+     ScheduleState **link = &retiredStates;
+     while (*link) {
+         ScheduleState *state = *link;
+         if (state->retireEpoch < oldestPinned) {
+             *link = state->nextRetired;
+             freeScheduleState(state);
+         } else {
+             link = &state->nextRetired;
+         }
+     }
+ }
+ 
+ int registerStateReader() {
+     for (int i = 0; i < MAX_STATE_READERS; i++) {
+         if (g_atomic_int_compare_and_exchange(&stateReaders[i].inUse, 0, 1)) {
+             g_atomic_int_set(&stateReaders[i].pinnedEpoch, 0);
+             return i;
+         }
+     }
+     return -1;
+ }
+ 
+ void unregisterStateReader(int slot) {
+     if (slot < 0 || slot >= MAX_STATE_READERS) return;
+     g_atomic_int_set(&stateReaders[slot].pinnedEpoch, 0);
+     g_atomic_int_set(&stateReaders[slot].inUse, 0);
+ }
+ 
+ const ScheduleState* pinScheduleState(int slot) {
+     g_atomic_int_set(&stateReaders[slot].pinnedEpoch, g_atomic_int_get(&stateEpoch));
+     return g_atomic_pointer_get(&publishedState);
+ }
+ 
+ void unpinScheduleState(int slot) {
+     g_atomic_int_set(&stateReaders[slot].pinnedEpoch, 0);
+ }
+ 
+ // Read-only schedule for viewer processes. The planner process copies each
+ // published version into a POSIX shared-memory segment guarded by a seqlock:
+ // the sequence is odd while a copy is in progress, so readers map the segment,
+ // read in place and retry if the sequence moved underneath them. The rows
+ // follow the header, laid out for the capacities recorded in it. A planner
+ // that exits clears the magic and unlinks the segment, so viewers can tell a
+ // stopped planner from a quiet one.
+ static gsize sharedScheduleSize(int flightCapacity, int runwayCapacity, int crewCapacity) {
+     return sizeof(SharedSchedule) + sizeof(Flight) * flightCapacity + sizeof(Runway) * runwayCapacity +
+            sizeof(Crew) * crewCapacity;
+ }
+ 
+ Flight* sharedScheduleFlights(const SharedSchedule *segment) {
+     return (Flight *)(segment + 1);
+ }
+ 
+ Runway* sharedScheduleRunways(const SharedSchedule *segment) {
+     return (Runway *)(sharedScheduleFlights(segment) + segment->flightCapacity);
+ }
+ 
+ Crew* sharedScheduleCrew(const SharedSchedule *segment) {
+     return (Crew *)(sharedScheduleRunways(segment) + segment->runwayCapacity);
+ }
+ 
+ // Opens the segment and takes the owner's flock on it. Fails if a live
+ // planner already owns it; the lock goes away with a planner that died.
+ static int openOwnedSharedSchedule(int flags) {
+     int fd = shm_open(SHARED_SCHEDULE_NAME, flags | O_RDWR, 0644);
+     if (fd < 0) return -1;
+     if (flock(fd, LOCK_EX | LOCK_NB) < 0) {
+         close(fd);
+         return -1;
+     }
+     return fd;
+ }
+ 
+ // Called with the owner's lock held, so the segment was left by a planner
+ // that is gone. It is reused only if it was laid out for the same
+ // capacities. Viewers map it at the size its header gave them, so it is never
+ // resized in place: a mismatched one has its magic cleared, which sends
+ // viewers off to remap, and is unlinked so a fresh one can be created.
+ static bool sharedScheduleReusable(int fd) {
+     struct stat info;
+     if (fstat(fd, &info) < 0) return false;
+     if (info.st_size == 0) return true;
+     if (info.st_size < (off_t)sizeof(SharedSchedule)) return false;
+ 
+     void *mapping = mmap(NULL, sizeof(SharedSchedule), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+     if (mapping == MAP_FAILED) return false;
+     SharedSchedule *header = mapping;
+     bool matches = header->magic == SHARED_SCHEDULE_MAGIC && header->flightCapacity == config.maxFlights &&
+                    header->runwayCapacity == config.maxRunways && header->crewCapacity == config.maxCrew &&
+                    info.st_size == (off_t)sharedScheduleSize(config.maxFlights, config.maxRunways, config.maxCrew);
+     if (!matches) header->magic = 0;
+     munmap(mapping, sizeof(SharedSchedule));
+     return matches;
+ }
+ 
+ // Only the replication leader publishes. It holds an exclusive flock on the
+ // segment until it exits, so no other planner can reset, overwrite, retire or
+ // unlink a segment that is in use; a segment it does not own is never touched.
+ bool createSharedSchedule() {
+     int fd = openOwnedSharedSchedule(O_CREAT);
+     if (fd >= 0 && !sharedScheduleReusable(fd)) {
+         shm_unlink(SHARED_SCHEDULE_NAME);
+         close(fd);
+         fd = openOwnedSharedSchedule(O_CREAT | O_EXCL);
+     }
+     if (fd < 0) {
+         addNotification("Shared schedule disabled: " SHARED_SCHEDULE_NAME " is owned by another planner or cannot be opened",
+                         true, true);
+         return false;
+     }
+ 
+     gsize size = sharedScheduleSize(config.maxFlights, config.maxRunways, config.maxCrew);
+     void *mapping = ftruncate(fd, size) == 0 ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                                              : MAP_FAILED;
+     if (mapping == MAP_FAILED) {
+         close(fd);
+         return false;
+     }
+ 
+     g_mutex_lock(&stateWriteLock);
+     sharedSchedule = mapping;
+     sharedScheduleFd = fd;
+     // A planner that died in the middle of a copy left the sequence odd.
+     g_atomic_int_set(&sharedSchedule->sequence, 0);
+     sharedSchedule->flightCapacity = config.maxFlights;
+     sharedSchedule->runwayCapacity = config.maxRunways;
+     sharedSchedule->crewCapacity = config.maxCrew;
+     sharedSchedule->magic = SHARED_SCHEDULE_MAGIC;
+     publishSharedSchedule(g_atomic_pointer_get(&publishedState));
+     g_mutex_unlock(&stateWriteLock);
+     return true;
+ }
+ 
+ void destroySharedSchedule() {
+     g_mutex_lock(&stateWriteLock);
+     SharedSchedule *segment = sharedSchedule;
+     sharedSchedule = NULL;
+     g_mutex_unlock(&stateWriteLock);
+     if (!segment) return;
+ 
+     segment->magic = 0;
+     unmapSharedSchedule(segment);
+     shm_unlink(SHARED_SCHEDULE_NAME);
+     close(sharedScheduleFd);
+     sharedScheduleFd = -1;
+ }
+ 
+ void publishSharedSchedule(const ScheduleState *state) {
+     if (!sharedSchedule || !state) return;
+ 
+     g_atomic_int_inc(&sharedSchedule->sequence);
+     sharedSchedule->version = state->version;
+     sharedSchedule->flightCount = state->flightCount;
+     sharedSchedule->runwayCount = state->runwayCount;
+     sharedSchedule->crewCount = state->crewCount;
+     memcpy(sharedScheduleFlights(sharedSchedule), state->flights, sizeof(Flight) * state->flightCount);
+     memcpy(sharedScheduleRunways(sharedSchedule), state->runways, sizeof(Runway) * state->runwayCount);
+     memcpy(sharedScheduleCrew(sharedSchedule), state->crews, sizeof(Crew) * state->crewCount);
+     g_atomic_int_inc(&sharedSchedule->sequence);
+ }
+ 
+ const SharedSchedule* mapSharedSchedule() {
+     int fd = shm_open(SHARED_SCHEDULE_NAME, O_RDONLY, 0);
+     if (fd < 0) return NULL;
+ 
+     void *mapping = mmap(NULL, sizeof(SharedSchedule), PROT_READ, MAP_SHARED, fd, 0);
+     if (mapping == MAP_FAILED) {
+         close(fd);
+         return NULL;
+     }
+ 
+     // Map the header first to learn the planner's capacities, then the rows.
+     const SharedSchedule *header = mapping;
+     bool valid = header->magic == SHARED_SCHEDULE_MAGIC;
+     gsize size = valid ? sharedScheduleSize(header->flightCapacity, header->runwayCapacity, header->crewCapacity) : 0;
+     munmap(mapping, sizeof(SharedSchedule));
+     if (!valid) {
+         close(fd);
+         return NULL;
+     }
+ 
+     mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+     close(fd);
+     return mapping == MAP_FAILED ? NULL : mapping;
+ }
+ 
+ void unmapSharedSchedule(const SharedSchedule *segment) {
+     munmap((void *)segment, sharedScheduleSize(segment->flightCapacity, segment->runwayCapacity,
+                                                segment->crewCapacity));
+ }
+ 
+ // Gives up after SHARED_SCHEDULE_READ_SPINS yields, so a writer that died
+ // with the sequence odd cannot hang the caller.
+ bool sharedScheduleReadBegin(const SharedSchedule *segment, gint *start) {
+     for (int spin = 0; spin < SHARED_SCHEDULE_READ_SPINS; spin++) {
+         *start = g_atomic_int_get(&segment->sequence);
+         if (!(*start & 1)) return true;
+         g_thread_yield();
+     }
+     return false;
+ }
+ 
+ bool sharedScheduleReadRetry(const SharedSchedule *segment, gint start) {
+     return g_atomic_int_get(&segment->sequence) != start;
+ }
+ 
+ // Replication. Every commit is shipped as a mutation log of the rows that
+ // changed since the previous version, followed by a REPL_COMMIT marker, to
+ // any follower connected on the local socket. A follower keeps the replica in
+ // its own globals and takes over as leader as soon as the stream drops or
+ // the leader has been silent for REPLICATION_TIMEOUT_MS.
+ //
+ // The sender thread owns every follower connection. Each follower has its
+ // own outgoing buffer, drained with non-blocking sends, so a slow follower
+ // never holds up the others or the commit path. A follower that lets its
+ // buffer grow past REPLICATION_BUFFER_LIMIT stops receiving batches until
+ // the buffer drains and then gets a fresh snapshot; so does every follower
+ // when more than REPLICATION_QUEUE_LIMIT batches are waiting for the
+ // sender. Idle followers get a heartbeat every REPLICATION_HEARTBEAT_MS.
+ static ReplicationRecord* appendReplicationRecord(ReplicationBatch *batch,
+                                                   ReplicationRecordType type,
+                                                   int index, guint64 version) {
+     ReplicationRecord *record = &batch->records[batch->count++];
+     memset(record, 0, sizeof(ReplicationRecord));
+     record->type = type;
+     record->index = index;
+     record->version = version;
+     record->leaderTime = g_get_real_time();
+     return record;
+ }
+ 
+ static ReplicationBatch* buildReplicationBatch(const ScheduleState *prev, const ScheduleState *next) {
+     ReplicationBatch *batch = g_new(ReplicationBatch, 1);
+     batch->count = 0;
+     batch->records = g_new(ReplicationRecord,
+                            next->flightCount + next->runwayCount + next->crewCount + 2);
+ 
+     if (!prev || prev->flightCount != next->flightCount ||
+         prev->runwayCount != next->runwayCount || prev->crewCount != next->crewCount) {
+         ReplicationRecord *record = appendReplicationRecord(batch, REPL_COUNTS, 0, next->version);
+         record->body.counts.flightCount = next->flightCount;
+         record->body.counts.runwayCount = next->runwayCount;
+         record->body.counts.crewCount = next->crewCount;
+     }
+ 
+     for (int i = 0; i < next->flightCount; i++) {
+         if (!prev || i >= prev->flightCount ||
+             memcmp(&prev->flights[i], &next->flights[i], sizeof(Flight)) != 0) {
+             appendReplicationRecord(batch, REPL_FLIGHT, i, next->version)->body.flight = next->flights[i];
+         }
+     }
+     for (int i = 0; i < next->runwayCount; i++) {
+         if (!prev || i >= prev->runwayCount ||
+             memcmp(&prev->runways[i], &next->runways[i], sizeof(Runway)) != 0) {
+             appendReplicationRecord(batch, REPL_RUNWAY, i, next->version)->body.runway = next->runways[i];
+         }
+     }
+     for (int i = 0; i < next->crewCount; i++) {
+         if (!prev || i >= prev->crewCount ||
+             memcmp(&prev->crews[i], &next->crews[i], sizeof(Crew)) != 0) {
+             appendReplicationRecord(batch, REPL_CREW, i, next->version)->body.crew = next->crews[i];
+         }
+     }
+ 
+     appendReplicationRecord(batch, REPL_COMMIT, 0, next->version);
+     return batch;
+ }
+ 
+ static void freeReplicationBatch(ReplicationBatch *batch) {
+     g_free(batch->records);
+     g_free(batch);
+ }
+ 
+ static bool readFully(int fd, void *buffer, size_t length) {
+     char *p = buffer;
+     while (length > 0) {
+         ssize_t got = read(fd, p, length);
+         if (got < 0 && errno == EINTR) continue;
+         if (got <= 0) return false;
+         p += got;
+         length -= got;
+     }
+     return true;
+ }
+ 
+ // Batches are only queued while a follower is connected; one that joins
+ // afterwards starts from a snapshot pinned after it was counted.
+ void shipScheduleDelta(const ScheduleState *prev, const ScheduleState *next) {
+     if (!replicationQueue || g_atomic_int_get(&replicaFollowerCount) == 0) return;
+     if (g_async_queue_length(replicationQueue) >= REPLICATION_QUEUE_LIMIT) {
+         g_atomic_int_set(&replicaResyncPending, 1);
+         return;
+     }
+     g_async_queue_push(replicationQueue, buildReplicationBatch(prev, next));
+ }
+ 
+ static void queueReplicaRecords(ReplicaFollower *follower, const ReplicationRecord *records, int count) {
+     g_byte_array_append(follower->pending, (const guint8 *)records, sizeof(ReplicationRecord) * count);
+ }
+ 
+ static void dropReplicaFollower(ReplicaFollower *followers, int *count, int i) {
+     close(followers[i].fd);
+     g_byte_array_free(followers[i].pending, TRUE);
+     followers[i] = followers[*count - 1];
+     (*count)--;
+     g_atomic_int_add(&replicaFollowerCount, -1);
+ }
+ 
+ // Sends what the socket takes without blocking. Returns false once the
+ // follower has gone away or has taken nothing for REPLICATION_TIMEOUT_MS.
+ static bool flushReplicaFollower(ReplicaFollower *follower, gint64 now) {
+     while (follower->sent < follower->pending->len) {
+         ssize_t written = send(follower->fd, follower->pending->data + follower->sent,
+                                follower->pending->len - follower->sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+         if (written < 0 && errno == EINTR) continue;
+         if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+         if (written <= 0) return false;
+         follower->sent += written;
+         follower->lastProgress = now;
+     }
+     if (follower->sent == follower->pending->len) {
+         g_byte_array_set_size(follower->pending, 0);
+         follower->sent = 0;
+         follower->lastProgress = now;
+         return true;
+     }
+     return now - follower->lastProgress < REPLICATION_TIMEOUT_MS * 1000;
+ }
+ 
+ static gpointer replicationSenderThread(gpointer data) {
+     traceThreadName("replication-send");
+     int readerSlot = registerStateReader();
+     ReplicaFollower followers[MAX_REPLICA_FOLLOWERS];
+     int count = 0;
+     gint64 lastHeartbeat = g_get_monotonic_time();
+     bool backlog = false;
+ 
+     while (true) {
+         guint64 wait = (backlog ? REPLICATION_FLUSH_MS : REPLICATION_HEARTBEAT_MS) * 1000;
+         ReplicationBatch *batch = g_async_queue_timeout_pop(replicationQueue, wait);
+         TRACE_SCOPE("replicationSend", "worker");
+         gint64 now = g_get_monotonic_time();
+ 
+         gpointer joined;
+         while ((joined = g_async_queue_try_pop(replicaJoinQueue)) != NULL) {
+             ReplicaFollower *follower = &followers[count++];
+             follower->fd = GPOINTER_TO_INT(joined) - 1;
+             follower->pending = g_byte_array_new();
+             follower->sent = 0;
+             follower->needsSnapshot = true;
+             follower->stalled = false;
+             follower->lastProgress = now;
+         }
+         if (g_atomic_int_compare_and_exchange(&replicaResyncPending, 1, 0)) {
+             for (int i = 0; i < count; i++) followers[i].stalled = true;
+         }
+ 
+         // A stalled follower resumes from a snapshot once its buffer has
+         // drained; queued batches at or below the snapshot version are
+         // skipped by the follower.
+         ReplicationBatch *snapshot = NULL;
+         for (int i = 0; i < count; i++) {
+             ReplicaFollower *follower = &followers[i];
+             if (follower->stalled && follower->pending->len == 0) {
+                 follower->stalled = false;
+                 follower->needsSnapshot = true;
+             }
+             if (!follower->needsSnapshot || readerSlot < 0) continue;
+             if (!snapshot) {
+                 snapshot = buildReplicationBatch(NULL, pinScheduleState(readerSlot));
+                 unpinScheduleState(readerSlot);
+             }
+             queueReplicaRecords(follower, snapshot->records, snapshot->count);
+             follower->needsSnapshot = false;
+         }
+         if (snapshot) freeReplicationBatch(snapshot);
+ 
+         if (batch) {
+             for (int i = 0; i < count; i++) {
+                 ReplicaFollower *follower = &followers[i];
+                 if (follower->stalled) continue;
+                 if (follower->pending->len + sizeof(ReplicationRecord) * batch->count > REPLICATION_BUFFER_LIMIT) {
+                     follower->stalled = true;
+                     continue;
+                 }
+                 queueReplicaRecords(follower, batch->records, batch->count);
+             }
+             replicationShippedRecords += batch->count;
+             freeReplicationBatch(batch);
+         }
+ 
+         if (now - lastHeartbeat >= REPLICATION_HEARTBEAT_MS * 1000) {
+             ReplicationRecord heartbeat;
+             memset(&heartbeat, 0, sizeof(heartbeat));
+             heartbeat.type = REPL_HEARTBEAT;
+             heartbeat.leaderTime = g_get_real_time();
+             for (int i = 0; i < count; i++) {
+                 if (followers[i].pending->len == 0) queueReplicaRecords(&followers[i], &heartbeat, 1);
+             }
+             lastHeartbeat = now;
+         }
+ 
+         backlog = false;
+         for (int i = 0; i < count; ) {
+             if (!flushReplicaFollower(&followers[i], now)) {
+                 dropReplicaFollower(followers, &count, i);
+                 continue;
+             }
+             if (followers[i].pending->len > 0) backlog = true;
+             i++;
+         }
+     }
+     return NULL;
+ }
+ 
+ // Connections are handed to the sender, which sends the snapshot. The
+ // follower is counted first, so every commit published from then on is
+ // queued and none can fall between the snapshot and the stream.
+ static gpointer replicationAcceptThread(gpointer data) {
+     while (true) {
+         int fd = accept(replicationListenFd, NULL, NULL);
+         if (fd < 0) {
+             if (errno == EINTR) continue;
+             break;
+         }
+         if (g_atomic_int_add(&replicaFollowerCount, 1) >= MAX_REPLICA_FOLLOWERS) {
+             g_atomic_int_add(&replicaFollowerCount, -1);
+             close(fd);
+             continue;
+         }
+         g_async_queue_push(replicaJoinQueue, GINT_TO_POINTER(fd + 1));
+     }
+     return NULL;
+ }
+ 
+  bool startReplicationLeader(const char *socketPath) {
+     struct sockaddr_un addr;
+     memset(&addr, 0, sizeof(addr));
+     addr.sun_family = AF_UNIX;
+     strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+ 
+     int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+     if (fd < 0) return false;
+ 
+     // Only a stale socket left by a dead leader may be replaced; if a live
+     // leader answers, this instance must not become a second one.
+     if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+         close(fd);
+         addNotification("Replication disabled: another leader is already running", true, false);
+         return false;
+     }
+     close(fd);
+     fd = socket(AF_UNIX, SOCK_STREAM, 0);
+     if (fd < 0) return false;
+ 
+     unlink(socketPath);
+     if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, MAX_REPLICA_FOLLOWERS) < 0) {
+         close(fd);
+         addNotification("Replication disabled: cannot open local socket", true, false);
+         return false;
+     }
+ 
+     replicationListenFd = fd;
+     replicationQueue = g_async_queue_new();
+     replicaJoinQueue = g_async_queue_new();
+     g_thread_unref(g_thread_new("replication-accept", replicationAcceptThread, NULL));
+     g_thread_unref(g_thread_new("replication-send", replicationSenderThread, NULL));
+     return true;
+ }
+ 
+ static void writeReplicationMetrics(guint64 appliedVersion, gint64 lagMicros,
+                                     double recordsPerSecond, guint64 appliedRecords) {
+     FILE *file = fopen(FILENAME_REPLICATION_METRICS, "w");
+     if (!file) return;
+     fprintf(file, "fms_replication_applied_version %" G_GUINT64_FORMAT "\n", appliedVersion);
+     fprintf(file, "fms_replication_lag_ms %.3f\n", lagMicros / 1000.0);
+     fprintf(file, "fms_replication_apply_records_per_second %.1f\n", recordsPerSecond);
+     fprintf(file, "fms_replication_applied_records_total %" G_GUINT64_FORMAT "\n", appliedRecords);
+     fclose(file);
+ }
+ 
+ // Runs the follower loop on the calling thread until the leader's stream
+ // ends. Returns true once a replica was received, meaning the caller now
+ // holds the latest committed state and should take over.
+ bool runReplicationFollower(const char *socketPath) {
+     struct sockaddr_un addr;
+     memset(&addr, 0, sizeof(addr));
+     addr.sun_family = AF_UNIX;
+     strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+ 
+     // With no leader to follow after REPLICATION_TIMEOUT_MS, the caller
+     // starts from the data files instead.
+     int fd = -1;
+     gint64 deadline = g_get_monotonic_time() + REPLICATION_TIMEOUT_MS * 1000;
+     while (fd < 0) {
+         fd = socket(AF_UNIX, SOCK_STREAM, 0);
+         if (fd < 0) return false;
+         if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+             close(fd);
+             fd = -1;
+             if (g_get_monotonic_time() >= deadline) {
+                 addNotification("No replication leader found; starting from the data files", true, false);
+                 return false;
+             }
+             g_usleep(REPLICATION_HEARTBEAT_MS * 1000);
+         }
+     }
+     // A leader that stops sending, heartbeats included, counts as gone.
+     struct timeval timeout = {REPLICATION_TIMEOUT_MS / 1000, (REPLICATION_TIMEOUT_MS % 1000) * 1000};
+     setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+     char msg[STR_LEN*2];
+     snprintf(msg, sizeof(msg), "Following leader on %s", socketPath);
+     addNotification(msg, false, false);
+ 
+     ReplicationRecord record;
+     guint64 appliedVersion = 0;
+     guint64 appliedRecords = 0;
+     guint64 windowRecords = 0;
+     gint64 windowStart = g_get_monotonic_time();
+     gint64 lagMicros = 0;
+     int pendingFlights = flightCount, pendingRunways = runwayCount, pendingCrew = crewCount;
+ 
+     while (readFully(fd, &record, sizeof(record))) {
+         if (record.type == REPL_HEARTBEAT) {
+             lagMicros = g_get_real_time() - record.leaderTime;
+             continue;
+         }
+         if (record.version <= appliedVersion) continue;
+ 
+         switch (record.type) {
+             case REPL_COUNTS:
+                 pendingFlights = CLAMP(record.body.counts.flightCount, 0, config.maxFlights);
+                 pendingRunways = CLAMP(record.body.counts.runwayCount, 0, config.maxRunways);
+                 pendingCrew = CLAMP(record.body.counts.crewCount, 0, config.maxCrew);
+                 break;
+             case REPL_FLIGHT:
+                 if (record.index < config.maxFlights) flights[record.index] = record.body.flight;
+                 break;
+             case REPL_RUNWAY:
+                 if (record.index < config.maxRunways) runways[record.index] = record.body.runway;
+                 break;
+             case REPL_CREW:
+                 if (record.index < config.maxCrew) crews[record.index] = record.body.crew;
+                 break;
+             case REPL_COMMIT:
+                 flightCount = pendingFlights;
+                 runwayCount = pendingRunways;
+                 crewCount = pendingCrew;
+                 appliedVersion = record.version;
+                 lagMicros = g_get_real_time() - record.leaderTime;
+                 break;
+             case REPL_HEARTBEAT:
+                 break;
+         }
+         appliedRecords++;
+         windowRecords++;
+ 
+         gint64 now = g_get_monotonic_time();
+         if (now - windowStart >= G_USEC_PER_SEC) {
+             writeReplicationMetrics(appliedVersion, lagMicros,
+                                     windowRecords * (double)G_USEC_PER_SEC / (now - windowStart),
+                                     appliedRecords);
+             windowRecords = 0;
+             windowStart = now;
+         }
+     }
+ 
+     close(fd);
+     invalidateSearchIndex();
+     writeReplicationMetrics(appliedVersion, lagMicros, 0.0, appliedRecords);
+     printf("Leader stream ended at version %" G_GUINT64_FORMAT ", taking over\n", appliedVersion);
+     return appliedVersion > 0;
+ }
+ 
+ 
+ void addFlight() {
+     if (flightCount >= config.maxFlights) {
+         addNotification("Failed to add flight: Maximum limit reached", false, true);
+         return;
+     }
+     
+
+     const char *flightID = gtk_entry_get_text(GTK_ENTRY(flight_id_entry));
+     const char *origin = gtk_entry_get_text(GTK_ENTRY(origin_entry));
+     const char *destination = gtk_entry_get_text(GTK_ENTRY(destination_entry));
+const char *aircraftType = NULL;
+GtkTreeIter aircraft_iter;
+if (gtk_combo_box_get_active_iter(GTK_COMBO_BOX(aircraft_entry), &aircraft_iter)) {
+    GtkTreeModel *model = gtk_combo_box_get_model(GTK_COMBO_BOX(aircraft_entry));
+    gtk_tree_model_get(model, &aircraft_iter, 0, &aircraftType, -1);
+}
+if (aircraftType == NULL) {
+    addNotification("Please select an aircraft type", false, true);
+    return;
+}
+     
+     int dep_hour = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(dep_hour_spin));
+     int dep_min = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(dep_min_spin));
+     int duration = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(duration_spin));
+     
+     gint priority_index = gtk_combo_box_get_active(GTK_COMBO_BOX(priority_combo_text));
+     
+     bool isCargo = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(cargo_check));
+     
+     if (strlen(flightID) == 0 || strlen(origin) == 0 || strlen(destination) == 0 || strlen(aircraftType) == 0) {
+         addNotification("Please fill in all flight details", false, true);
+         return;
+     }
+     
+     if (!validateFlightID((char*)flightID)) {
+         addNotification("Flight ID already exists", false, true);
+         return;
+     }
+     
+     Flight newFlight;
+     strncpy(newFlight.flightID, flightID, STR_LEN - 1);
+     strncpy(newFlight.origin, origin, STR_LEN - 1);
+     strncpy(newFlight.destination, destination, STR_LEN - 1);
+     strncpy(newFlight.aircraftType, aircraftType, STR_LEN - 1);
+     
+     newFlight.departureTime.hour = dep_hour;
+     newFlight.departureTime.minute = dep_min;
+     newFlight.arrivalTime = addMinutesToTime(newFlight.departureTime, duration);
+     newFlight.scheduledDeparture = newFlight.departureTime;
+     newFlight.priority = (FlightPriority)(priority_index + 1);
+     newFlight.status = SCHEDULED;
+     newFlight.runwayAssigned = -1;
+     newFlight.crewAssigned = -1;
+     newFlight.delayMinutes = 0;
+     newFlight.isCargo = isCargo;
+     bool nextDay = assignOperatingDay(&newFlight);
+     
+     flights[flightCount] = newFlight;
+     flightCount++;
+     indexFlight(flightCount - 1);
+     flight_model_row_inserted(flightCount - 1);
+     
+     char msg[STR_LEN*2];
+     if (nextDay) {
+         sprintf(msg, "Flight %s added for tomorrow: it would already have landed today", newFlight.flightID);
+     } else {
+         sprintf(msg, "Flight %s added successfully", newFlight.flightID);
+     }
+     addNotification(msg, false, false);
+     
+     gtk_entry_set_text(GTK_ENTRY(flight_id_entry), "");
+     gtk_entry_set_text(GTK_ENTRY(origin_entry), "");
+     gtk_entry_set_text(GTK_ENTRY(destination_entry), "");
+     gtk_entry_set_text(GTK_ENTRY(aircraft_entry), "");
+     gtk_spin_button_set_value(GTK_SPIN_BUTTON(dep_hour_spin), 0);
+     gtk_spin_button_set_value(GTK_SPIN_BUTTON(dep_min_spin), 0);
+     gtk_spin_button_set_value(GTK_SPIN_BUTTON(duration_spin), 0);
+     gtk_combo_box_set_active(GTK_COMBO_BOX(priority_combo_text), 0);
+     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(cargo_check), FALSE);
+ }
+ 
+ void modifyFlight() {
+     if (selectedFlightIndex == -1 || selectedFlightIndex >= flightCount) {
+         addNotification("No flight selected for modification", false, true);
+         return;
+     }
+
+     int delayMinutes = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(delay_spin));
+     
+     if (delayMinutes <= 0) {
+         addNotification("Please enter a valid delay time", false, true);
+         return;
+     }
+     
+     flights[selectedFlightIndex].departureTime = 
+         addMinutesToTime(flights[selectedFlightIndex].departureTime, delayMinutes);
+     flights[selectedFlightIndex].arrivalTime = 
+         addMinutesToTime(flights[selectedFlightIndex].arrivalTime, delayMinutes);
+     flights[selectedFlightIndex].delayMinutes += delayMinutes;
+     flights[selectedFlightIndex].status = DELAYED;
+     requestHostedDelay(&flights[selectedFlightIndex], delayMinutes);
+     
+     char msg[STR_LEN*2];
+     sprintf(msg, "Flight %s delayed by %d minutes", flights[selectedFlightIndex].flightID, delayMinutes);
+     addNotification(msg, false, false);
+     
+     gtk_spin_button_set_value(GTK_SPIN_BUTTON(delay_spin), 0);
+ }
+ 
+ void deleteFlight() {
+     if (selectedFlightIndex == -1 || selectedFlightIndex >= flightCount) {
+         addNotification("No flight selected for deletion", false, true);
+         return;
+     }
+     
+     char flightID[STR_LEN];
+     strcpy(flightID, flights[selectedFlightIndex].flightID);
+     unindexFlight(selectedFlightIndex);
+     
+     for (int i = selectedFlightIndex; i < flightCount - 1; i++) {
+         flights[i] = flights[i + 1];
+     }
+     flightCount--;
+     flight_model_row_deleted(selectedFlightIndex);
+     selectedFlightIndex = -1;
+     
+     char msg[STR_LEN*2];
+     sprintf(msg, "Flight %s deleted", flightID);
+     addNotification(msg, false, false);
+ }
+ 
+ bool validateFlightID(char* flightID) {
+     for (int i = 0; i < flightCount; i++) {
+         if (strcmp(flights[i].flightID, flightID) == 0) {
+             return false;
+         }
+     }
+     return true;
+ }
+ 
+ 
+ // Scratch arenas. Each thread owns one bump-pointer arena for planning
+ // scratch (candidate lists, score tables, formatted strings). ARENA_PASS
+ // marks the arena and rolls it back when the pass returns, so nothing in a
+ // pass is freed individually. An arena that had to grow during a pass is
+ // coalesced into one larger block when its outermost pass ends, so steady
+ // state passes never call malloc.
+ static void freeArena(gpointer data);
+ 
+ GPrivate arenaKey = G_PRIVATE_INIT(freeArena);
+ gsize arenaHighWaterBytes = 0;
+ gsize arenaReservedBytes = 0;
+ 
+ static ArenaBlock* newArenaBlock(gsize size, ArenaBlock *previous) {
+     ArenaBlock *block = g_malloc(sizeof(ArenaBlock) + size);
+     block->previous = previous;
+     block->size = size;
+     block->used = 0;
+     g_atomic_pointer_add(&arenaReservedBytes, (gssize)size);
+     METRIC_ADD(COUNTER_ARENA_BLOCKS, 1);
+     return block;
+ }
+ 
+ static void freeArenaBlock(ArenaBlock *block) {
+     g_atomic_pointer_add(&arenaReservedBytes, -(gssize)block->size);
+     g_free(block);
+ }
+ 
+ static void freeArena(gpointer data) {
+     Arena *arena = data;
+     while (arena->block) {
+         ArenaBlock *previous = arena->block->previous;
+         freeArenaBlock(arena->block);
+         arena->block = previous;
+     }
+     g_free(arena);
+ }
+ 
+ Arena* threadArena() {
+     Arena *arena = g_private_get(&arenaKey);
+     if (!arena) {
+         arena = g_new0(Arena, 1);
+         g_private_set(&arenaKey, arena);
+     }
+     return arena;
+ }
+ 
+ void* arenaAlloc(Arena *arena, gsize size) {
+     size = (size + ARENA_ALIGN - 1) & ~(gsize)(ARENA_ALIGN - 1);
+     ArenaBlock *block = arena->block;
+     if (!block || block->size - block->used < size) {
+         gsize blockSize = MAX(block ? block->size * 2 : ARENA_BLOCK_SIZE, size);
+         block = arena->block = newArenaBlock(blockSize, block);
+     }
+     void *memory = block->data + block->used;
+     block->used += size;
+     arena->inUse += size;
+     arena->highWater = MAX(arena->highWater, arena->inUse);
+     return memory;
+ }
+ 
+ ArenaMark arenaMark(Arena *arena) {
+     ArenaMark mark = {arena, arena->block, arena->block ? arena->block->used : 0, arena->inUse};
+     arena->depth++;
+     return mark;
+ }
+ 
+ void arenaRelease(ArenaMark *mark) {
+     Arena *arena = mark->arena;
+     gsize grown = 0;
+     while (arena->block != mark->block) {
+         ArenaBlock *previous = arena->block->previous;
+         grown += arena->block->size;
+         freeArenaBlock(arena->block);
+         arena->block = previous;
+     }
+     if (arena->block) arena->block->used = mark->used;
+     arena->inUse = mark->inUse;
+ 
+     if (--arena->depth == 0) {
+         if (grown > 0) {
+             gsize size = grown + (arena->block ? arena->block->size : 0);
+             if (arena->block) freeArenaBlock(arena->block);
+             arena->block = newArenaBlock(size, NULL);
+         }
+         gsize peak = (gsize)g_atomic_pointer_get(&arenaHighWaterBytes);
+         while (arena->highWater > peak &&
+                !g_atomic_pointer_compare_and_exchange(&arenaHighWaterBytes, peak, arena->highWater)) {
+             peak = (gsize)g_atomic_pointer_get(&arenaHighWaterBytes);
+         }
+     }
+ }
+ 
+ // The reference planners take their rule constants as parameters and are
+ // always inlined, so each entry point below compiles two instances: one with
+ // the built-in defaults folded in as literals and one reading the loaded
+ // configuration once per pass.
+ static inline __attribute__((always_inline))
+ void assignRunwaysWith(Flight *flightSet, int nFlights, Runway *runwaySet, int nRunways, int bufferTime) {
+    gsize evaluated = 0;
+    for (int i = 0; i < nFlights; i++) {
+        if (flightSet[i].runwayAssigned == -1 && flightSet[i].status != CANCELLED) {
+           
+            for (int r = 0; r < nRunways; r++) {
+                evaluated++;
+                bool isCompatible = false;
+                
+                if (runwaySet[r].isAvailable) {
+                    switch(runwaySet[r].type) {
+                        case ALL_FLIGHTS:
+                            isCompatible = true;
+                            break;
+                        case INTERNATIONAL_ONLY:
+                            isCompatible = (flightSet[i].priority == INTERNATIONAL);
+                            break;
+                        case CARGO_ONLY:
+                            isCompatible = flightSet[i].isCargo;
+                            break;
+                    }
+                }
+                
+           
+                if (isCompatible && (compareTime(flightSet[i].departureTime, 
+                                     runwaySet[r].nextAvailableTime) >= 0)) {
+                   
+                    flightSet[i].runwayAssigned = r;
+                    runwaySet[r].isAvailable = false;
+                    runwaySet[r].nextAvailableTime = 
+                        addMinutesToTime(flightSet[i].arrivalTime, bufferTime);
+                    break; 
+                }
+            }
+            
+           
+            if (flightSet[i].runwayAssigned == -1) {
+                flightSet[i].status = DELAYED;
+                flightSet[i].delayMinutes += 15; 
+            }
+        }
+    }
+    METRIC_ADD(COUNTER_RUNWAY_CANDIDATES, evaluated);
+}
+ 
+ void assignRunwaysFor(Flight *flightSet, int nFlights, Runway *runwaySet, int nRunways) {
+     SCOPED_TIMER(METRIC_ASSIGN_RUNWAYS);
+     TRACE_SCOPE("assignRunways", "planning");
+     ARENA_PASS(arena);
+     if (config.bufferTime == DEFAULT_BUFFER_TIME) {
+         assignRunwaysWith(flightSet, nFlights, runwaySet, nRunways, DEFAULT_BUFFER_TIME);
+     } else {
+         assignRunwaysWith(flightSet, nFlights, runwaySet, nRunways, config.bufferTime);
+     }
+ }
+ 
+ 
+static inline __attribute__((always_inline))
+void scheduleCrewWith(Flight *flightSet, int nFlights, Crew *crewSet, int nCrew, int maxDutyTime, int minRestTime) {
+    ARENA_PASS(arena);
+    gsize evaluated = 0;
+
+    // ",qualifications," for each crew member, formatted once per pass.
+    char *qualStrs = arenaAlloc(arena, (gsize)MAX(nCrew, 1) * STR_LEN * 2);
+    for (int c = 0; c < nCrew; c++) {
+        snprintf(&qualStrs[(gsize)c * STR_LEN * 2], STR_LEN * 2, ",%s,", crewSet[c].qualifications);
+    }
+
+    for (int i = 0; i < nFlights; i++) {
+        if (flightSet[i].crewAssigned == -1 && flightSet[i].status != CANCELLED) {
+           
+            int bestCrewIndex = -1;
+            int bestScore = -1;
+            char aircraftStr[STR_LEN*2];
+            snprintf(aircraftStr, sizeof(aircraftStr), ",%s,", flightSet[i].aircraftType);
+            
+            for (int c = 0; c < nCrew; c++) {
+                evaluated++;
+                if (!crewSet[c].isAvailable) continue;
+                if (crewSet[c].dutyMinutesToday >= maxDutyTime) continue;
+                Time earliestStart = addMinutesToTime(crewSet[c].lastFlightEnd, minRestTime);
+                if (compareTime(flightSet[i].departureTime, earliestStart) < 0) continue;
+              
+                const char *qualStr = &qualStrs[(gsize)c * STR_LEN * 2];
+                
+                int score = 0;
+                if (strstr(qualStr, aircraftStr) != NULL) {
+                    score = 100; 
+                } else if (strstr(flightSet[i].aircraftType, "Boeing") && 
+                          strstr(qualStr, ",Boeing,")) {
+                    score = 50; 
+                } else if (strstr(flightSet[i].aircraftType, "Airbus") && 
+                          strstr(qualStr, ",Airbus,")) {
+                    score = 50; 
+                }
+
+                score += (maxDutyTime - crewSet[c].dutyMinutesToday)/10;
+                
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestCrewIndex = c;
+                }
+            }
+            
+            if (bestCrewIndex != -1) {
+                flightSet[i].crewAssigned = bestCrewIndex;
+                crewSet[bestCrewIndex].isAvailable = false;
+                crewSet[bestCrewIndex].lastFlightEnd = flightSet[i].arrivalTime;
+                
+                int flightDuration = calculateTimeDifferenceInMinutes(
+                    flightSet[i].departureTime, flightSet[i].arrivalTime);
+                crewSet[bestCrewIndex].dutyMinutesToday += flightDuration;
+            } else {
+              
+                flightSet[i].status = DELAYED;
+                flightSet[i].delayMinutes += 30; 
+            }
+
+        }
+    }
+    METRIC_ADD(COUNTER_CREW_CANDIDATES, evaluated);
+}
+ 
+ void scheduleCrewFor(Flight *flightSet, int nFlights, Crew *crewSet, int nCrew) {
+     SCOPED_TIMER(METRIC_SCHEDULE_CREW);
+     TRACE_SCOPE("scheduleCrew", "planning");
+     if (config.maxDutyTime == DEFAULT_MAX_DUTY_TIME && config.minRestTime == DEFAULT_MIN_REST_TIME) {
+         scheduleCrewWith(flightSet, nFlights, crewSet, nCrew, DEFAULT_MAX_DUTY_TIME, DEFAULT_MIN_REST_TIME);
+     } else {
+         scheduleCrewWith(flightSet, nFlights, crewSet, nCrew, config.maxDutyTime, config.minRestTime);
+     }
+ }
+ 
+ 
+ void assignRunways() {
+     assignRunwaysFor(flights, flightCount, runways, runwayCount);
+ }
+ 
+ void scheduleCrew() {
+     scheduleCrewFor(flights, flightCount, crews, crewCount);
+ }
+ 
+ // Indexed planners: the same greedy rules as assignRunwaysFor and
+ // scheduleCrewFor, with compatible runways listed per flight class and
+ // qualification scores computed once per aircraft type. They are candidates
+ // for the differential oracle (--oracle) and are not wired into the UI.
+ void assignRunwaysIndexed(Flight *flightSet, int nFlights, Runway *runwaySet, int nRunways) {
+     SCOPED_TIMER(METRIC_ASSIGN_RUNWAYS);
+     TRACE_SCOPE("assignRunwaysIndexed", "planning");
+     ARENA_PASS(arena);
+     const int bufferTime = config.bufferTime;
+     gsize evaluated = 0;
+     // Class bit 0: international, bit 1: cargo. Lists keep runway order so
+     // ties resolve exactly as in the reference planner.
+     int *lists = arenaAlloc(arena, sizeof(int) * 4 * MAX(nRunways, 1));
+     int lengths[4] = {0};
+     for (int cls = 0; cls < 4; cls++) {
+         for (int r = 0; r < nRunways; r++) {
+             if (!runwaySet[r].isAvailable) continue;
+             RunwayType type = runwaySet[r].type;
+             if (type == ALL_FLIGHTS || (type == INTERNATIONAL_ONLY && (cls & 1)) || (type == CARGO_ONLY && (cls & 2))) {
+                 lists[cls * nRunways + lengths[cls]++] = r;
+             }
+         }
+     }
+ 
+     for (int i = 0; i < nFlights; i++) {
+         Flight *f = &flightSet[i];
+         if (f->runwayAssigned != -1 || f->status == CANCELLED) continue;
+ 
+         int cls = (f->priority == INTERNATIONAL ? 1 : 0) | (f->isCargo ? 2 : 0);
+         const int *list = &lists[cls * nRunways];
+         for (int k = 0; k < lengths[cls]; k++) {
+             int r = list[k];
+             if (!runwaySet[r].isAvailable) continue;
+             evaluated++;
+             if (compareTime(f->departureTime, runwaySet[r].nextAvailableTime) >= 0) {
+                 f->runwayAssigned = r;
+                 runwaySet[r].isAvailable = false;
+                 runwaySet[r].nextAvailableTime = addMinutesToTime(f->arrivalTime, bufferTime);
+                 break;
+             }
+         }
+ 
+         if (f->runwayAssigned == -1) {
+             f->status = DELAYED;
+             f->delayMinutes += 15;
+         }
+     }
+     METRIC_ADD(COUNTER_RUNWAY_CANDIDATES, evaluated);
+ }
+ 
+ static int qualificationScore(const char *qualifications, const char *aircraftType) {
+     char qualStr[STR_LEN * 2];
+     char aircraftStr[STR_LEN * 2];
+     snprintf(qualStr, sizeof(qualStr), ",%s,", qualifications);
+     snprintf(aircraftStr, sizeof(aircraftStr), ",%s,", aircraftType);
+ 
+     if (strstr(qualStr, aircraftStr)) return 100;
+     if (strstr(aircraftType, "Boeing") && strstr(qualStr, ",Boeing,")) return 50;
+     if (strstr(aircraftType, "Airbus") && strstr(qualStr, ",Airbus,")) return 50;
+     return 0;
+ }
+ 
+ void scheduleCrewIndexed(Flight *flightSet, int nFlights, Crew *crewSet, int nCrew) {
+     SCOPED_TIMER(METRIC_SCHEDULE_CREW);
+     TRACE_SCOPE("scheduleCrewIndexed", "planning");
+     ARENA_PASS(arena);
+     const int maxDutyTime = config.maxDutyTime;
+     const int minRestTime = config.minRestTime;
+     gsize evaluated = 0;
+ 
+     // Available crew as a doubly linked list in index order; assigned crew
+     // leave the list for the rest of the pass.
+     int *next = arenaAlloc(arena, sizeof(int) * (nCrew + 1));
+     int *prev = arenaAlloc(arena, sizeof(int) * (nCrew + 1));
+     int head = -1, tail = -1;
+     for (int c = 0; c < nCrew; c++) {
+         if (!crewSet[c].isAvailable) continue;
+         prev[c] = tail;
+         next[c] = -1;
+         if (tail == -1) head = c; else next[tail] = c;
+         tail = c;
+     }
+ 
+     GHashTable *typeRows = g_hash_table_new(g_str_hash, g_str_equal);
+ 
+     for (int i = 0; i < nFlights; i++) {
+         Flight *f = &flightSet[i];
+         if (f->crewAssigned != -1 || f->status == CANCELLED) continue;
+ 
+         int *scores = g_hash_table_lookup(typeRows, f->aircraftType);
+         if (!scores) {
+             scores = arenaAlloc(arena, sizeof(int) * MAX(nCrew, 1));
+             for (int c = 0; c < nCrew; c++) {
+                 scores[c] = qualificationScore(crewSet[c].qualifications, f->aircraftType);
+             }
+             g_hash_table_insert(typeRows, f->aircraftType, scores);
+         }
+ 
+         int bestCrewIndex = -1;
+         int bestScore = -1;
+         for (int c = head; c != -1; c = next[c]) {
+             evaluated++;
+             if (crewSet[c].dutyMinutesToday >= maxDutyTime) continue;
+             Time earliestStart = addMinutesToTime(crewSet[c].lastFlightEnd, minRestTime);
+             if (compareTime(f->departureTime, earliestStart) < 0) continue;
+ 
+             int score = scores[c] + (maxDutyTime - crewSet[c].dutyMinutesToday) / 10;
+             if (score > bestScore) {
+                 bestScore = score;
+                 bestCrewIndex = c;
+             }
+         }
+ 
+         if (bestCrewIndex != -1) {
+             int c = bestCrewIndex;
+             if (prev[c] == -1) head = next[c]; else next[prev[c]] = next[c];
+             if (next[c] != -1) prev[next[c]] = prev[c];
+ 
+             f->crewAssigned = c;
+             crewSet[c].isAvailable = false;
+             crewSet[c].lastFlightEnd = f->arrivalTime;
+             crewSet[c].dutyMinutesToday += calculateTimeDifferenceInMinutes(f->departureTime, f->arrivalTime);
+         } else {
+             f->status = DELAYED;
+             f->delayMinutes += 30;
+         }
+     }
+ 
+     g_hash_table_destroy(typeRows);
+     METRIC_ADD(COUNTER_CREW_CANDIDATES, evaluated);
+ }
+ 
+ 
+ void handleWeatherDelay(int delayMinutes) {
+     if (flightCount == 0) {
+         addNotification("No flights to delay", false, true);
+         return;
+     }
+ 
+     int flightIndex = rand() % flightCount;
+     
+     flights[flightIndex].departureTime = 
+         addMinutesToTime(flights[flightIndex].departureTime, delayMinutes);
+     flights[flightIndex].arrivalTime = 
+         addMinutesToTime(flights[flightIndex].arrivalTime, delayMinutes);
+     flights[flightIndex].delayMinutes += delayMinutes;
+     flights[flightIndex].status = DELAYED;
+     requestHostedDelay(&flights[flightIndex], delayMinutes);
+     
+     char msg[STR_LEN*2];
+     sprintf(msg, "Weather delay: Flight %s delayed by %d minutes", 
+            flights[flightIndex].flightID, delayMinutes);
+     addNotification(msg, true, false);
+ }
+ 
+ void handleEmergencyLanding() {
+     if (flightCount >= config.maxFlights) {
+         addNotification("Cannot add emergency flight - maximum reached", false, true);
+         return;
+     }
+ 
+     Flight emergencyFlight;
+     strcpy(emergencyFlight.flightID, "EMG");
+     emergencyFlight.flightID[3] = '0' + (rand() % 10);
+     emergencyFlight.flightID[4] = '\0';
+     
+     strcpy(emergencyFlight.origin, "UNKNOWN");
+     strcpy(emergencyFlight.destination, "THIS AIRPORT");
+     strcpy(emergencyFlight.aircraftType, "UNKNOWN");
+     
+     Time now = getCurrentTime();
+     emergencyFlight.departureTime = now;
+     emergencyFlight.arrivalTime = addMinutesToTime(now, 5); 
+     emergencyFlight.scheduledDeparture = now;
+     emergencyFlight.status = EMERGENCY_STATUS;
+     emergencyFlight.runwayAssigned = -1;
+     emergencyFlight.crewAssigned = -1;
+     emergencyFlight.delayMinutes = 0;
+     emergencyFlight.isCargo = false;
+     emergencyFlight.operatingDay = 0;
+     
+     flights[flightCount] = emergencyFlight;
+     flightCount++;
+     indexFlight(flightCount - 1);
+     flight_model_row_inserted(flightCount - 1);
+     
+     char msg[STR_LEN*2];
+     sprintf(msg, "EMERGENCY: Flight %s incoming!", emergencyFlight.flightID);
+     addNotification(msg, false, true);
+     
+
+     assignRunways();
+     scheduleCrew();
+ }
+ 
+ void handleFlightCancellation() {
+     if (flightCount == 0) {
+         addNotification("No flights to cancel", false, true);
+         return;
+     }
+ 
+     int flightIndex = rand() % flightCount;
+     flights[flightIndex].status = CANCELLED;
+     
+     char msg[STR_LEN*2];
+     sprintf(msg, "Flight %s has been cancelled", flights[flightIndex].flightID);
+     addNotification(msg, false, true);
+ }
+ 
+ void rescheduleFlightsFor(Flight *flightSet, int nFlights, Runway *runwaySet, int nRunways,
+                           Crew *crewSet, int nCrew) {
+     SCOPED_TIMER(METRIC_RESCHEDULE);
+     TRACE_SCOPE("rescheduleFlights", "planning");
+     ARENA_PASS(arena);
+     for (int i = 0; i < nFlights; i++) {
+         if (flightSet[i].status != CANCELLED) {
+             flightSet[i].runwayAssigned = -1;
+             flightSet[i].crewAssigned = -1;
+             flightSet[i].status = SCHEDULED;
+             flightSet[i].delayMinutes = 0;
+         }
+     }
+     
+     for (int i = 0; i < nRunways; i++) {
+         runwaySet[i].isAvailable = true;
+         runwaySet[i].nextAvailableTime.hour = 0;
+         runwaySet[i].nextAvailableTime.minute = 0;
+     }
+     
+     for (int i = 0; i < nCrew; i++) {
+         crewSet[i].isAvailable = true;
+         crewSet[i].dutyMinutesToday = 0;
+         crewSet[i].lastFlightEnd.hour = 0;
+         crewSet[i].lastFlightEnd.minute = 0;
+     }
+     
+     assignRunwaysFor(flightSet, nFlights, runwaySet, nRunways);
+     scheduleCrewFor(flightSet, nFlights, crewSet, nCrew);
+ }
+ 
+ void rescheduleFlights() {
+     if (flightCount == 0) {
+         addNotification("No flights to reschedule", false, true);
+         return;
+     }
+ 
+     rescheduleFlightsFor(flights, flightCount, runways, runwayCount, crews, crewCount);
+     
+     addNotification("All flights have been rescheduled", false, false);
+ }
+ 
+ 
+ // Hosted airports. Each instance owns its runways, crew base and flights and
+ // is pinned to one planner shard; only that shard's thread plans it. Linked
+ // legs tie an origin departure to the partner's arrival, and a delay on the
+ // departure is forwarded to the partner's shard as a message. Airports are
+ // only ever appended: the slot is filled before airportCount is raised, so
+ // threads that read the count atomically never see an empty slot.
+ int addAirport(const char *code, int nRunways) {
+     g_mutex_lock(&airportLock);
+     if (airportCount >= MAX_AIRPORTS) {
+         g_mutex_unlock(&airportLock);
+         addNotification("Failed to add airport: Maximum limit reached", false, true);
+         return -1;
+     }
+     if (nRunways < 1) nRunways = 1;
+     if (nRunways > config.maxRunways) nRunways = config.maxRunways;
+ 
+     Airport *airport = g_new0(Airport, 1);
+     airport->flights = g_new0(Flight, config.maxFlights);
+     airport->mirrored = g_new0(bool, config.maxFlights);
+     airport->runways = g_new0(Runway, nRunways);
+     airport->crews = g_new0(Crew, config.maxCrew);
+     strncpy(airport->code, code, STR_LEN - 1);
+     airport->runwayCount = nRunways;
+     initializeRunways(airport->runways, nRunways);
+ 
+     for (int i = 0; i < crewCount; i++) {
+         airport->crews[i] = crews[i];
+         airport->crews[i].dutyMinutesToday = 0;
+         airport->crews[i].lastFlightEnd.hour = 0;
+         airport->crews[i].lastFlightEnd.minute = 0;
+         airport->crews[i].isAvailable = true;
+     }
+     airport->crewCount = crewCount;
+     airport->delaySketches = newDelaySketchTable();
+     g_mutex_init(&airport->lock);
+ 
+     int index = airportCount;
+     airport->shard = plannerShardCount > 0 ? index % plannerShardCount : 0;
+     airports[index] = airport;
+     g_atomic_int_set(&airportCount, index + 1);
+     g_mutex_unlock(&airportLock);
+ 
+     char msg[STR_LEN*2];
+     snprintf(msg, sizeof(msg), "Airport %s added with %d runways", airport->code, nRunways);
+     addNotification(msg, false, false);
+     return index;
+ }
+ 
+ bool addAirportFlight(int airport, const Flight *flight, bool mirrored) {
+     if (airport < 0 || airport >= g_atomic_int_get(&airportCount)) return false;
+ 
+     Airport *a = airports[airport];
+     bool added = false;
+     g_mutex_lock(&a->lock);
+     if (a->flightCount < config.maxFlights) {
+         a->flights[a->flightCount] = *flight;
+         a->flights[a->flightCount].runwayAssigned = -1;
+         a->flights[a->flightCount].crewAssigned = -1;
+         a->mirrored[a->flightCount] = mirrored;
+         a->flightCount++;
+         added = true;
+     }
+     g_mutex_unlock(&a->lock);
+     return added;
+ }
+ 
+ bool linkAirportLeg(int originAirport, const char *departureID,
+                     int destinationAirport, const char *arrivalID) {
+     int hosted = g_atomic_int_get(&airportCount);
+     if (originAirport < 0 || originAirport >= hosted ||
+         destinationAirport < 0 || destinationAirport >= hosted) {
+         return false;
+     }
+ 
+     bool linked = false;
+     g_mutex_lock(&airportLock);
+     if (airportLinkCount < MAX_AIRPORT_LINKS) {
+         AirportLink *link = &airportLinks[airportLinkCount];
+         link->originAirport = originAirport;
+         strncpy(link->departureID, departureID, STR_LEN - 1);
+         link->departureID[STR_LEN - 1] = '\0';
+         link->destinationAirport = destinationAirport;
+         strncpy(link->arrivalID, arrivalID, STR_LEN - 1);
+         link->arrivalID[STR_LEN - 1] = '\0';
+         airportLinkCount++;
+         linked = true;
+     }
+     g_mutex_unlock(&airportLock);
+     return linked;
+ }
+ 
+ // visited is the set of airports a forwarded delay has already reached;
+ // legs linked both ways would otherwise pass it back and forth for ever.
+ static void postPlannerMessage(int airport, PlannerMessageType type,
+                                const char *flightID, int delayMinutes, guint32 visited) {
+     if (plannerShardCount == 0 || airport < 0 || airport >= g_atomic_int_get(&airportCount)) return;
+ 
+     PlannerMessage *message = g_new0(PlannerMessage, 1);
+     message->type = type;
+     message->airport = airport;
+     message->delayMinutes = delayMinutes;
+     message->visited = visited;
+     if (flightID) strncpy(message->flightID, flightID, STR_LEN - 1);
+     g_async_queue_push(plannerShards[airports[airport]->shard].queue, message);
+ }
+ 
+ void requestAirportPlanning(int airport) {
+     postPlannerMessage(airport, PLAN_AIRPORT, NULL, 0, 0);
+ }
+ 
+ void requestAirportDelay(int airport, const char *flightID, int delayMinutes) {
+     postPlannerMessage(airport, DELAY_AIRPORT_FLIGHT, flightID, delayMinutes, 0);
+ }
+ 
+ int findAirport(const char *code) {
+     int hosted = g_atomic_int_get(&airportCount);
+     for (int i = 0; i < hosted; i++) {
+         if (strcmp(airports[i]->code, code) == 0) return i;
+     }
+     return -1;
+ }
+ 
+ // Hosts the airports listed in [airports] hosted=. Each one is seeded with
+ // the loaded flights departing from or arriving at it, and a flight between
+ // two hosted airports becomes a linked leg. Called by the schedule loader
+ // with the write lock held; flights added later stay in the main schedule.
+ void startHostedAirports() {
+     if (!config.airportCodes || airportCount > 0) return;
+ 
+     for (int i = 0; config.airportCodes[i]; i++) {
+         char *code = g_strstrip(config.airportCodes[i]);
+         if (code[0] != '\0' && findAirport(code) < 0) addAirport(code, config.airportRunways);
+     }
+     for (int i = 0; i < flightCount; i++) {
+         int origin = findAirport(flights[i].origin);
+         int destination = findAirport(flights[i].destination);
+         if (origin >= 0) addAirportFlight(origin, &flights[i], true);
+         if (destination >= 0 && destination != origin) addAirportFlight(destination, &flights[i], true);
+         if (origin >= 0 && destination >= 0 && destination != origin) {
+             linkAirportLeg(origin, flights[i].flightID, destination, flights[i].flightID);
+         }
+     }
+     if (airportCount == 0) return;
+ 
+     startAirportPlanners(config.plannerThreads);
+     for (int i = 0; i < airportCount; i++) {
+         requestAirportPlanning(i);
+     }
+ }
+ 
+ // Mirrors a delay made in the main schedule onto the hosted copy of the
+ // flight. The departure airport is told first so the delay reaches the
+ // arrival airport through the linked leg.
+ void requestHostedDelay(const Flight *flight, int delayMinutes) {
+     int airport = findAirport(flight->origin);
+     if (airport < 0) airport = findAirport(flight->destination);
+     if (airport >= 0) requestAirportDelay(airport, flight->flightID, delayMinutes);
+ }
+ 
+ static void planAirport(Airport *a) {
+     ARENA_PASS(arena);
+     g_mutex_lock(&a->lock);
+     assignRunwaysFor(a->flights, a->flightCount, a->runways, a->runwayCount);
+     scheduleCrewFor(a->flights, a->flightCount, a->crews, a->crewCount);
+     g_hash_table_remove_all(a->delaySketches);
+     for (int i = 0; i < a->flightCount; i++) {
+         if (!a->mirrored[i]) recordFlightDelay(a->delaySketches, &a->flights[i], 1);
+     }
+     g_mutex_unlock(&a->lock);
+ }
+ 
+ // The delayed flight gives back its runway and crew before the times move,
+ // so the replan below assigns both against the new times.
+ static void delayAirportFlight(int airport, const char *flightID, int delayMinutes, guint32 visited) {
+     Airport *a = airports[airport];
+     bool found = false;
+ 
+     g_mutex_lock(&a->lock);
+     for (int i = 0; i < a->flightCount; i++) {
+         Flight *f = &a->flights[i];
+         if (strcmp(f->flightID, flightID) == 0) {
+             if (f->runwayAssigned >= 0 && f->runwayAssigned < a->runwayCount) {
+                 a->runways[f->runwayAssigned].isAvailable = true;
+             }
+             if (f->crewAssigned >= 0 && f->crewAssigned < a->crewCount) {
+                 Crew *c = &a->crews[f->crewAssigned];
+                 c->isAvailable = true;
+                 c->dutyMinutesToday = MAX(0, c->dutyMinutesToday -
+                                              calculateTimeDifferenceInMinutes(f->departureTime, f->arrivalTime));
+             }
+             f->departureTime = addMinutesToTime(f->departureTime, delayMinutes);
+             f->arrivalTime = addMinutesToTime(f->arrivalTime, delayMinutes);
+             f->delayMinutes += delayMinutes;
+             f->status = DELAYED;
+             f->runwayAssigned = -1;
+             f->crewAssigned = -1;
+             found = true;
+             break;
+         }
+     }
+     g_mutex_unlock(&a->lock);
+ 
+     if (!found) return;
+ 
+     visited |= 1u << airport;
+     g_mutex_lock(&airportLock);
+     for (int i = 0; i < airportLinkCount; i++) {
+         int destination = airportLinks[i].destinationAirport;
+         if (airportLinks[i].originAirport == airport && !(visited & (1u << destination)) &&
+             strcmp(airportLinks[i].departureID, flightID) == 0) {
+             postPlannerMessage(destination, DELAY_AIRPORT_FLIGHT, airportLinks[i].arrivalID, delayMinutes, visited);
+         }
+     }
+     g_mutex_unlock(&airportLock);
+ 
+     planAirport(a);
+ }
+ 
+ static gpointer airportPlannerThread(gpointer data) {
+     PlannerShard *shard = (PlannerShard *)data;
+     traceThreadName("airport-planner");
+ 
+     while (true) {
+         PlannerMessage *message = g_async_queue_pop(shard->queue);
+         PlannerMessageType type = message->type;
+ 
+         if (type == PLAN_AIRPORT) {
+             TRACE_SCOPE("planAirport", "worker");
+             planAirport(airports[message->airport]);
+         } else if (type == DELAY_AIRPORT_FLIGHT) {
+             TRACE_SCOPE("delayAirportFlight", "worker");
+             delayAirportFlight(message->airport, message->flightID, message->delayMinutes, message->visited);
+         }
+         g_free(message);
+ 
+         if (type == STOP_PLANNER) break;
+     }
+     return NULL;
+ }
+ 
+ void startAirportPlanners(int threadCount) {
+     if (plannerShardCount > 0) return;
+     if (threadCount < 1) threadCount = 1;
+     if (threadCount > MAX_PLANNER_THREADS) threadCount = MAX_PLANNER_THREADS;
+ 
+     for (int i = 0; i < threadCount; i++) {
+         plannerShards[i].queue = g_async_queue_new();
+         plannerShards[i].thread = g_thread_new("airport-planner", airportPlannerThread, &plannerShards[i]);
+     }
+     plannerShardCount = threadCount;
+ 
+     for (int i = 0; i < airportCount; i++) {
+         airports[i]->shard = i % plannerShardCount;
+     }
+ }
+ 
+ void stopAirportPlanners() {
+     for (int i = 0; i < plannerShardCount; i++) {
+         PlannerMessage *message = g_new0(PlannerMessage, 1);
+         message->type = STOP_PLANNER;
+         g_async_queue_push(plannerShards[i].queue, message);
+     }
+     for (int i = 0; i < plannerShardCount; i++) {
+         g_thread_join(plannerShards[i].thread);
+         g_async_queue_unref(plannerShards[i].queue);
+     }
+     plannerShardCount = 0;
+ }
+ 
+ 
+ void on_login_clicked(GtkWidget *widget, gpointer data) {
+    TRACE_SCOPE(__func__, "ui");
+    const char *username = gtk_entry_get_text(GTK_ENTRY(username_entry));
+    const char *password = gtk_entry_get_text(GTK_ENTRY(password_entry));
+
+    if (strlen(username) == 0 || strlen(password) == 0) {
+        gtk_label_set_text(GTK_LABEL(notification_label), "Please enter both username and password");
+        return;
+    }
+
+    if (!scheduleLoaded) {
+        loginPending = true;
+        gtk_label_set_text(GTK_LABEL(notification_label), "Loading schedule data; you will be signed in when it is ready");
+        return;
+    }
+    loginPending = false;
+
+    User authenticatedUser;
+    if (authenticateUser(username, password, &authenticatedUser)) {
+        currentUser = authenticatedUser;
+        if (viewerProcess) {
+            currentUser.role = VIEWER;
+        }
+        
+        printf("Login successful for user: %s\n", currentUser.username);
+        
+        gtk_entry_set_text(GTK_ENTRY(password_entry), "");
+        
+        create_main_menu();
+        
+        char welcome_msg[256];
+        sprintf(welcome_msg, "Welcome, %s (%s)", 
+                currentUser.username,
+                currentUser.role == ADMIN ? "Admin" : 
+                currentUser.role == FLIGHT_SCHEDULER ? "Flight Scheduler" :
+                currentUser.role == CREW_SCHEDULER ? "Crew Scheduler" : "Viewer");
+        gtk_label_set_text(GTK_LABEL(notification_label), welcome_msg);
+    } else {
+        gtk_label_set_text(GTK_LABEL(notification_label), "Invalid username or password");
+    }
+}
+
+ 
+ void on_back_clicked(GtkWidget *widget, gpointer data) {
+     gtk_stack_set_visible_child_name(GTK_STACK(stack), "main_menu");
+ }
+ 
+ void on_logout_clicked(GtkWidget *widget, gpointer data) {
+     gtk_stack_set_visible_child_name(GTK_STACK(stack), "login");
+     gtk_entry_set_text(GTK_ENTRY(username_entry), "");
+     gtk_entry_set_text(GTK_ENTRY(password_entry), "");
+     gtk_label_set_text(GTK_LABEL(notification_label), "Logged out successfully");
+ }
+ 
+ void on_add_flight_clicked(GtkWidget *widget, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     beginScheduleAction("Add flight");
+     addFlight();
+     commitScheduleWrite();
+     gtk_label_set_text(GTK_LABEL(notification_label), "Flight added successfully");
+ }
+ 
+ void on_modify_flight_clicked(GtkWidget *widget, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     beginScheduleAction("Modify flight");
+     modifyFlight();
+     commitScheduleWrite();
+     gtk_label_set_text(GTK_LABEL(notification_label), "Flight modified successfully");
+ }
+ 
+ void on_delete_flight_clicked(GtkWidget *widget, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     beginScheduleAction("Delete flight");
+     deleteFlight();
+     commitScheduleWrite();
+     gtk_label_set_text(GTK_LABEL(notification_label), "Flight deleted successfully");
+ }
+ 
+ void on_assign_runways_clicked(GtkWidget *widget, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     beginScheduleAction("Assign runways");
+     assignRunways();
+     commitScheduleWrite();
+     gtk_label_set_text(GTK_LABEL(notification_label), "Runways assigned successfully");
+ }
+ 
+ void on_schedule_crew_clicked(GtkWidget *widget, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     beginScheduleAction("Schedule crew");
+     scheduleCrew();
+     commitScheduleWrite();
+     gtk_label_set_text(GTK_LABEL(notification_label), "Crew scheduled successfully");
+ }
+ 
+ void show_delay_dialog() {
+     GtkWidget *dialog, *content_area, *grid, *label, *spin;
+     
+     dialog = gtk_dialog_new_with_buttons("Enter Delay Time",
+                                        GTK_WINDOW(window),
+                                        GTK_DIALOG_MODAL,
+                                        "_OK",
+                                        GTK_RESPONSE_ACCEPT,
+                                        "_Cancel",
+                                        GTK_RESPONSE_REJECT,
+                                        NULL);
+     
+     content_area = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+     
+     grid = gtk_grid_new();
+     gtk_grid_set_row_spacing(GTK_GRID(grid), 10);
+     gtk_grid_set_column_spacing(GTK_GRID(grid), 10);
+     gtk_container_set_border_width(GTK_CONTAINER(grid), 10);
+     
+     label = gtk_label_new("Delay time (minutes):");
+     spin = gtk_spin_button_new_with_range(1, 300, 1);
+     
+     gtk_grid_attach(GTK_GRID(grid), label, 0, 0, 1, 1);
+     gtk_grid_attach(GTK_GRID(grid), spin, 1, 0, 1, 1);
+     
+     gtk_container_add(GTK_CONTAINER(content_area), grid);
+     
+     g_signal_connect(dialog, "response",
+                     G_CALLBACK(on_delay_dialog_response),
+                     spin);
+     
+     gtk_widget_show_all(dialog);
+ }
+ 
+ void on_delay_dialog_response(GtkDialog *dialog, gint response_id, gpointer user_data) {
+     TRACE_SCOPE(__func__, "ui");
+     GtkSpinButton *spin = GTK_SPIN_BUTTON(user_data);
+     
+     if (response_id == GTK_RESPONSE_ACCEPT) {
+         int delay = gtk_spin_button_get_value_as_int(spin);
+         beginScheduleAction("Weather delay");
+         handleWeatherDelay(delay);
+         commitScheduleWrite();
+         gtk_label_set_text(GTK_LABEL(notification_label), "Weather delay simulated");
+     }
+     
+     gtk_widget_destroy(GTK_WIDGET(dialog));
+ }
+ 
+ void on_weather_delay_clicked(GtkWidget *widget, gpointer data) {
+     show_delay_dialog();
+ }
+ 
+ void on_emergency_landing_clicked(GtkWidget *widget, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     beginScheduleAction("Emergency landing");
+     handleEmergencyLanding();
+     commitScheduleWrite();
+     gtk_label_set_text(GTK_LABEL(notification_label), "Emergency landing simulated");
+ }
+ 
+ void on_flight_cancellation_clicked(GtkWidget *widget, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     beginScheduleAction("Flight cancellation");
+     handleFlightCancellation();
+     commitScheduleWrite();
+     gtk_label_set_text(GTK_LABEL(notification_label), "Flight cancellation simulated");
+ }
+ 
+ void on_reschedule_clicked(GtkWidget *widget, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     // Finished flights go to the archive first so re-planning leaves them alone.
+     beginScheduleWrite();
+     if (archiveFinishedFlightsNow() > 0) {
+         saveArchive(FILENAME_ARCHIVE);
+         commitScheduleWrite();
+     } else {
+         cancelScheduleWrite();
+     }
+ 
+     beginScheduleAction("Reschedule all flights");
+     rescheduleFlights();
+     commitScheduleWrite();
+     gtk_label_set_text(GTK_LABEL(notification_label), "All flights rescheduled");
+ }
+ 
+ // Filter queries. A query is a whitespace-separated list of predicates that
+ // must all hold, e.g. "status=delayed priority=international dep>=14:00
+ // dep<18:00 runway=1". compileFilter() parses it into a FilterPlan;
+ // runFilter() picks the most selective secondary index of the snapshot it
+ // runs against as the access path and checks every predicate on the rows it
+ // yields. Indexes are built once per published version, on first use.
+ static void buildRowBuckets(RowBuckets *buckets, int keyCount, const int *keys, int n) {
+     buckets->keyCount = keyCount;
+     buckets->offsets = g_new0(int, keyCount + 1);
+     buckets->rows = g_new(int, MAX(n, 1));
+ 
+     for (int i = 0; i < n; i++) buckets->offsets[keys[i] + 1]++;
+     for (int k = 0; k < keyCount; k++) buckets->offsets[k + 1] += buckets->offsets[k];
+ 
+     int *fill = g_new(int, keyCount);
+     memcpy(fill, buckets->offsets, sizeof(int) * keyCount);
+     for (int i = 0; i < n; i++) buckets->rows[fill[keys[i]]++] = i;
+     g_free(fill);
+ }
+ 
+ static void freeRowBuckets(RowBuckets *buckets) {
+     g_free(buckets->offsets);
+     g_free(buckets->rows);
+ }
+ 
+ static FlightIndexes* buildFlightIndexes(const ScheduleState *state) {
+     FlightIndexes *indexes = g_new0(FlightIndexes, 1);
+     int n = state->flightCount;
+     int *keys = g_new(int, MAX(n, 1));
+ 
+     for (int i = 0; i < n; i++) keys[i] = CLAMP((int)state->flights[i].status, 0, 3);
+     buildRowBuckets(&indexes->byStatus, 4, keys, n);
+     for (int i = 0; i < n; i++) keys[i] = CLAMP((int)state->flights[i].priority, 0, 3);
+     buildRowBuckets(&indexes->byPriority, 4, keys, n);
+     for (int i = 0; i < n; i++) keys[i] = CLAMP(state->flights[i].runwayAssigned + 1, 0, config.maxRunways);
+     buildRowBuckets(&indexes->byRunway, config.maxRunways + 1, keys, n);
+     for (int i = 0; i < n; i++) keys[i] = CLAMP(state->flights[i].crewAssigned + 1, 0, config.maxCrew);
+     buildRowBuckets(&indexes->byCrew, config.maxCrew + 1, keys, n);
+     for (int i = 0; i < n; i++) {
+         keys[i] = CLAMP(state->flights[i].departureTime.hour * 60 + state->flights[i].departureTime.minute,
+                         0, MINUTES_PER_DAY - 1);
+     }
+     buildRowBuckets(&indexes->byDeparture, MINUTES_PER_DAY, keys, n);
+ 
+     g_free(keys);
+     return indexes;
+ }
+ 
+ void freeFlightIndexes(FlightIndexes *indexes) {
+     if (!indexes) return;
+     freeRowBuckets(&indexes->byStatus);
+     freeRowBuckets(&indexes->byPriority);
+     freeRowBuckets(&indexes->byRunway);
+     freeRowBuckets(&indexes->byCrew);
+     freeRowBuckets(&indexes->byDeparture);
+     g_free(indexes);
+ }
+ 
+ const FlightIndexes* scheduleIndexes(const ScheduleState *state) {
+     ScheduleState *mutableState = (ScheduleState *)state;
+     FlightIndexes *indexes = g_atomic_pointer_get(&mutableState->indexes);
+     if (indexes) return indexes;
+ 
+     indexes = buildFlightIndexes(state);
+     if (!g_atomic_pointer_compare_and_exchange(&mutableState->indexes, NULL, indexes)) {
+         freeFlightIndexes(indexes);
+         indexes = g_atomic_pointer_get(&mutableState->indexes);
+     }
+     return indexes;
+ }
+ 
+ static bool parseFilterValue(FilterPredicate *predicate, const char *text) {
+     strncpy(predicate->text, text, STR_LEN - 1);
+     predicate->text[STR_LEN - 1] = '\0';
+ 
+     switch (predicate->field) {
+         case FIELD_STATUS:
+             if (g_ascii_strcasecmp(text, "scheduled") == 0) predicate->value = SCHEDULED;
+             else if (g_ascii_strcasecmp(text, "delayed") == 0) predicate->value = DELAYED;
+             else if (g_ascii_strcasecmp(text, "cancelled") == 0) predicate->value = CANCELLED;
+             else if (g_ascii_strcasecmp(text, "emergency") == 0) predicate->value = EMERGENCY_STATUS;
+             else return false;
+             return true;
+         case FIELD_PRIORITY:
+             if (g_ascii_strcasecmp(text, "emergency") == 0) predicate->value = EMERGENCY;
+             else if (g_ascii_strcasecmp(text, "international") == 0) predicate->value = INTERNATIONAL;
+             else if (g_ascii_strcasecmp(text, "domestic") == 0) predicate->value = DOMESTIC;
+             else return false;
+             return true;
+         case FIELD_RUNWAY:
+         case FIELD_CREW:
+             if (g_ascii_strcasecmp(text, "none") == 0) {
+                 predicate->value = -1;
+                 return true;
+             }
+             /* fall through */
+         case FIELD_DELAY: {
+             char *end;
+             long value = strtol(text, &end, 10);
+             if (end == text || *end != '\0') return false;
+             predicate->value = (int)value;
+             return true;
+         }
+         case FIELD_DEPARTURE:
+         case FIELD_ARRIVAL: {
+             int hour, minute;
+             char extra;
+             if (sscanf(text, "%d:%d%c", &hour, &minute, &extra) != 2 ||
+                 hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+                 return false;
+             }
+             predicate->value = hour * 60 + minute;
+             return true;
+         }
+         case FIELD_CARGO:
+             if (g_ascii_strcasecmp(text, "yes") == 0 || g_ascii_strcasecmp(text, "true") == 0) predicate->value = 1;
+             else if (g_ascii_strcasecmp(text, "no") == 0 || g_ascii_strcasecmp(text, "false") == 0) predicate->value = 0;
+             else return false;
+             return true;
+         default:
+             return true;
+     }
+ }
+ 
+ bool compileFilter(const char *query, FilterPlan *plan, char *error, size_t errorSize) {
+     static const struct { const char *name; FilterField field; } fieldNames[] = {
+         {"status", FIELD_STATUS}, {"priority", FIELD_PRIORITY}, {"runway", FIELD_RUNWAY},
+         {"crew", FIELD_CREW}, {"dep", FIELD_DEPARTURE}, {"arr", FIELD_ARRIVAL},
+         {"delay", FIELD_DELAY}, {"cargo", FIELD_CARGO}, {"id", FIELD_ID},
+         {"origin", FIELD_ORIGIN}, {"dest", FIELD_DESTINATION}, {"aircraft", FIELD_AIRCRAFT}
+     };
+     static const struct { const char *symbol; FilterOp op; } operators[] = {
+         {"!=", OP_NE}, {"<=", OP_LE}, {">=", OP_GE}, {"=", OP_EQ},
+         {"<", OP_LT}, {">", OP_GT}, {"~", OP_CONTAINS}
+     };
+ 
+     memset(plan, 0, sizeof(FilterPlan));
+     char buffer[512];
+     strncpy(buffer, query, sizeof(buffer) - 1);
+     buffer[sizeof(buffer) - 1] = '\0';
+ 
+     char *saveptr;
+     for (char *token = strtok_r(buffer, " \t", &saveptr); token; token = strtok_r(NULL, " \t", &saveptr)) {
+         if (g_ascii_strcasecmp(token, "and") == 0) continue;
+         if (plan->predicateCount >= MAX_FILTER_PREDICATES) {
+             snprintf(error, errorSize, "Too many conditions (max %d)", MAX_FILTER_PREDICATES);
+             return false;
+         }
+ 
+         FilterPredicate *predicate = &plan->predicates[plan->predicateCount];
+         char *opAt = NULL;
+         size_t opLength = 0;
+         for (size_t o = 0; o < G_N_ELEMENTS(operators) && !opAt; o++) {
+             opAt = strstr(token, operators[o].symbol);
+             if (opAt) {
+                 predicate->op = operators[o].op;
+                 opLength = strlen(operators[o].symbol);
+             }
+         }
+         if (!opAt || opAt == token || opAt[opLength] == '\0') {
+             snprintf(error, errorSize, "Cannot parse condition '%s'", token);
+             return false;
+         }
+ 
+         *opAt = '\0';
+         bool known = false;
+         for (size_t f = 0; f < G_N_ELEMENTS(fieldNames); f++) {
+             if (g_ascii_strcasecmp(token, fieldNames[f].name) == 0) {
+                 predicate->field = fieldNames[f].field;
+                 known = true;
+                 break;
+             }
+         }
+         if (!known) {
+             snprintf(error, errorSize, "Unknown field '%s'", token);
+             return false;
+         }
+         bool textField = predicate->field >= FIELD_ID;
+         if ((predicate->op == OP_CONTAINS) != textField && !(textField && predicate->op == OP_EQ)) {
+             snprintf(error, errorSize, "Operator not supported for '%s'", token);
+             return false;
+         }
+         if (!parseFilterValue(predicate, opAt + opLength)) {
+             snprintf(error, errorSize, "Bad value '%s' for '%s'", opAt + opLength, token);
+             return false;
+         }
+         plan->predicateCount++;
+     }
+ 
+     if (plan->predicateCount == 0) {
+         snprintf(error, errorSize, "Empty filter");
+         return false;
+     }
+     return true;
+ }
+ 
+ static bool compareFilterValue(FilterOp op, int actual, int expected) {
+     switch (op) {
+         case OP_EQ: return actual == expected;
+         case OP_NE: return actual != expected;
+         case OP_LT: return actual < expected;
+         case OP_LE: return actual <= expected;
+         case OP_GT: return actual > expected;
+         case OP_GE: return actual >= expected;
+         default: return false;
+     }
+ }
+ 
+ bool flightMatchesFilter(const FilterPlan *plan, const Flight *flight) {
+     for (int p = 0; p < plan->predicateCount; p++) {
+         const FilterPredicate *predicate = &plan->predicates[p];
+         const char *text = NULL;
+         int actual = 0;
+ 
+         switch (predicate->field) {
+             case FIELD_STATUS: actual = flight->status; break;
+             case FIELD_PRIORITY: actual = flight->priority; break;
+             case FIELD_RUNWAY: actual = flight->runwayAssigned; break;
+             case FIELD_CREW: actual = flight->crewAssigned; break;
+             case FIELD_DEPARTURE: actual = flight->departureTime.hour * 60 + flight->departureTime.minute; break;
+             case FIELD_ARRIVAL: actual = flight->arrivalTime.hour * 60 + flight->arrivalTime.minute; break;
+             case FIELD_DELAY: actual = flight->delayMinutes; break;
+             case FIELD_CARGO: actual = flight->isCargo ? 1 : 0; break;
+             case FIELD_ID: text = flight->flightID; break;
+             case FIELD_ORIGIN: text = flight->origin; break;
+             case FIELD_DESTINATION: text = flight->destination; break;
+             case FIELD_AIRCRAFT: text = flight->aircraftType; break;
+         }
+ 
+         if (text) {
+             bool match = predicate->op == OP_CONTAINS ? textContainsIgnoreCase(text, predicate->text)
+                                                       : g_ascii_strcasecmp(text, predicate->text) == 0;
+             if (!match) return false;
+         } else if (!compareFilterValue(predicate->op, actual, predicate->value)) {
+             return false;
+         }
+     }
+     return true;
+ }
+ 
+ // Chooses the access path with the fewest candidate rows: one bucket of an
+ // equality index, or the departure-time range implied by all dep bounds.
+ static void chooseFilterAccess(const FilterPlan *plan, const FlightIndexes *indexes,
+                                const int **rows, int *count) {
+     int lo = 0, hi = MINUTES_PER_DAY - 1;
+     bool hasRange = false;
+ 
+     for (int p = 0; p < plan->predicateCount; p++) {
+         const FilterPredicate *predicate = &plan->predicates[p];
+         if (predicate->field == FIELD_DEPARTURE) {
+             switch (predicate->op) {
+                 case OP_EQ: lo = MAX(lo, predicate->value); hi = MIN(hi, predicate->value); hasRange = true; break;
+                 case OP_GE: lo = MAX(lo, predicate->value); hasRange = true; break;
+                 case OP_GT: lo = MAX(lo, predicate->value + 1); hasRange = true; break;
+                 case OP_LE: hi = MIN(hi, predicate->value); hasRange = true; break;
+                 case OP_LT: hi = MIN(hi, predicate->value - 1); hasRange = true; break;
+                 default: break;
+             }
+             continue;
+         }
+         if (predicate->op != OP_EQ) continue;
+ 
+         const RowBuckets *buckets = NULL;
+         int key = 0;
+         switch (predicate->field) {
+             case FIELD_STATUS: buckets = &indexes->byStatus; key = predicate->value; break;
+             case FIELD_PRIORITY: buckets = &indexes->byPriority; key = predicate->value; break;
+             case FIELD_RUNWAY: buckets = &indexes->byRunway; key = predicate->value + 1; break;
+             case FIELD_CREW: buckets = &indexes->byCrew; key = predicate->value + 1; break;
+             default: break;
+         }
+         if (!buckets) continue;
+         if (key < 0 || key >= buckets->keyCount) {
+             *count = 0;
+             return;
+         }
+         int size = buckets->offsets[key + 1] - buckets->offsets[key];
+         if (size < *count) {
+             *rows = buckets->rows + buckets->offsets[key];
+             *count = size;
+         }
+     }
+ 
+     if (hasRange) {
+         int size = lo > hi ? 0 : indexes->byDeparture.offsets[hi + 1] - indexes->byDeparture.offsets[lo];
+         if (size < *count) {
+             *rows = indexes->byDeparture.rows + indexes->byDeparture.offsets[MIN(lo, MINUTES_PER_DAY - 1)];
+             *count = size;
+         }
+     }
+ }
+ 
+ // Appends matching row indices of the given snapshot to rows, in
+ // departure-time order when the departure index was the access path.
+ int runFilter(const FilterPlan *plan, const ScheduleState *state, GArray *rows) {
+     g_array_set_size(rows, 0);
+     if (!state) return 0;
+ 
+     const FlightIndexes *indexes = scheduleIndexes(state);
+     const int *candidates = NULL;
+     int count = state->flightCount;
+     chooseFilterAccess(plan, indexes, &candidates, &count);
+ 
+     for (int c = 0; c < count; c++) {
+         int row = candidates ? candidates[c] : c;
+         if (flightMatchesFilter(plan, &state->flights[row])) {
+             g_array_append_val(rows, row);
+         }
+     }
+     return rows->len;
+ }
+ 
+ // Search index. Every indexed flight gets a stable slot number, and each
+ // lower-cased trigram of its ID, origin, destination and aircraft type maps
+ // to a sorted posting list of slots. Flights are only appended, so slots
+ // increase along searchRowSlots and a slot's row is found by binary search.
+ // An add appends to the postings of that flight. A delete leaves its slot in
+ // the postings as a tombstone that no row maps to; once tombstones outnumber
+ // the flights the index is rebuilt, as it is after bulk loads, on the next
+ // query.
+ static guint32 trigramKey(const char *p) {
+     return (guint32)(guint8)g_ascii_tolower(p[0]) |
+            (guint32)(guint8)g_ascii_tolower(p[1]) << 8 |
+            (guint32)(guint8)g_ascii_tolower(p[2]) << 16;
+ }
+ 
+ static int compareTrigrams(const void *a, const void *b) {
+     guint32 x = *(const guint32 *)a, y = *(const guint32 *)b;
+     return x < y ? -1 : x > y ? 1 : 0;
+ }
+ 
+ static int flightTrigrams(const Flight *flight, guint32 *out) {
+     const char *fields[] = { flight->flightID, flight->origin, flight->destination, flight->aircraftType };
+     int count = 0;
+ 
+     for (int f = 0; f < 4; f++) {
+         const char *text = fields[f];
+         size_t length = strnlen(text, STR_LEN);
+         for (size_t i = 0; i + 3 <= length; i++) {
+             out[count++] = trigramKey(text + i);
+         }
+     }
+ 
+     qsort(out, count, sizeof(guint32), compareTrigrams);
+     int unique = 0;
+     for (int i = 0; i < count; i++) {
+         if (unique == 0 || out[unique - 1] != out[i]) out[unique++] = out[i];
+     }
+     return unique;
+ }
+ 
+ static GArray* searchPosting(guint32 trigram, bool create) {
+     GArray *posting = g_hash_table_lookup(searchPostings, GUINT_TO_POINTER(trigram));
+     if (!posting && create) {
+         posting = g_array_new(FALSE, FALSE, sizeof(guint32));
+         g_hash_table_insert(searchPostings, GUINT_TO_POINTER(trigram), posting);
+     }
+     return posting;
+ }
+ 
+ static int postingFind(GArray *posting, guint32 slot) {
+     int lo = 0, hi = (int)posting->len - 1;
+     while (lo <= hi) {
+         int mid = (lo + hi) / 2;
+         guint32 value = g_array_index(posting, guint32, mid);
+         if (value == slot) return mid;
+         if (value < slot) lo = mid + 1; else hi = mid - 1;
+     }
+     return -1;
+ }
+ 
+ static int searchSlotRow(guint32 slot) {
+     int lo = 0, hi = flightCount - 1;
+     while (lo <= hi) {
+         int mid = (lo + hi) / 2;
+         if (searchRowSlots[mid] == slot) return mid;
+         if (searchRowSlots[mid] < slot) lo = mid + 1; else hi = mid - 1;
+     }
+     return -1;
+ }
+ 
+ static void freePosting(gpointer posting) {
+     g_array_free(posting, TRUE);
+ }
+ 
+ void indexFlight(int row) {
+     if (searchIndexStale) return;
+ 
+     guint32 trigrams[4 * STR_LEN];
+     guint32 slot = nextSearchSlot++;
+     int count = flightTrigrams(&flights[row], trigrams);
+ 
+     searchRowSlots[row] = slot;
+     for (int i = 0; i < count; i++) {
+         g_array_append_val(searchPosting(trigrams[i], true), slot);
+     }
+ }
+ 
+ // Call before the flight is removed from flights[]; later rows move up one
+ // and their slots with them.
+ void unindexFlight(int row) {
+     if (searchIndexStale) return;
+ 
+     memmove(&searchRowSlots[row], &searchRowSlots[row + 1], sizeof(guint32) * (flightCount - row - 1));
+     if (++searchDeadSlots > MAX(flightCount, 1024)) invalidateSearchIndex();
+ }
+ 
+ void invalidateSearchIndex() {
+     searchIndexStale = true;
+ }
+ 
+ void rebuildSearchIndex() {
+     if (!searchPostings) {
+         searchPostings = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, freePosting);
+     }
+     g_hash_table_remove_all(searchPostings);
+     nextSearchSlot = 1;
+     searchDeadSlots = 0;
+ 
+     searchIndexStale = false;
+     for (int i = 0; i < flightCount; i++) {
+         indexFlight(i);
+     }
+ }
+ 
+ static bool flightMatchesTerm(const Flight *flight, const char *term) {
+     return textContainsIgnoreCase(flight->flightID, term) ||
+            textContainsIgnoreCase(flight->origin, term) ||
+            textContainsIgnoreCase(flight->destination, term) ||
+            textContainsIgnoreCase(flight->aircraftType, term);
+ }
+ 
+ static int compareRows(const void *a, const void *b) {
+     return *(const int *)a - *(const int *)b;
+ }
+ 
+ // Fills rows with the matching row indices in table order. Terms shorter
+ // than a trigram fall back to a scan; longer ones intersect the postings
+ // starting from the rarest trigram and verify each candidate.
+ void searchFlights(const char *term, GArray *rows) {
+     g_array_set_size(rows, 0);
+     size_t length = strlen(term);
+     if (length == 0) return;
+     if (searchIndexStale || !searchPostings) rebuildSearchIndex();
+ 
+     if (length < 3) {
+         for (int i = 0; i < flightCount; i++) {
+             if (flightMatchesTerm(&flights[i], term)) g_array_append_val(rows, i);
+         }
+         return;
+     }
+ 
+     GArray *rarest = NULL;
+     for (size_t i = 0; i + 3 <= length; i++) {
+         GArray *posting = searchPosting(trigramKey(term + i), false);
+         if (!posting || posting->len == 0) return;
+         if (!rarest || posting->len < rarest->len) rarest = posting;
+     }
+ 
+     for (guint c = 0; c < rarest->len; c++) {
+         guint32 slot = g_array_index(rarest, guint32, c);
+         bool inAll = true;
+         for (size_t i = 0; i + 3 <= length && inAll; i++) {
+             GArray *posting = searchPosting(trigramKey(term + i), false);
+             if (posting != rarest && postingFind(posting, slot) < 0) inAll = false;
+         }
+         if (!inAll) continue;
+ 
+         int row = searchSlotRow(slot);
+         if (row >= 0 && flightMatchesTerm(&flights[row], term)) g_array_append_val(rows, row);
+     }
+     qsort(rows->data, rows->len, sizeof(int), compareRows);
+ }
+ 
+ // Flight archive. Finished flights (cancelled ones once their departure has
+ // passed, the rest once they have arrived) are moved out of flights[] by a
+ // sweep every ARCHIVE_SWEEP_MINUTES and at day roll-over, and their delays
+ // go into delayHistory. Archived flights are appended to segments of up to
+ // ARCHIVE_SEGMENT_FLIGHTS rows. Each segment has its own string dictionary,
+ // and a row is a run of varints: the day offset, four dictionary indexes,
+ // departure and arrival minutes, packed priority/status/cargo, runway,
+ // crew, delay and the departure's offset from its booked time, typically
+ // 13-17 bytes against sizeof(Flight). Searches
+ // match the term against a segment's dictionary first and skip segments
+ // with no matching string. Times carry no date, so flights[] is taken to
+ // hold the current operating day: at roll-over everything that did not
+ // cross midnight is finished, and an overnight flight is finished once the
+ // clock has passed its arrival but not yet its departure. The exception is
+ // a flight entered after it would already have landed, which is given the
+ // next day in operatingDay and left alone until that day.
+ static void putVarint(GByteArray *out, guint32 value) {
+     guint8 bytes[5];
+     int n = 0;
+     while (value >= 0x80) {
+         bytes[n++] = (guint8)(value | 0x80);
+         value >>= 7;
+     }
+     bytes[n++] = (guint8)value;
+     g_byte_array_append(out, bytes, n);
+ }
+ 
+ static guint32 getVarint(const guint8 **cursor) {
+     guint32 value = 0;
+     for (int shift = 0; ; shift += 7) {
+         guint8 byte = *(*cursor)++;
+         value |= (guint32)(byte & 0x7f) << shift;
+         if (!(byte & 0x80)) return value;
+     }
+ }
+ 
+ // getVarint for bytes read from disk: false if the value runs past end or
+ // over five bytes.
+ static bool getVarintChecked(const guint8 **cursor, const guint8 *end, guint32 *value) {
+     *value = 0;
+     for (int shift = 0; shift < 35; shift += 7) {
+         if (*cursor >= end) return false;
+         guint8 byte = *(*cursor)++;
+         *value |= (guint32)(byte & 0x7f) << shift;
+         if (!(byte & 0x80)) return true;
+     }
+     return false;
+ }
+ 
+ static guint32 zigzag(gint32 value) {
+     return ((guint32)value << 1) ^ (guint32)(value >> 31);
+ }
+ 
+ static gint32 unzigzag(guint32 value) {
+     return (gint32)(value >> 1) ^ -(gint32)(value & 1);
+ }
+ 
+ static ArchiveSegment* newArchiveSegment(int day) {
+     ArchiveSegment *segment = g_new0(ArchiveSegment, 1);
+     segment->rows = g_byte_array_new();
+     segment->strings = g_ptr_array_new_with_free_func(g_free);
+     segment->stringIndex = g_hash_table_new(g_str_hash, g_str_equal);
+     segment->firstDay = day;
+     segment->lastDay = day;
+     return segment;
+ }
+ 
+ static void reopenArchiveSegment(ArchiveSegment *segment) {
+     segment->stringIndex = g_hash_table_new(g_str_hash, g_str_equal);
+     for (guint i = 0; i < segment->strings->len; i++) {
+         g_hash_table_insert(segment->stringIndex, g_ptr_array_index(segment->strings, i), GUINT_TO_POINTER(i));
+     }
+ }
+ 
+ static void sealArchiveSegment(ArchiveSegment *segment) {
+     if (!segment->stringIndex) return;
+     g_hash_table_destroy(segment->stringIndex);
+     segment->stringIndex = NULL;
+ }
+ 
+ static guint32 archiveString(ArchiveSegment *segment, const char *text) {
+     gpointer found;
+     if (g_hash_table_lookup_extended(segment->stringIndex, text, NULL, &found)) return GPOINTER_TO_UINT(found);
+ 
+     char *copy = g_strndup(text, STR_LEN - 1);
+     guint32 index = segment->strings->len;
+     g_ptr_array_add(segment->strings, copy);
+     g_hash_table_insert(segment->stringIndex, copy, GUINT_TO_POINTER(index));
+     segment->stringBytes += strlen(copy) + 1;
+     return index;
+ }
+ 
+ // Called with archiveLock held.
+ static void appendArchivedFlight(const Flight *f, int day) {
+     if (!archiveSegments) archiveSegments = g_ptr_array_new();
+     ArchiveSegment *segment = archiveSegments->len > 0 ? g_ptr_array_index(archiveSegments, archiveSegments->len - 1) : NULL;
+     if (!segment || !segment->stringIndex || segment->rowCount >= ARCHIVE_SEGMENT_FLIGHTS) {
+         if (segment) sealArchiveSegment(segment);
+         segment = newArchiveSegment(day);
+         g_ptr_array_add(archiveSegments, segment);
+     }
+ 
+     // A clock stepping back across midnight must not put a row before the
+     // segment's first day, which scans use to skip segments.
+     day = MAX(day, segment->firstDay);
+     GByteArray *out = segment->rows;
+     putVarint(out, zigzag(day - segment->firstDay));
+     putVarint(out, archiveString(segment, f->flightID));
+     putVarint(out, archiveString(segment, f->origin));
+     putVarint(out, archiveString(segment, f->destination));
+     putVarint(out, archiveString(segment, f->aircraftType));
+     putVarint(out, f->departureTime.hour * 60 + f->departureTime.minute);
+     putVarint(out, f->arrivalTime.hour * 60 + f->arrivalTime.minute);
+     putVarint(out, (f->priority & 3) | (f->status & 3) << 2 | (f->isCargo ? 16 : 0));
+     putVarint(out, zigzag(f->runwayAssigned));
+     putVarint(out, zigzag(f->crewAssigned));
+     putVarint(out, zigzag(f->delayMinutes));
+     int booked = f->scheduledDeparture.hour * 60 + f->scheduledDeparture.minute;
+     putVarint(out, zigzag(f->departureTime.hour * 60 + f->departureTime.minute - booked));
+     segment->rowCount++;
+     segment->lastDay = MAX(segment->lastDay, day);
+     archivedFlightCount++;
+ }
+ 
+ static bool flightFinished(const Flight *f, int now, int day) {
+     if (f->operatingDay > day) return false;
+     int departure = f->departureTime.hour * 60 + f->departureTime.minute;
+     int arrival = f->arrivalTime.hour * 60 + f->arrivalTime.minute;
+     if (f->status == CANCELLED) return departure + ARCHIVE_GRACE_MINUTES <= now;
+     if (departure <= arrival) return arrival + ARCHIVE_GRACE_MINUTES <= now;
+     return arrival + ARCHIVE_GRACE_MINUTES <= now && now < departure;
+ }
+ 
+ // Moves the flights finished at minute-of-day now into the archive under
+ // the given day. Runs on the GTK thread with the write lock held.
+ static int archiveFinishedFlights(int now, int day) {
+     GArray *removed = g_array_new(FALSE, FALSE, sizeof(int));
+     int kept = 0;
+ 
+     g_mutex_lock(&archiveLock);
+     g_mutex_lock(&delaySketchLock);
+     if (!delayHistory) delayHistory = newDelaySketchTable();
+     for (int i = 0; i < flightCount; i++) {
+         if (flightFinished(&flights[i], now, day)) {
+             appendArchivedFlight(&flights[i], day);
+             recordFlightDelay(delayHistory, &flights[i], 1);
+             g_array_append_val(removed, i);
+         } else {
+             if (kept != i) flights[kept] = flights[i];
+             kept++;
+         }
+     }
+     g_mutex_unlock(&delaySketchLock);
+     g_mutex_unlock(&archiveLock);
+ 
+     int moved = removed->len;
+     if (moved > 0) {
+         flightCount = kept;
+         selectedFlightIndex = -1;
+         invalidateSearchIndex();
+         for (int k = 0; k < moved; k++) flight_model_row_deleted(g_array_index(removed, int, k) - k);
+     }
+     g_array_free(removed, TRUE);
+     return moved;
+ }
+ 
+ // Local calendar day (days since the epoch) and minute of day.
+ static int archiveClock(int *minute) {
+     time_t now = time(NULL);
+     struct tm local;
+     localtime_r(&now, &local);
+     *minute = local.tm_hour * 60 + local.tm_min;
+     return (int)((now + local.tm_gmtoff) / 86400);
+ }
+ 
+ // Sets the day a flight being entered now operates on. Returns true if
+ // that is tomorrow, because the flight would already count as finished today.
+ bool assignOperatingDay(Flight *f) {
+     int minute, day = archiveClock(&minute);
+     f->operatingDay = day;
+     if (!flightFinished(f, minute, day)) return false;
+     f->operatingDay = day + 1;
+     return true;
+ }
+ 
+ void formatArchiveDay(int day, char *buffer, size_t size) {
+     time_t start = (time_t)day * 86400;
+     struct tm date;
+     gmtime_r(&start, &date);
+     strftime(buffer, size, "%Y-%m-%d", &date);
+ }
+ 
+ // Write lock held. The first sweep of a new day closes out the day before.
+ int archiveFinishedFlightsNow() {
+     static int lastDay = -1;
+     int minute, day = archiveClock(&minute), moved = 0;
+     if (lastDay >= 0 && day != lastDay) {
+         moved += archiveFinishedFlights(MINUTES_PER_DAY + ARCHIVE_GRACE_MINUTES, lastDay);
+     }
+     lastDay = day;
+     return moved + archiveFinishedFlights(minute, day);
+ }
+ 
+ gboolean archive_sweep_tick(gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     if (!scheduleLoaded || viewerProcess) return G_SOURCE_CONTINUE;
+ 
+     beginScheduleWrite();
+     int moved = archiveFinishedFlightsNow();
+     if (moved == 0) {
+         cancelScheduleWrite();
+         return G_SOURCE_CONTINUE;
+     }
+     // Saved before the commit ships the removals, so a follower that takes
+     // over after a crash finds every flight missing from its replica.
+     saveArchive(FILENAME_ARCHIVE);
+     commitScheduleWrite();
+ 
+     char msg[STR_LEN*2];
+     snprintf(msg, sizeof(msg), "Archived %d finished flights", moved);
+     addNotification(msg, false, false);
+     return G_SOURCE_CONTINUE;
+ }
+ 
+ // Calls visit for each archived flight archived between fromDay and toDay,
+ // oldest first, until it returns false. Segments outside the day range are
+ // skipped whole. With a term, only flights whose ID, origin, destination or
+ // aircraft type contains it are decoded. Holds archiveLock throughout.
+ void scanArchive(const char *term, int fromDay, int toDay,
+                  bool (*visit)(const ArchivedFlight *row, void *context), void *context) {
+     if (term && term[0] == '\0') term = NULL;
+ 
+     g_mutex_lock(&archiveLock);
+     for (guint s = 0; archiveSegments && s < archiveSegments->len; s++) {
+         const ArchiveSegment *segment = g_ptr_array_index(archiveSegments, s);
+         if (segment->lastDay < fromDay || segment->firstDay > toDay) continue;
+         guint8 *hits = NULL;
+         if (term) {
+             bool any = false;
+             hits = g_malloc(MAX(segment->strings->len, 1));
+             for (guint i = 0; i < segment->strings->len; i++) {
+                 hits[i] = textContainsIgnoreCase(g_ptr_array_index(segment->strings, i), term);
+                 any = any || hits[i];
+             }
+             if (!any) {
+                 g_free(hits);
+                 continue;
+             }
+         }
+ 
+         const guint8 *cursor = segment->rows->data;
+         for (int r = 0; r < segment->rowCount; r++) {
+             guint32 fields[ARCHIVE_ROW_FIELDS];
+             for (int k = 0; k < ARCHIVE_ROW_FIELDS; k++) fields[k] = getVarint(&cursor);
+             if (hits && !hits[fields[1]] && !hits[fields[2]] && !hits[fields[3]] && !hits[fields[4]]) continue;
+             int day = segment->firstDay + unzigzag(fields[0]);
+             if (day < fromDay || day > toDay) continue;
+ 
+             ArchivedFlight row;
+             memset(&row, 0, sizeof(row));
+             row.day = day;
+             g_strlcpy(row.flight.flightID, g_ptr_array_index(segment->strings, fields[1]), STR_LEN);
+             g_strlcpy(row.flight.origin, g_ptr_array_index(segment->strings, fields[2]), STR_LEN);
+             g_strlcpy(row.flight.destination, g_ptr_array_index(segment->strings, fields[3]), STR_LEN);
+             g_strlcpy(row.flight.aircraftType, g_ptr_array_index(segment->strings, fields[4]), STR_LEN);
+             row.flight.departureTime.hour = fields[5] / 60;
+             row.flight.departureTime.minute = fields[5] % 60;
+             row.flight.arrivalTime.hour = fields[6] / 60;
+             row.flight.arrivalTime.minute = fields[6] % 60;
+             row.flight.priority = (FlightPriority)(fields[7] & 3);
+             row.flight.status = (FlightStatus)(fields[7] >> 2 & 3);
+             row.flight.isCargo = (fields[7] & 16) != 0;
+             row.flight.runwayAssigned = unzigzag(fields[8]);
+             row.flight.crewAssigned = unzigzag(fields[9]);
+             row.flight.delayMinutes = unzigzag(fields[10]);
+             int booked = (((int)fields[5] - unzigzag(fields[11])) % MINUTES_PER_DAY + MINUTES_PER_DAY) % MINUTES_PER_DAY;
+             row.flight.scheduledDeparture.hour = booked / 60;
+             row.flight.scheduledDeparture.minute = booked % 60;
+             if (!visit(&row, context)) {
+                 g_free(hits);
+                 g_mutex_unlock(&archiveLock);
+                 return;
+             }
+         }
+         g_free(hits);
+     }
+     g_mutex_unlock(&archiveLock);
+ }
+ 
+ void archiveStats(int *segments, int *rows, gsize *storedBytes) {
+     g_mutex_lock(&archiveLock);
+     *segments = archiveSegments ? (int)archiveSegments->len : 0;
+     *rows = archivedFlightCount;
+     *storedBytes = 0;
+     for (int s = 0; s < *segments; s++) {
+         const ArchiveSegment *segment = g_ptr_array_index(archiveSegments, s);
+         *storedBytes += segment->rows->len + segment->stringBytes;
+     }
+     g_mutex_unlock(&archiveLock);
+ }
+ 
+ static bool collectArchivedMatch(const ArchivedFlight *row, void *context) {
+     GArray *rows = context;
+     g_array_append_val(rows, *row);
+     return rows->len < ARCHIVE_SEARCH_LIMIT;
+ }
+ 
+ // Fills rows (ArchivedFlight) with up to ARCHIVE_SEARCH_LIMIT archived
+ // flights matching the term.
+ void searchArchive(const char *term, GArray *rows) {
+     g_array_set_size(rows, 0);
+     if (term[0] == '\0') return;
+     scanArchive(term, G_MININT, G_MAXINT, collectArchivedMatch, rows);
+ }
+ 
+ // The archive file is a magic number and a reserved word followed by a log
+ // of blocks. A block holds a segment index, the rows it adds, the segment's
+ // day range, and the dictionary strings and row bytes it adds. The first
+ // block for an index starts that segment and later ones extend it, so a save
+ // appends only what was archived since the last one (sealed segments never
+ // change) at archiveSavedEnd. Only an archive that was read back in full
+ // may be written to; otherwise the rows held in memory go to a .unmerged
+ // file beside it. Older archives, one block per segment with no index, are
+ // rewritten in the log format by the first save.
+ static bool writeArchiveBlock(FILE *file, guint s) {
+     const ArchiveSegment *segment = g_ptr_array_index(archiveSegments, s);
+     gint32 block[6] = {(gint32)s, segment->rowCount - segment->savedRows, segment->firstDay, segment->lastDay,
+                        (gint32)(segment->strings->len - segment->savedStrings),
+                        (gint32)(segment->rows->len - segment->savedRowBytes)};
+     bool ok = fwrite(block, sizeof(block), 1, file) == 1;
+     for (guint i = segment->savedStrings; ok && i < segment->strings->len; i++) {
+         const char *text = g_ptr_array_index(segment->strings, i);
+         ok = fwrite(text, strlen(text) + 1, 1, file) == 1;
+     }
+     if (ok && block[5] > 0) ok = fwrite(segment->rows->data + segment->savedRowBytes, block[5], 1, file) == 1;
+     return ok;
+ }
+ 
+ static void markArchiveSaved(long end) {
+     for (guint s = 0; archiveSegments && s < archiveSegments->len; s++) {
+         ArchiveSegment *segment = g_ptr_array_index(archiveSegments, s);
+         segment->savedRows = segment->rowCount;
+         segment->savedStrings = segment->strings->len;
+         segment->savedRowBytes = segment->rows->len;
+     }
+     archiveSavedEnd = end;
+ }
+ 
+ // Called with archiveLock held.
+ static bool rewriteArchive(const char *path) {
+     char tempPath[256];
+     snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+     FILE *file = fopen(tempPath, "wb");
+     if (!file) return false;
+ 
+     guint32 header[2] = {ARCHIVE_MAGIC, 0};
+     bool ok = fwrite(header, sizeof(header), 1, file) == 1;
+     for (guint s = 0; ok && archiveSegments && s < archiveSegments->len; s++) {
+         ArchiveSegment *segment = g_ptr_array_index(archiveSegments, s);
+         segment->savedRows = 0;
+         segment->savedStrings = 0;
+         segment->savedRowBytes = 0;
+         ok = writeArchiveBlock(file, s);
+     }
+     long end = ftell(file);
+     ok = fclose(file) == 0 && ok;
+     if (ok) ok = rename(tempPath, path) == 0;
+     if (ok) markArchiveSaved(end);
+     return ok;
+ }
+ 
+ // Called with archiveLock held. Anything past archiveSavedEnd is a save
+ // that failed part way and is overwritten.
+ static bool appendArchive(const char *path) {
+     FILE *file = fopen(path, "r+b");
+     if (!file) return errno == ENOENT && rewriteArchive(path);
+ 
+     bool ok = fseek(file, archiveSavedEnd, SEEK_SET) == 0;
+     for (guint s = 0; ok && s < archiveSegments->len; s++) {
+         const ArchiveSegment *segment = g_ptr_array_index(archiveSegments, s);
+         if (segment->savedRows < segment->rowCount) ok = writeArchiveBlock(file, s);
+     }
+     long end = ftell(file);
+     ok = fflush(file) == 0 && ok;
+     if (ok) ok = ftruncate(fileno(file), end) == 0;
+     ok = fclose(file) == 0 && ok;
+     if (ok) markArchiveSaved(end);
+     return ok;
+ }
+ 
+ bool saveArchive(const char *path) {
+     TRACE_SCOPE("saveArchive", "io");
+     char unmergedPath[256];
+     if (!archiveFileLoaded) {
+         snprintf(unmergedPath, sizeof(unmergedPath), "%s.unmerged", path);
+         path = unmergedPath;
+     }
+ 
+     g_mutex_lock(&archiveLock);
+     bool ok = archiveSavedEnd < 0 || !archiveSegments ? rewriteArchive(path) : appendArchive(path);
+     g_mutex_unlock(&archiveLock);
+ 
+     if (!ok) {
+         addNotification("Failed to save the flight archive", false, true);
+     } else if (!archiveFileLoaded) {
+         addNotification("Flight archive could not be read; new rows saved beside it", false, true);
+     }
+     return ok;
+ }
+ 
+ static bool addArchivedDelay(const ArchivedFlight *row, void *context) {
+     recordFlightDelay(context, &row->flight, 1);
+     return true;
+ }
+ 
+ // Version 1 rows had no booked-departure offset. The planners' delays never
+ // moved the departure, so the delay itself is the best offset available.
+ static void widenArchiveRows(ArchiveSegment *segment) {
+     GByteArray *widened = g_byte_array_sized_new(segment->rows->len + segment->rowCount * 2);
+     const guint8 *cursor = segment->rows->data;
+     for (int r = 0; r < segment->rowCount; r++) {
+         guint32 delay = 0;
+         for (int k = 0; k < ARCHIVE_ROW_FIELDS - 1; k++) {
+             delay = getVarint(&cursor);
+             putVarint(widened, delay);
+         }
+         putVarint(widened, delay);
+     }
+     g_byte_array_free(segment->rows, TRUE);
+     segment->rows = widened;
+ }
+ 
+ static void freeArchiveSegment(ArchiveSegment *segment) {
+     sealArchiveSegment(segment);
+     g_byte_array_free(segment->rows, TRUE);
+     g_ptr_array_free(segment->strings, TRUE);
+     g_free(segment);
+ }
+ 
+ // Bounds a block's counts before anything is allocated for it.
+ static bool archiveBlockFits(const ArchiveSegment *segment, gint32 rows, gint32 strings, gint32 rowBytes) {
+     return rows >= 0 && strings >= 0 && rowBytes >= 0 &&
+            rows <= ARCHIVE_SEGMENT_FLIGHTS - segment->rowCount &&
+            strings <= ARCHIVE_SEGMENT_FLIGHTS * 4 - (gint32)segment->strings->len &&
+            rowBytes <= ARCHIVE_SEGMENT_FLIGHTS * ARCHIVE_ROW_FIELDS * 5 - (gint32)segment->rows->len;
+ }
+ 
+ // Decodes every row once with bounds checks so scans can trust the bytes:
+ // each row must lie within the segment's bytes and day range and name
+ // strings in its dictionary, and the rows must use up the bytes exactly.
+ static bool archiveRowsValid(const ArchiveSegment *segment, int rowFields) {
+     if (segment->lastDay < segment->firstDay) return false;
+     const guint8 *cursor = segment->rows->data, *end = cursor + segment->rows->len;
+     for (int r = 0; r < segment->rowCount; r++) {
+         guint32 fields[ARCHIVE_ROW_FIELDS];
+         for (int k = 0; k < rowFields; k++) {
+             if (!getVarintChecked(&cursor, end, &fields[k])) return false;
+         }
+         gint64 day = (gint64)segment->firstDay + unzigzag(fields[0]);
+         if (day < segment->firstDay || day > segment->lastDay) return false;
+         for (int k = 1; k <= 4; k++) {
+             if (fields[k] >= segment->strings->len) return false;
+         }
+         if (fields[5] >= MINUTES_PER_DAY || fields[6] >= MINUTES_PER_DAY || fields[7] >= 32) return false;
+     }
+     return cursor == end;
+ }
+ 
+ // Appends a block's strings and row bytes to the segment. On a short read
+ // the segment is left as it was.
+ static bool readArchiveBlock(FILE *file, ArchiveSegment *segment, gint32 strings, gint32 rowBytes) {
+     guint oldStrings = segment->strings->len, oldRowBytes = segment->rows->len;
+     gsize oldStringBytes = segment->stringBytes;
+     GString *text = g_string_new(NULL);
+     bool ok = true;
+     for (int i = 0; ok && i < strings; i++) {
+         int c;
+         g_string_truncate(text, 0);
+         while ((c = fgetc(file)) > 0) g_string_append_c(text, (char)c);
+         ok = c == 0;
+         g_ptr_array_add(segment->strings, g_strndup(text->str, STR_LEN - 1));
+         segment->stringBytes += text->len + 1;
+     }
+     g_string_free(text, TRUE);
+ 
+     g_byte_array_set_size(segment->rows, oldRowBytes + rowBytes);
+     if (ok && rowBytes > 0) ok = fread(segment->rows->data + oldRowBytes, rowBytes, 1, file) == 1;
+     if (!ok) {
+         g_ptr_array_set_size(segment->strings, oldStrings);
+         g_byte_array_set_size(segment->rows, oldRowBytes);
+         segment->stringBytes = oldStringBytes;
+     }
+     return ok;
+ }
+ 
+ // Versions 1 and 2: count segments of {rows, first day, last day, strings,
+ // row bytes}.
+ static bool readArchiveSegments(FILE *file, guint32 count, bool widen, GPtrArray *loaded) {
+     for (guint s = 0; s < count; s++) {
+         gint32 fields[5];
+         if (fread(fields, sizeof(fields), 1, file) != 1) return false;
+         ArchiveSegment *segment = newArchiveSegment(fields[1]);
+         sealArchiveSegment(segment);
+         g_ptr_array_add(loaded, segment);
+         if (!archiveBlockFits(segment, fields[0], fields[3], fields[4])) return false;
+         segment->rowCount = fields[0];
+         segment->lastDay = fields[2];
+         if (!readArchiveBlock(file, segment, fields[3], fields[4])) return false;
+         if (widen) {
+             if (!archiveRowsValid(segment, ARCHIVE_ROW_FIELDS - 1)) return false;
+             widenArchiveRows(segment);
+         }
+     }
+     return true;
+ }
+ 
+ // A save cut short leaves an incomplete last block, which is dropped; *end
+ // is where the next save appends.
+ static bool readArchiveLog(FILE *file, GPtrArray *loaded, long *end) {
+     *end = ftell(file);
+     for (;;) {
+         gint32 block[6];
+         size_t got = fread(block, sizeof(gint32), 6, file);
+         if (got == 0 && feof(file)) return true;
+         if (got < 6) break;
+ 
+         ArchiveSegment *segment;
+         bool started = block[0] == (gint32)loaded->len;
+         if (started) {
+             segment = newArchiveSegment(block[2]);
+             sealArchiveSegment(segment);
+             g_ptr_array_add(loaded, segment);
+         } else if (loaded->len > 0 && block[0] == (gint32)loaded->len - 1) {
+             segment = g_ptr_array_index(loaded, loaded->len - 1);
+         } else {
+             return false;
+         }
+         if (!archiveBlockFits(segment, block[1], block[4], block[5])) return false;
+         if (!readArchiveBlock(file, segment, block[4], block[5])) {
+             if (started) {
+                 g_ptr_array_remove_index(loaded, loaded->len - 1);
+                 freeArchiveSegment(segment);
+             }
+             break;
+         }
+         segment->rowCount += block[1];
+         segment->lastDay = block[3];
+         *end = ftell(file);
+     }
+     addNotification("Dropped an incomplete save at the end of the flight archive", true, false);
+     return true;
+ }
+ 
+ // Returns false if the file exists but could not be read; a missing file
+ // is an empty archive.
+ bool loadArchive(const char *path) {
+     TRACE_SCOPE("loadArchive", "io");
+     archiveSavedEnd = -1;
+     FILE *file = fopen(path, "rb");
+     if (!file) {
+         archiveFileLoaded = errno == ENOENT;
+         if (!archiveFileLoaded) addNotification("Cannot open the flight archive", false, true);
+         return archiveFileLoaded;
+     }
+     archiveFileLoaded = false;
+ 
+     guint32 header[2];
+     if (fread(header, sizeof(header), 1, file) != 1 ||
+         (header[0] != ARCHIVE_MAGIC && header[0] != ARCHIVE_MAGIC_V2 && header[0] != ARCHIVE_MAGIC_V1)) {
+         fclose(file);
+         addNotification("Ignoring unreadable flight archive", false, true);
+         return false;
+     }
+ 
+     GPtrArray *loaded = g_ptr_array_new();
+     long end = -1;
+     bool ok = header[0] == ARCHIVE_MAGIC ? readArchiveLog(file, loaded, &end)
+                                          : readArchiveSegments(file, header[1], header[0] == ARCHIVE_MAGIC_V1, loaded);
+     fclose(file);
+     // One bad row rejects the whole file rather than losing rows silently.
+     for (guint s = 0; ok && s < loaded->len; s++) {
+         ok = archiveRowsValid(g_ptr_array_index(loaded, s), ARCHIVE_ROW_FIELDS);
+     }
+     if (!ok) {
+         for (guint s = 0; s < loaded->len; s++) {
+             freeArchiveSegment(g_ptr_array_index(loaded, s));
+         }
+         g_ptr_array_free(loaded, TRUE);
+         addNotification("Ignoring truncated or corrupt flight archive", false, true);
+         return false;
+     }
+     int rows = 0;
+     for (guint s = 0; s < loaded->len; s++) {
+         rows += ((ArchiveSegment *)g_ptr_array_index(loaded, s))->rowCount;
+     }
+     if (loaded->len > 0) {
+         ArchiveSegment *last = g_ptr_array_index(loaded, loaded->len - 1);
+         if (last->rowCount < ARCHIVE_SEGMENT_FLIGHTS) reopenArchiveSegment(last);
+     }
+ 
+     g_mutex_lock(&archiveLock);
+     if (archiveSegments) g_ptr_array_free(archiveSegments, TRUE);
+     archiveSegments = loaded;
+     archivedFlightCount = rows;
+     archiveFileLoaded = true;
+     markArchiveSaved(end);
+     g_mutex_unlock(&archiveLock);
+ 
+     GHashTable *history = newDelaySketchTable();
+     scanArchive(NULL, G_MININT, G_MAXINT, addArchivedDelay, history);
+     g_mutex_lock(&delaySketchLock);
+     if (delayHistory) g_hash_table_destroy(delayHistory);
+     delayHistory = history;
+     g_mutex_unlock(&delaySketchLock);
+     return true;
+ }
+ 
+ // searchResultRows holds row indexes into the published version
+ // searchResultVersion. Once the schedule has moved on, the search is run
+ // again against the current version so the indexes never point at rows that
+ // have since moved.
+ static void findSearchMatches(const ScheduleState *state) {
+     searchResultVersion = state->version;
+     if (strpbrk(searchTerm, "=<>~")) {
+         FilterPlan plan;
+         char error[128];
+         if (compileFilter(searchTerm, &plan, error, sizeof(error))) {
+             runFilter(&plan, state, searchResultRows);
+         } else {
+             g_array_set_size(searchResultRows, 0);
+         }
+     } else {
+         searchFlights(searchTerm, searchResultRows);
+     }
+ }
+ 
+ // Live matches are listed first, then archived ones. Only the rows on the
+ // page are read, from the version pinned while the page is filled.
+ static void show_search_page() {
+     gtk_list_store_clear(searchPageStore);
+ 
+     const ScheduleState *state = NULL;
+     if (searchReaderSlot < 0) searchReaderSlot = registerStateReader();
+     if (searchReaderSlot >= 0) state = pinScheduleState(searchReaderSlot);
+     if (state && searchTerm && state->version != searchResultVersion) findSearchMatches(state);
+ 
+     int live = state && searchResultRows ? (int)searchResultRows->len : 0;
+     int total = live + (searchArchiveRows ? (int)searchArchiveRows->len : 0);
+     searchPage = MIN(searchPage, MAX((total + SEARCH_PAGE_SIZE - 1) / SEARCH_PAGE_SIZE - 1, 0));
+     int first = searchPage * SEARCH_PAGE_SIZE;
+     int last = MIN(first + SEARCH_PAGE_SIZE, total);
+ 
+     for (int r = first; r < last; r++) {
+         const Flight *flight;
+         const ArchivedFlight *archived = NULL;
+         if (r < live) {
+             int row = g_array_index(searchResultRows, int, r);
+             if (row >= state->flightCount) continue;
+             flight = &state->flights[row];
+         } else {
+             archived = &g_array_index(searchArchiveRows, ArchivedFlight, r - live);
+             flight = &archived->flight;
+         }
+         const char* statusStr;
+         switch(flight->status) {
+             case SCHEDULED: statusStr = "Scheduled"; break;
+             case DELAYED: statusStr = "Delayed"; break;
+             case CANCELLED: statusStr = "Cancelled"; break;
+             case EMERGENCY_STATUS: statusStr = "Emergency"; break;
+             default: statusStr = "Unknown";
+         }
+         char archivedStatus[64];
+         if (archived) {
+             char date[16];
+             formatArchiveDay(archived->day, date, sizeof(date));
+             snprintf(archivedStatus, sizeof(archivedStatus), "%s (archived %s)", statusStr, date);
+             statusStr = archivedStatus;
+         }
+         char departure[8], arrival[8];
+         snprintf(departure, sizeof(departure), "%02d:%02d",
+                  flight->departureTime.hour, flight->departureTime.minute);
+         snprintf(arrival, sizeof(arrival), "%02d:%02d",
+                  flight->arrivalTime.hour, flight->arrivalTime.minute);
+ 
+         GtkTreeIter iter;
+         gtk_list_store_insert_with_values(searchPageStore, &iter, -1,
+                                           0, flight->flightID,
+                                           1, flight->origin,
+                                           2, flight->destination,
+                                           3, flight->aircraftType,
+                                           4, departure,
+                                           5, arrival,
+                                           6, statusStr,
+                                           -1);
+     }
+ 
+     char summary[128];
+     if (total == 0) {
+         snprintf(summary, sizeof(summary), "No flights found matching the search term");
+     } else {
+         snprintf(summary, sizeof(summary), "Showing %d-%d of %d", first + 1, last, total);
+     }
+     gtk_label_set_text(GTK_LABEL(search_page_label), summary);
+     gtk_widget_set_sensitive(search_prev_button, searchPage > 0);
+     gtk_widget_set_sensitive(search_next_button, last < total);
+     if (state) unpinScheduleState(searchReaderSlot);
+ }
+ 
+ void on_search_clicked(GtkWidget *widget, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     const char *search_term = gtk_entry_get_text(GTK_ENTRY(search_entry));
+     if (!searchResultRows) searchResultRows = g_array_new(FALSE, FALSE, sizeof(int));
+     if (!searchArchiveRows) searchArchiveRows = g_array_new(FALSE, FALSE, sizeof(ArchivedFlight));
+     g_array_set_size(searchResultRows, 0);
+     g_array_set_size(searchArchiveRows, 0);
+     g_free(searchTerm);
+     searchTerm = NULL;
+     searchPage = 0;
+ 
+     if (strpbrk(search_term, "=<>~")) {
+         FilterPlan plan;
+         char error[128];
+         if (!compileFilter(search_term, &plan, error, sizeof(error))) {
+             show_search_page();
+             gtk_label_set_text(GTK_LABEL(search_page_label), error);
+             return;
+         }
+     } else {
+         searchArchive(search_term, searchArchiveRows);
+     }
+     // The live matches are found by show_search_page() against the version
+     // it pins.
+     searchTerm = g_strdup(search_term);
+     searchResultVersion = G_MAXUINT64;
+     show_search_page();
+ 
+     if (strlen(search_term) == 0) {
+         gtk_label_set_text(GTK_LABEL(search_page_label), "Please enter a search term");
+     }
+ }
+ 
+ void on_search_page_clicked(GtkWidget *widget, gpointer data) {
+     int step = GPOINTER_TO_INT(data);
+     int total = (searchResultRows ? (int)searchResultRows->len : 0) +
+                 (searchArchiveRows ? (int)searchArchiveRows->len : 0);
+     int pages = (total + SEARCH_PAGE_SIZE - 1) / SEARCH_PAGE_SIZE;
+ 
+     searchPage = CLAMP(searchPage + step, 0, MAX(pages - 1, 0));
+     show_search_page();
+ }
+ 
+ // Report engine. Reports are generated on a worker thread from a pinned
+ // ScheduleState, so the UI stays responsive however large the schedule is.
+ // Output goes through a ReportWriter that batches bytes into a fixed buffer
+ // and formats integers and times by hand instead of via printf. The same
+ // writer fills the on-screen preview, capped at REPORT_PREVIEW_ROWS rows.
+ static const char reportTwoDigits[] =
+     "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+     "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+ 
+ static void reportFlush(ReportWriter *w) {
+     if (w->used == 0) return;
+     if (w->file) {
+         if (fwrite(w->buffer, 1, w->used, w->file) != w->used) w->failed = true;
+     } else if (w->text) {
+         g_string_append_len(w->text, w->buffer, w->used);
+     }
+     w->used = 0;
+ }
+ 
+ static void reportWrite(ReportWriter *w, const char *data, size_t length) {
+     if (length > sizeof(w->buffer) - w->used) {
+         reportFlush(w);
+         if (length >= sizeof(w->buffer)) {
+             if (w->file && fwrite(data, 1, length, w->file) != length) w->failed = true;
+             if (w->text) g_string_append_len(w->text, data, length);
+             return;
+         }
+     }
+     memcpy(w->buffer + w->used, data, length);
+     w->used += length;
+ }
+ 
+ static void reportPuts(ReportWriter *w, const char *text) {
+     reportWrite(w, text, strlen(text));
+ }
+ 
+ static void reportPutInt(ReportWriter *w, long value) {
+     char digits[24];
+     int n = 0;
+     unsigned long magnitude = value < 0 ? -(unsigned long)value : (unsigned long)value;
+     while (magnitude >= 100) {
+         int pair = (int)(magnitude % 100) * 2;
+         magnitude /= 100;
+         digits[sizeof(digits) - 1 - n++] = reportTwoDigits[pair + 1];
+         digits[sizeof(digits) - 1 - n++] = reportTwoDigits[pair];
+     }
+     if (magnitude >= 10) {
+         digits[sizeof(digits) - 1 - n++] = reportTwoDigits[magnitude * 2 + 1];
+         digits[sizeof(digits) - 1 - n++] = reportTwoDigits[magnitude * 2];
+     } else {
+         digits[sizeof(digits) - 1 - n++] = (char)('0' + magnitude);
+     }
+     if (value < 0) digits[sizeof(digits) - 1 - n++] = '-';
+     reportWrite(w, digits + sizeof(digits) - n, n);
+ }
+ 
+ static void reportPutTime(ReportWriter *w, Time t) {
+     char text[5];
+     memcpy(text, reportTwoDigits + CLAMP(t.hour, 0, 99) * 2, 2);
+     text[2] = ':';
+     memcpy(text + 3, reportTwoDigits + CLAMP(t.minute, 0, 99) * 2, 2);
+     reportWrite(w, text, sizeof(text));
+ }
+ 
+ static void reportPutEscaped(ReportWriter *w, const char *text) {
+     if (w->format == REPORT_TEXT) {
+         reportPuts(w, text);
          return;
      }
+     if (w->format == REPORT_CSV) {
+         if (!strpbrk(text, ",\"\n\r")) {
+             reportPuts(w, text);
+             return;
+         }
+         reportWrite(w, "\"", 1);
+     }
+ 
+     const char *run = text;
+     for (const char *c = text; *c; c++) {
+         const char *replacement = NULL;
+         char control[7];
+         if (w->format == REPORT_CSV) {
+             if (*c == '"') replacement = "\"\"";
+         } else if (w->format == REPORT_JSON) {
+             if (*c == '"') replacement = "\\\"";
+             else if (*c == '\\') replacement = "\\\\";
+             else if ((unsigned char)*c < 0x20) {
+                 snprintf(control, sizeof(control), "\\u%04x", (unsigned char)*c);
+                 replacement = control;
+             }
+         } else if (w->format == REPORT_HTML) {
+             if (*c == '&') replacement = "&amp;";
+             else if (*c == '<') replacement = "&lt;";
+             else if (*c == '>') replacement = "&gt;";
+             else if (*c == '"') replacement = "&quot;";
+         }
+         if (replacement) {
+             reportWrite(w, run, c - run);
+             reportPuts(w, replacement);
+             run = c + 1;
+         }
+     }
+     reportPuts(w, run);
+     if (w->format == REPORT_CSV) reportWrite(w, "\"", 1);
+ }
+ 
+ static void reportBeginDocument(ReportWriter *w, const char *key, const char *title) {
+     switch (w->format) {
+         case REPORT_TEXT:
+             reportPuts(w, title);
+             reportPuts(w, "\n");
+             for (size_t i = 0; i < strlen(title); i++) reportWrite(w, "=", 1);
+             reportPuts(w, "\n\n");
+             break;
+         case REPORT_JSON:
+             reportPuts(w, "{\"report\":\"");
+             reportPuts(w, key);
+             reportPuts(w, "\"");
+             break;
+         case REPORT_HTML:
+             reportPuts(w, "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>");
+             reportPuts(w, title);
+             reportPuts(w, "</title></head>\n<body>\n<h1>");
+             reportPuts(w, title);
+             reportPuts(w, "</h1>\n");
+             break;
+         default:
+             break;
+     }
+ }
+ 
+ static void reportEndDocument(ReportWriter *w) {
+     if (w->format == REPORT_JSON) reportPuts(w, "}\n");
+     else if (w->format == REPORT_HTML) reportPuts(w, "</body></html>\n");
+ }
+ 
+ static void reportSummaryInt(ReportWriter *w, const char *key, const char *label, long value) {
+     switch (w->format) {
+         case REPORT_TEXT:
+             reportPuts(w, label);
+             reportPuts(w, ": ");
+             reportPutInt(w, value);
+             reportPuts(w, "\n");
+             break;
+         case REPORT_JSON:
+             reportPuts(w, w->summaryFields == 0 ? ",\"summary\":{\"" : ",\"");
+             reportPuts(w, key);
+             reportPuts(w, "\":");
+             reportPutInt(w, value);
+             break;
+         case REPORT_HTML:
+             reportPuts(w, w->summaryFields == 0 ? "<ul>\n<li>" : "<li>");
+             reportPuts(w, label);
+             reportPuts(w, ": ");
+             reportPutInt(w, value);
+             reportPuts(w, "</li>\n");
+             break;
+         default:
+             break;
+     }
+     w->summaryFields++;
+ }
+ 
+ static void reportEndSummary(ReportWriter *w) {
+     if (w->summaryFields > 0) {
+         if (w->format == REPORT_TEXT) reportPuts(w, "\n");
+         else if (w->format == REPORT_JSON) reportPuts(w, "}");
+         else if (w->format == REPORT_HTML) reportPuts(w, "</ul>\n");
+     }
+     w->summaryFields = 0;
+ }
+ 
+ static void reportBeginTable(ReportWriter *w, const char *const *columns, int columnCount) {
+     w->columns = columns;
+     w->rows = 0;
+     switch (w->format) {
+         case REPORT_JSON:
+             reportPuts(w, ",\"rows\":[");
+             return;
+         case REPORT_HTML:
+             reportPuts(w, "<table>\n<thead><tr>");
+             for (int c = 0; c < columnCount; c++) {
+                 reportPuts(w, "<th>");
+                 reportPuts(w, columns[c]);
+                 reportPuts(w, "</th>");
+             }
+             reportPuts(w, "</tr></thead>\n<tbody>\n");
+             return;
+         default:
+             for (int c = 0; c < columnCount; c++) {
+                 if (c > 0) reportPuts(w, w->format == REPORT_CSV ? "," : " | ");
+                 reportPuts(w, columns[c]);
+             }
+             reportPuts(w, "\n");
+             return;
+     }
+ }
+ 
+ static void reportEndTable(ReportWriter *w) {
+     if (w->format == REPORT_JSON) reportPuts(w, "\n]");
+     else if (w->format == REPORT_HTML) reportPuts(w, "</tbody></table>\n");
+ }
+ 
+ static void reportBeginRow(ReportWriter *w) {
+     w->field = 0;
+     if (w->format == REPORT_JSON) reportPuts(w, w->rows == 0 ? "\n{" : ",\n{");
+     else if (w->format == REPORT_HTML) reportPuts(w, "<tr>");
+ }
+ 
+ static void reportEndRow(ReportWriter *w) {
+     if (w->format == REPORT_JSON) reportPuts(w, "}");
+     else if (w->format == REPORT_HTML) reportPuts(w, "</tr>\n");
+     else reportPuts(w, "\n");
+     w->rows++;
+ }
+ 
+ static void reportFieldStart(ReportWriter *w) {
+     switch (w->format) {
+         case REPORT_CSV:
+             if (w->field > 0) reportWrite(w, ",", 1);
+             break;
+         case REPORT_TEXT:
+             if (w->field > 0) reportPuts(w, " | ");
+             break;
+         case REPORT_JSON:
+             reportPuts(w, w->field > 0 ? ",\"" : "\"");
+             reportPuts(w, w->columns[w->field]);
+             reportPuts(w, "\":");
+             break;
+         case REPORT_HTML:
+             reportPuts(w, "<td>");
+             break;
+     }
+ }
+ 
+ static void reportFieldEnd(ReportWriter *w) {
+     if (w->format == REPORT_HTML) reportPuts(w, "</td>");
+     w->field++;
+ }
+ 
+ static void reportFieldText(ReportWriter *w, const char *value) {
+     reportFieldStart(w);
+     if (w->format == REPORT_JSON) reportWrite(w, "\"", 1);
+     reportPutEscaped(w, value);
+     if (w->format == REPORT_JSON) reportWrite(w, "\"", 1);
+     reportFieldEnd(w);
+ }
+ 
+ static void reportFieldInt(ReportWriter *w, long value) {
+     reportFieldStart(w);
+     reportPutInt(w, value);
+     reportFieldEnd(w);
+ }
+ 
+ static void reportFieldTime(ReportWriter *w, Time value) {
+     reportFieldStart(w);
+     if (w->format == REPORT_JSON) reportWrite(w, "\"", 1);
+     reportPutTime(w, value);
+     if (w->format == REPORT_JSON) reportWrite(w, "\"", 1);
+     reportFieldEnd(w);
+ }
+ 
+ static void reportFieldBool(ReportWriter *w, bool value) {
+     reportFieldStart(w);
+     if (w->format == REPORT_JSON) reportPuts(w, value ? "true" : "false");
+     else reportPuts(w, value ? "yes" : "no");
+     reportFieldEnd(w);
+ }
+ 
+ static const char* flightStatusName(FlightStatus status) {
+     switch (status) {
+         case SCHEDULED: return "Scheduled";
+         case DELAYED: return "Delayed";
+         case CANCELLED: return "Cancelled";
+         case EMERGENCY_STATUS: return "Emergency";
+         default: return "Unknown";
+     }
+ }
+ 
+ static const char* flightPriorityName(FlightPriority priority) {
+     switch (priority) {
+         case EMERGENCY: return "Emergency";
+         case INTERNATIONAL: return "International";
+         case DOMESTIC: return "Domestic";
+         default: return "Unknown";
+     }
+ }
+ 
+ static const char* runwayTypeName(RunwayType type) {
+     switch (type) {
+         case ALL_FLIGHTS: return "All Flights";
+         case INTERNATIONAL_ONLY: return "International Only";
+         case CARGO_ONLY: return "Cargo Only";
+         default: return "Unknown";
+     }
+ }
+ 
+ static gint compareDelayEntries(gconstpointer a, gconstpointer b) {
+     const DelaySketchEntry *left = *(DelaySketchEntry *const *)a;
+     const DelaySketchEntry *right = *(DelaySketchEntry *const *)b;
+     return strcmp(left->route, right->route);
+ }
+ 
+ // Writes one report over the snapshot and returns the number of detail rows
+ // in it; at most rowLimit of them are written.
+ static void describeScheduleRow(char *buffer, size_t size, const ScheduleState *state, int table, int index) {
+     if (index < 0) {
+         buffer[0] = '\0';
+     } else if (table == UNDO_FLIGHTS) {
+         const Flight *f = &state->flights[index];
+         snprintf(buffer, size, "%s %02d:%02d-%02d:%02d runway %d crew %d delay %d",
+                  flightStatusName(f->status), f->departureTime.hour, f->departureTime.minute,
+                  f->arrivalTime.hour, f->arrivalTime.minute, f->runwayAssigned, f->crewAssigned, f->delayMinutes);
+     } else if (table == UNDO_RUNWAYS) {
+         const Runway *r = &state->runways[index];
+         snprintf(buffer, size, "%s, next %02d:%02d", r->isAvailable ? "available" : "closed",
+                  r->nextAvailableTime.hour, r->nextAvailableTime.minute);
+     } else {
+         const Crew *c = &state->crews[index];
+         snprintf(buffer, size, "%s, duty %d min, free %02d:%02d", c->isAvailable ? "available" : "on duty",
+                  c->dutyMinutesToday, c->lastFlightEnd.hour, c->lastFlightEnd.minute);
+     }
+ }
+ 
+ // Rows that differ between job->before and state. Flights are matched by
+ // ID, runways and crew by position.
+ static GArray* collectScheduleChanges(const ScheduleState *before, const ScheduleState *after) {
+     GArray *changes = g_array_new(FALSE, FALSE, sizeof(ScheduleChange));
+     ScheduleChange change;
+ 
+     GHashTable *byID = g_hash_table_new(g_str_hash, g_str_equal);
+     for (int i = 0; i < before->flightCount; i++) {
+         g_hash_table_insert(byID, (gpointer)before->flights[i].flightID, GINT_TO_POINTER(i + 1));
+     }
+     for (int i = 0; i < after->flightCount; i++) {
+         int match = GPOINTER_TO_INT(g_hash_table_lookup(byID, after->flights[i].flightID)) - 1;
+         if (match >= 0) g_hash_table_remove(byID, after->flights[i].flightID);
+         if (match >= 0 && memcmp(&before->flights[match], &after->flights[i], sizeof(Flight)) == 0) continue;
+         change = (ScheduleChange){UNDO_FLIGHTS, match, i};
+         g_array_append_val(changes, change);
+     }
+     for (int i = 0; i < before->flightCount; i++) {
+         if (GPOINTER_TO_INT(g_hash_table_lookup(byID, before->flights[i].flightID)) != i + 1) continue;
+         change = (ScheduleChange){UNDO_FLIGHTS, i, -1};
+         g_array_append_val(changes, change);
+     }
+     g_hash_table_destroy(byID);
+ 
+     for (int i = 0; i < MAX(before->runwayCount, after->runwayCount); i++) {
+         bool inBefore = i < before->runwayCount, inAfter = i < after->runwayCount;
+         if (inBefore && inAfter && memcmp(&before->runways[i], &after->runways[i], sizeof(Runway)) == 0) continue;
+         change = (ScheduleChange){UNDO_RUNWAYS, inBefore ? i : -1, inAfter ? i : -1};
+         g_array_append_val(changes, change);
+     }
+     for (int i = 0; i < MAX(before->crewCount, after->crewCount); i++) {
+         bool inBefore = i < before->crewCount, inAfter = i < after->crewCount;
+         if (inBefore && inAfter && memcmp(&before->crews[i], &after->crews[i], sizeof(Crew)) == 0) continue;
+         change = (ScheduleChange){UNDO_CREW, inBefore ? i : -1, inAfter ? i : -1};
+         g_array_append_val(changes, change);
+     }
+     return changes;
+ }
+ 
+ static bool writeArchivedRow(const ArchivedFlight *row, void *context) {
+     ArchiveReportScan *scan = context;
+     if (scan->job->hasFilter && !flightMatchesFilter(&scan->job->filter, &row->flight)) return true;
+     if (scan->rows++ >= scan->rowLimit) return true;
+ 
+     char dateText[16];
+     formatArchiveDay(row->day, dateText, sizeof(dateText));
+ 
+     const Flight *f = &row->flight;
+     ReportWriter *w = scan->w;
+     reportBeginRow(w);
+     reportFieldText(w, dateText);
+     reportFieldText(w, f->flightID);
+     reportFieldText(w, f->origin);
+     reportFieldText(w, f->destination);
+     reportFieldTime(w, f->departureTime);
+     reportFieldTime(w, f->arrivalTime);
+     reportFieldText(w, flightStatusName(f->status));
+     reportFieldText(w, flightPriorityName(f->priority));
+     reportFieldInt(w, f->runwayAssigned);
+     reportFieldInt(w, f->crewAssigned);
+     reportFieldInt(w, f->delayMinutes);
+     reportFieldBool(w, f->isCargo);
+     reportEndRow(w);
+     return true;
+ }
+ 
+ static int writeReport(ReportWriter *w, const ReportJob *job, const ScheduleState *state, int rowLimit) {
+     int total = 0;
+ 
+     if (job->kind == REPORT_FLIGHTS) {
+         static const char *const columns[] = {
+             "id", "origin", "destination", "departure", "arrival", "status",
+             "priority", "runway", "crew", "delay", "cargo"
+         };
+         GArray *rows = NULL;
+         if (job->hasFilter) {
+             rows = g_array_new(FALSE, FALSE, sizeof(int));
+             runFilter(&job->filter, state, rows);
+         }
+         total = rows ? (int)rows->len : state->flightCount;
+ 
+         int filteredCounts[4] = {0};
+         const int *counts = state->aggregates.statusCounts;
+         if (rows) {
+             for (int r = 0; r < total; r++) {
+                 filteredCounts[CLAMP((int)state->flights[g_array_index(rows, int, r)].status, 0, 3)]++;
+             }
+             counts = filteredCounts;
+         }
+ 
+         reportBeginDocument(w, "flights", "FLIGHT REPORT");
+         reportSummaryInt(w, "total", "Total flights", total);
+         reportSummaryInt(w, "scheduled", "Scheduled", counts[SCHEDULED]);
+         reportSummaryInt(w, "delayed", "Delayed", counts[DELAYED]);
+         reportSummaryInt(w, "cancelled", "Cancelled", counts[CANCELLED]);
+         reportSummaryInt(w, "emergency", "Emergency", counts[EMERGENCY_STATUS]);
+         reportEndSummary(w);
+ 
+         reportBeginTable(w, columns, G_N_ELEMENTS(columns));
+         for (int r = 0; r < total && r < rowLimit; r++) {
+             const Flight *f = &state->flights[rows ? g_array_index(rows, int, r) : r];
+             reportBeginRow(w);
+             reportFieldText(w, f->flightID);
+             reportFieldText(w, f->origin);
+             reportFieldText(w, f->destination);
+             reportFieldTime(w, f->departureTime);
+             reportFieldTime(w, f->arrivalTime);
+             reportFieldText(w, flightStatusName(f->status));
+             reportFieldText(w, flightPriorityName(f->priority));
+             reportFieldInt(w, f->runwayAssigned);
+             reportFieldInt(w, f->crewAssigned);
+             reportFieldInt(w, f->delayMinutes);
+             reportFieldBool(w, f->isCargo);
+             reportEndRow(w);
+         }
+         reportEndTable(w);
+         if (rows) g_array_free(rows, TRUE);
+     } else if (job->kind == REPORT_CHANGES) {
+         static const char *const columns[] = {"table", "id", "change", "before", "after"};
+         static const char *const tableNames[] = {"flight", "runway", "crew"};
+         GArray *changes = collectScheduleChanges(job->before, state);
+         total = changes->len;
+ 
+         int added = 0, removed = 0;
+         for (int i = 0; i < total; i++) {
+             const ScheduleChange *c = &g_array_index(changes, ScheduleChange, i);
+             if (c->before < 0) added++;
+             if (c->after < 0) removed++;
+         }
+ 
+         reportBeginDocument(w, "changes", "SCHEDULE CHANGES REPORT");
+         reportSummaryInt(w, "before_version", "From version", (long)job->before->version);
+         reportSummaryInt(w, "after_version", "To version", (long)state->version);
+         reportSummaryInt(w, "added", "Added", added);
+         reportSummaryInt(w, "removed", "Removed", removed);
+         reportSummaryInt(w, "changed", "Changed", total - added - removed);
+         reportEndSummary(w);
+ 
+         reportBeginTable(w, columns, G_N_ELEMENTS(columns));
+         char id[STR_LEN], before[160], after[160];
+         for (int i = 0; i < total && i < rowLimit; i++) {
+             const ScheduleChange *c = &g_array_index(changes, ScheduleChange, i);
+             if (c->table == UNDO_FLIGHTS) {
+                 g_strlcpy(id, c->after >= 0 ? state->flights[c->after].flightID : job->before->flights[c->before].flightID, sizeof(id));
+             } else {
+                 snprintf(id, sizeof(id), "%d", c->table == UNDO_RUNWAYS
+                          ? (c->after >= 0 ? state->runways[c->after].id : job->before->runways[c->before].id)
+                          : (c->after >= 0 ? state->crews[c->after].id : job->before->crews[c->before].id));
+             }
+             describeScheduleRow(before, sizeof(before), job->before, c->table, c->before);
+             describeScheduleRow(after, sizeof(after), state, c->table, c->after);
+             reportBeginRow(w);
+             reportFieldText(w, tableNames[c->table]);
+             reportFieldText(w, id);
+             reportFieldText(w, c->before < 0 ? "added" : c->after < 0 ? "removed" : "changed");
+             reportFieldText(w, before);
+             reportFieldText(w, after);
+             reportEndRow(w);
+         }
+         reportEndTable(w);
+         g_array_free(changes, TRUE);
+     } else if (job->kind == REPORT_ARCHIVE) {
+         static const char *const columns[] = {
+             "date", "id", "origin", "destination", "departure", "arrival", "status",
+             "priority", "runway", "crew", "delay", "cargo"
+         };
+         int segments, archived;
+         gsize storedBytes;
+         archiveStats(&segments, &archived, &storedBytes);
+ 
+         reportBeginDocument(w, "archive", "FLIGHT ARCHIVE REPORT");
+         reportSummaryInt(w, "archived", "Archived flights", archived);
+         reportSummaryInt(w, "segments", "Segments", segments);
+         reportSummaryInt(w, "stored_bytes", "Stored bytes", (long)storedBytes);
+         reportSummaryInt(w, "stored_pct", "Size vs. flight records (%)",
+                          archived > 0 ? (long)(storedBytes * 100 / (archived * sizeof(Flight))) : 0);
+         reportEndSummary(w);
+ 
+         reportBeginTable(w, columns, G_N_ELEMENTS(columns));
+         ArchiveReportScan scan = {w, job, rowLimit, 0};
+         scanArchive(NULL, G_MININT, G_MAXINT, writeArchivedRow, &scan);
+         reportEndTable(w);
+         total = scan.rows;
+     } else if (job->kind == REPORT_RUNWAYS) {
+         static const char *const columns[] = {
+             "runway", "type", "available", "next_available", "flights", "busy_minutes", "utilization_pct"
+         };
+         const ScheduleAggregates *a = &state->aggregates;
+         total = state->runwayCount;
+ 
+         int peakHour = 0;
+         for (int h = 1; h < 24; h++) {
+             if (a->departuresByHour[h] + a->arrivalsByHour[h] >
+                 a->departuresByHour[peakHour] + a->arrivalsByHour[peakHour]) {
+                 peakHour = h;
+             }
+         }
+ 
+         reportBeginDocument(w, "runways", "RUNWAY UTILIZATION REPORT");
+         reportSummaryInt(w, "available", "Runways available", a->runwaysAvailable);
+         reportSummaryInt(w, "peak_hour", "Busiest hour", peakHour);
+         reportSummaryInt(w, "peak_hour_movements", "Movements in busiest hour",
+                          a->departuresByHour[peakHour] + a->arrivalsByHour[peakHour]);
+         reportEndSummary(w);
+ 
+         reportBeginTable(w, columns, G_N_ELEMENTS(columns));
+         for (int i = 0; i < total && i < rowLimit; i++) {
+             const Runway *r = &state->runways[i];
+             reportBeginRow(w);
+             reportFieldInt(w, r->id);
+             reportFieldText(w, runwayTypeName(r->type));
+             reportFieldBool(w, r->isAvailable);
+             reportFieldTime(w, r->nextAvailableTime);
+             reportFieldInt(w, i < config.maxRunways ? a->runwayFlights[i] : 0);
+             reportFieldInt(w, i < config.maxRunways ? a->runwayBusyMinutes[i] : 0);
+             reportFieldInt(w, i < config.maxRunways ? a->runwayBusyMinutes[i] * 100 / MINUTES_PER_DAY : 0);
+             reportEndRow(w);
+         }
+         reportEndTable(w);
+     } else if (job->kind == REPORT_CREW) {
+         static const char *const columns[] = {"crew", "name", "available", "duty_minutes", "near_limit"};
+         const ScheduleAggregates *a = &state->aggregates;
+         total = state->crewCount;
+ 
+         reportBeginDocument(w, "crew", "CREW STATUS REPORT");
+         reportSummaryInt(w, "available", "Available crew", a->crewAvailable);
+         reportSummaryInt(w, "on_duty", "On duty", a->crewOnDuty);
+         reportSummaryInt(w, "near_limit", "Approaching duty limits", a->dutyWatchCount);
+         reportEndSummary(w);
+ 
+         reportBeginTable(w, columns, G_N_ELEMENTS(columns));
+         for (int i = 0; i < total && i < rowLimit; i++) {
+             const Crew *c = &state->crews[i];
+             reportBeginRow(w);
+             reportFieldInt(w, c->id);
+             reportFieldText(w, c->name);
+             reportFieldBool(w, c->isAvailable);
+             reportFieldInt(w, c->dutyMinutesToday);
+             reportFieldBool(w, crewOnDutyWatch(a, i));
+             reportEndRow(w);
+         }
+         reportEndTable(w);
+     } else {
+         static const char *const columns[] = {"route", "flights", "mean", "p50", "p90", "p95", "p99"};
+         GHashTable *routes = collectRouteDelays();
+         GPtrArray *entries = g_ptr_array_new();
+         DelaySketch overall = {0};
+ 
+         GHashTableIter iter;
+         gpointer value;
+         g_hash_table_iter_init(&iter, routes);
+         while (g_hash_table_iter_next(&iter, NULL, &value)) {
+             g_ptr_array_add(entries, value);
+             mergeDelaySketch(&overall, &((DelaySketchEntry *)value)->sketch);
+         }
+         g_ptr_array_sort(entries, compareDelayEntries);
+         total = entries->len;
+ 
+         reportBeginDocument(w, "delays", "DELAY PERCENTILE REPORT");
+         reportSummaryInt(w, "routes", "Routes", total);
+         reportSummaryInt(w, "flights", "Flights", overall.count);
+         reportSummaryInt(w, "p50", "Median delay (min)", delaySketchQuantile(&overall, 0.50));
+         reportSummaryInt(w, "p95", "95th percentile delay (min)", delaySketchQuantile(&overall, 0.95));
+         reportEndSummary(w);
+ 
+         reportBeginTable(w, columns, G_N_ELEMENTS(columns));
+         for (int i = 0; i < total && i < rowLimit; i++) {
+             const DelaySketchEntry *entry = g_ptr_array_index(entries, i);
+             reportBeginRow(w);
+             reportFieldText(w, entry->route);
+             reportFieldInt(w, entry->sketch.count);
+             reportFieldInt(w, entry->sketch.count > 0 ? entry->sketch.totalMinutes / entry->sketch.count : 0);
+             reportFieldInt(w, delaySketchQuantile(&entry->sketch, 0.50));
+             reportFieldInt(w, delaySketchQuantile(&entry->sketch, 0.90));
+             reportFieldInt(w, delaySketchQuantile(&entry->sketch, 0.95));
+             reportFieldInt(w, delaySketchQuantile(&entry->sketch, 0.99));
+             reportEndRow(w);
+         }
+         reportEndTable(w);
+ 
+         g_ptr_array_free(entries, TRUE);
+         g_hash_table_destroy(routes);
+     }
+ 
+     reportEndDocument(w);
+     reportFlush(w);
+     return total;
+ }
+ 
+ static gpointer report_job_thread(gpointer data) {
+     SCOPED_TIMER(METRIC_REPORT);
+     traceThreadName("report");
+     TRACE_SCOPE("report", "worker");
+     ReportJob *job = data;
+     gint64 started = g_get_monotonic_time();
+ 
+     int slot = registerStateReader();
+     if (slot < 0) {
+         snprintf(job->error, sizeof(job->error), "No free snapshot reader slot for the report");
+         g_idle_add(report_job_finished, job);
+         return NULL;
+     }
+     const ScheduleState *state = pinScheduleState(slot);
+ 
+     // Point-in-time reports run against states rebuilt from the history.
+     ScheduleState *asOfState = NULL, *compareState = NULL;
+     if (job->asOf) {
+         asOfState = materializeScheduleAt(job->asOf);
+         if (!asOfState) snprintf(job->error, sizeof(job->error), "No schedule history at the requested time");
+     }
+     if (job->compareTo) {
+         compareState = materializeScheduleAt(job->compareTo);
+         if (!compareState) snprintf(job->error, sizeof(job->error), "No schedule history at the comparison time");
+     }
+     if (job->kind == REPORT_CHANGES) {
+         job->before = asOfState;
+         if (compareState) state = compareState;
+     } else if (asOfState) {
+         state = asOfState;
+     }
+     job->version = state ? state->version : 0;
+ 
+     ReportWriter *w = g_new0(ReportWriter, 1);
+     if (state && job->error[0] == '\0' && job->format != REPORT_TEXT) {
+         w->format = job->format;
+         w->file = fopen(job->path, "w");
+         if (!w->file) {
+             snprintf(job->error, sizeof(job->error), "Cannot open %s: %s", job->path, g_strerror(errno));
+         } else {
+             job->rows = writeReport(w, job, state, G_MAXINT);
+             if (fclose(w->file) != 0) w->failed = true;
+             if (w->failed) snprintf(job->error, sizeof(job->error), "Error writing %s", job->path);
+         }
+     }
  
-     int flightIndex = rand() % flightCount;
-     
-     flights[flightIndex].departureTime = 
-         addMinutesToTime(flights[flightIndex].departureTime, delayMinutes);
-     flights[flightIndex].arrivalTime = 
-         addMinutesToTime(flights[flightIndex].arrivalTime, delayMinutes);
-     flights[flightIndex].delayMinutes += delayMinutes;
-     flights[flightIndex].status = DELAYED;
-     
-     char msg[STR_LEN*2];
-     sprintf(msg, "Weather delay: Flight %s delayed by %d minutes", 
-            flights[flightIndex].flightID, delayMinutes);
-     addNotification(msg, true, false);
+     if (state && job->error[0] == '\0') {
+         memset(w, 0, sizeof(ReportWriter));
+         w->format = REPORT_TEXT;
+         w->text = job->preview;
+         job->rows = writeReport(w, job, state, REPORT_PREVIEW_ROWS);
+         if (job->rows > REPORT_PREVIEW_ROWS) {
+             g_string_append_printf(job->preview, "... %d more rows%s\n", job->rows - REPORT_PREVIEW_ROWS,
+                                    job->format == REPORT_TEXT ? " (export to a file for the full report)" : "");
+         }
+     }
+     g_free(w);
+ 
+     freeScheduleState(asOfState);
+     freeScheduleState(compareState);
+     unpinScheduleState(slot);
+     unregisterStateReader(slot);
+     job->elapsedUs = g_get_monotonic_time() - started;
+     g_idle_add(report_job_finished, job);
+     return NULL;
  }
  
- void handleEmergencyLanding() {
-     if (flightCount >= MAX_FLIGHTS) {
-         addNotification("Cannot add emergency flight - maximum reached", false, true);
-         return;
+ gboolean report_job_finished(gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     ReportJob *job = data;
+     char message[256];
+ 
+     if (job->error[0] != '\0') {
+         addNotification(job->error, false, true);
+         snprintf(message, sizeof(message), "%s", job->error);
+     } else {
+         GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(report_text));
+         gtk_text_buffer_set_text(buffer, job->preview->str, job->preview->len);
+         if (job->format == REPORT_TEXT) {
+             snprintf(message, sizeof(message), "Report generated: %d rows (version %" G_GUINT64_FORMAT ")",
+                      job->rows, job->version);
+         } else {
+             snprintf(message, sizeof(message), "Report written to %s: %d rows in %.2f s (version %" G_GUINT64_FORMAT ")",
+                      job->path, job->rows, job->elapsedUs / 1e6, job->version);
+         }
      }
+     gtk_label_set_text(GTK_LABEL(report_status_label), message);
  
-     Flight emergencyFlight;
-     strcpy(emergencyFlight.flightID, "EMG");
-     emergencyFlight.flightID[3] = '0' + (rand() % 10);
-     emergencyFlight.flightID[4] = '\0';
-     
-     strcpy(emergencyFlight.origin, "UNKNOWN");
-     strcpy(emergencyFlight.destination, "THIS AIRPORT");
-     strcpy(emergencyFlight.aircraftType, "UNKNOWN");
-     
-     Time now = getCurrentTime();
-     emergencyFlight.departureTime = now;
-     emergencyFlight.arrivalTime = addMinutesToTime(now, 5); 
-     emergencyFlight.status = EMERGENCY_STATUS;
-     emergencyFlight.runwayAssigned = -1;
-     emergencyFlight.crewAssigned = -1;
-     emergencyFlight.delayMinutes = 0;
-     emergencyFlight.isCargo = false;
-     
-     flights[flightCount] = emergencyFlight;
-     flightCount++;
-     
-     char msg[STR_LEN*2];
-     sprintf(msg, "EMERGENCY: Flight %s incoming!", emergencyFlight.flightID);
-     addNotification(msg, false, true);
-     
-
-     assignRunways();
-     scheduleCrew();
+     g_string_free(job->preview, TRUE);
+     g_free(job);
+     reportJobRunning = false;
+     return G_SOURCE_REMOVE;
  }
  
- void handleFlightCancellation() {
-     if (flightCount == 0) {
-         addNotification("No flights to cancel", false, true);
-         return;
+ // Parses "HH:MM" as the most recent such local time, today or yesterday,
+ // in microseconds since the epoch.
+ static bool parseReportInstant(const char *text, gint64 *instant) {
+     int hour, minute;
+     char extra;
+     if (sscanf(text, "%d:%d%c", &hour, &minute, &extra) != 2 ||
+         hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+         return false;
      }
  
-     int flightIndex = rand() % flightCount;
-     flights[flightIndex].status = CANCELLED;
-     
-     char msg[STR_LEN*2];
-     sprintf(msg, "Flight %s has been cancelled", flights[flightIndex].flightID);
-     addNotification(msg, false, true);
+     time_t now = time(NULL);
+     struct tm local;
+     localtime_r(&now, &local);
+     local.tm_hour = hour;
+     local.tm_min = minute;
+     local.tm_sec = 0;
+     time_t at = mktime(&local);
+     if (at > now) {
+         local.tm_mday--;
+         at = mktime(&local);
+     }
+     *instant = (gint64)at * G_USEC_PER_SEC;
+     return true;
  }
  
- void rescheduleFlights() {
-     if (flightCount == 0) {
-         addNotification("No flights to reschedule", false, true);
+ void start_report_job(ReportKind kind) {
+     static const char *const kindNames[] = {"flights", "runways", "crew", "delays", "changes", "archive"};
+     static const char *const extensions[] = {"txt", "csv", "json", "html"};
+ 
+     if (reportJobRunning) {
+         gtk_label_set_text(GTK_LABEL(report_status_label), "A report is already being generated");
          return;
      }
  
-     for (int i = 0; i < flightCount; i++) {
-         if (flights[i].status != CANCELLED) {
-             flights[i].runwayAssigned = -1;
-             flights[i].crewAssigned = -1;
-             flights[i].status = SCHEDULED;
-             flights[i].delayMinutes = 0;
+     ReportJob *job = g_new0(ReportJob, 1);
+     job->kind = kind;
+     job->format = (ReportFormat)CLAMP(gtk_combo_box_get_active(GTK_COMBO_BOX(report_format_combo)), 0, REPORT_HTML);
+     snprintf(job->path, sizeof(job->path), "%s_report.%s", kindNames[kind], extensions[job->format]);
+ 
+     const char *query = gtk_entry_get_text(GTK_ENTRY(report_filter_entry));
+     if ((kind == REPORT_FLIGHTS || kind == REPORT_ARCHIVE) && query[0] != '\0') {
+         char error[128];
+         if (!compileFilter(query, &job->filter, error, sizeof(error))) {
+             gtk_label_set_text(GTK_LABEL(report_status_label), error);
+             g_free(job);
+             return;
          }
+         job->hasFilter = true;
      }
-     
-     for (int i = 0; i < runwayCount; i++) {
-         runways[i].isAvailable = true;
-         runways[i].nextAvailableTime.hour = 0;
-         runways[i].nextAvailableTime.minute = 0;
+ 
+     // The delay and archive reports have no point-in-time view.
+     const char *asOf = gtk_entry_get_text(GTK_ENTRY(report_as_of_entry));
+     const char *compareTo = gtk_entry_get_text(GTK_ENTRY(report_compare_entry));
+     if (kind != REPORT_DELAYS && kind != REPORT_ARCHIVE && asOf[0] != '\0' && !parseReportInstant(asOf, &job->asOf)) {
+         gtk_label_set_text(GTK_LABEL(report_status_label), "As-of time must be HH:MM");
+         g_free(job);
+         return;
      }
-     
-     for (int i = 0; i < crewCount; i++) {
-         crews[i].isAvailable = true;
-         crews[i].dutyMinutesToday = 0;
-         crews[i].lastFlightEnd.hour = 0;
-         crews[i].lastFlightEnd.minute = 0;
+     if (kind == REPORT_CHANGES) {
+         if (!job->asOf) {
+             gtk_label_set_text(GTK_LABEL(report_status_label), "Enter an as-of time to compare from");
+             g_free(job);
+             return;
+         }
+         if (compareTo[0] != '\0' && !parseReportInstant(compareTo, &job->compareTo)) {
+             gtk_label_set_text(GTK_LABEL(report_status_label), "Compare-to time must be HH:MM");
+             g_free(job);
+             return;
+         }
      }
-     
-     assignRunways();
-     scheduleCrew();
-     
-     addNotification("All flights have been rescheduled", false, false);
- }
- 
  
- void on_login_clicked(GtkWidget *widget, gpointer data) {
-    const char *username = gtk_entry_get_text(GTK_ENTRY(username_entry));
-    const char *password = gtk_entry_get_text(GTK_ENTRY(password_entry));
-
-    if (strlen(username) == 0 || strlen(password) == 0) {
-        gtk_label_set_text(GTK_LABEL(notification_label), "Please enter both username and password");
-        return;
-    }
-
-    User authenticatedUser;
-    if (authenticateUser(username, password, &authenticatedUser)) {
-        currentUser = authenticatedUser;
-        
-        printf("Login successful for user: %s\n", currentUser.username);
-        
-        gtk_entry_set_text(GTK_ENTRY(password_entry), "");
-        
-        create_main_menu();
-        
-        gtk_widget_show_all(window);
-        
-        gtk_stack_set_visible_child_name(GTK_STACK(stack), "main_menu");
-        
-        char welcome_msg[256];
-        sprintf(welcome_msg, "Welcome, %s (%s)", 
-                currentUser.username,
-                currentUser.role == ADMIN ? "Admin" : 
-                currentUser.role == FLIGHT_SCHEDULER ? "Flight Scheduler" :
-                currentUser.role == CREW_SCHEDULER ? "Crew Scheduler" : "Viewer");
-        gtk_label_set_text(GTK_LABEL(notification_label), welcome_msg);
-    } else {
-        gtk_label_set_text(GTK_LABEL(notification_label), "Invalid username or password");
-    }
-}
-
+     job->preview = g_string_sized_new(64 * 1024);
+     reportJobRunning = true;
+     gtk_label_set_text(GTK_LABEL(report_status_label), "Generating report...");
+     g_thread_unref(g_thread_new("report", report_job_thread, job));
+ }
  
- void on_back_clicked(GtkWidget *widget, gpointer data) {
-     gtk_stack_set_visible_child_name(GTK_STACK(stack), "main_menu");
+ void on_generate_flights_report_clicked(GtkWidget *widget, gpointer data) {
+     start_report_job(REPORT_FLIGHTS);
  }
  
- void on_logout_clicked(GtkWidget *widget, gpointer data) {
-     gtk_stack_set_visible_child_name(GTK_STACK(stack), "login");
-     gtk_entry_set_text(GTK_ENTRY(username_entry), "");
-     gtk_entry_set_text(GTK_ENTRY(password_entry), "");
-     gtk_label_set_text(GTK_LABEL(notification_label), "Logged out successfully");
+ void on_generate_runways_report_clicked(GtkWidget *widget, gpointer data) {
+     start_report_job(REPORT_RUNWAYS);
  }
  
- void on_add_flight_clicked(GtkWidget *widget, gpointer data) {
-     addFlight();
-     update_flight_list();
-     update_schedule_list();
-     gtk_label_set_text(GTK_LABEL(notification_label), "Flight added successfully");
+ void on_generate_crew_report_clicked(GtkWidget *widget, gpointer data) {
+     start_report_job(REPORT_CREW);
  }
  
- void on_modify_flight_clicked(GtkWidget *widget, gpointer data) {
-     modifyFlight();
-     update_flight_list();
-     update_schedule_list();
-     gtk_label_set_text(GTK_LABEL(notification_label), "Flight modified successfully");
+ void on_generate_delays_report_clicked(GtkWidget *widget, gpointer data) {
+     start_report_job(REPORT_DELAYS);
  }
  
- void on_delete_flight_clicked(GtkWidget *widget, gpointer data) {
-     deleteFlight();
-     update_flight_list();
-     update_schedule_list();
-     gtk_label_set_text(GTK_LABEL(notification_label), "Flight deleted successfully");
+ void on_generate_changes_report_clicked(GtkWidget *widget, gpointer data) {
+     start_report_job(REPORT_CHANGES);
  }
  
- void on_assign_runways_clicked(GtkWidget *widget, gpointer data) {
-     assignRunways();
-     update_runway_list();
-     update_flight_list();
-     update_schedule_list();
-     gtk_label_set_text(GTK_LABEL(notification_label), "Runways assigned successfully");
+ void on_generate_archive_report_clicked(GtkWidget *widget, gpointer data) {
+     start_report_job(REPORT_ARCHIVE);
  }
  
- void on_schedule_crew_clicked(GtkWidget *widget, gpointer data) {
-     scheduleCrew();
-     update_crew_list();
-     update_flight_list();
-     update_schedule_list();
-     gtk_label_set_text(GTK_LABEL(notification_label), "Crew scheduled successfully");
+ // Columnar export (--export-history FILE). Archived flights are written as
+ // an uncompressed Parquet file that pyarrow, DuckDB or Spark read directly.
+ // Every EXPORT_ROW_GROUP_ROWS rows form a row group. Within a group, string
+ // columns are dictionary-encoded (a PLAIN dictionary page plus bit-packed
+ // indexes), integer columns use DELTA_BINARY_PACKED (zigzag varints of
+ // per-block minimum deltas, bit-packed in 32-value miniblocks) and every
+ // column chunk records min/max statistics, so a reader filtering on date,
+ // route or delay skips row groups without reading them. The footer is
+ // Thrift compact protocol, written by the helpers below.
+ static const ExportColumn exportColumns[EXPORT_COLUMNS] = {
+     {"date", PARQUET_INT32, 6},
+     {"flight_id", PARQUET_BYTE_ARRAY, 0},
+     {"origin", PARQUET_BYTE_ARRAY, 0},
+     {"destination", PARQUET_BYTE_ARRAY, 0},
+     {"aircraft_type", PARQUET_BYTE_ARRAY, 0},
+     {"departure_minute", PARQUET_INT32, -1},
+     {"arrival_minute", PARQUET_INT32, -1},
+     {"status", PARQUET_BYTE_ARRAY, 0},
+     {"priority", PARQUET_BYTE_ARRAY, 0},
+     {"runway", PARQUET_INT32, -1},
+     {"crew", PARQUET_INT32, -1},
+     {"delay_minutes", PARQUET_INT32, -1},
+     {"cargo", PARQUET_BOOLEAN, -1}
+ };
+ 
+ static void thriftVarint(GByteArray *out, guint64 value) {
+     guint8 bytes[10];
+     int n = 0;
+     while (value >= 0x80) {
+         bytes[n++] = (guint8)(value | 0x80);
+         value >>= 7;
+     }
+     bytes[n++] = (guint8)value;
+     g_byte_array_append(out, bytes, n);
  }
  
- void show_delay_dialog() {
-     GtkWidget *dialog, *content_area, *grid, *label, *spin;
-     
-     dialog = gtk_dialog_new_with_buttons("Enter Delay Time",
-                                        GTK_WINDOW(window),
-                                        GTK_DIALOG_MODAL,
-                                        "_OK",
-                                        GTK_RESPONSE_ACCEPT,
-                                        "_Cancel",
-                                        GTK_RESPONSE_REJECT,
-                                        NULL);
-     
-     content_area = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
-     
-     grid = gtk_grid_new();
-     gtk_grid_set_row_spacing(GTK_GRID(grid), 10);
-     gtk_grid_set_column_spacing(GTK_GRID(grid), 10);
-     gtk_container_set_border_width(GTK_CONTAINER(grid), 10);
-     
-     label = gtk_label_new("Delay time (minutes):");
-     spin = gtk_spin_button_new_with_range(1, 300, 1);
-     
-     gtk_grid_attach(GTK_GRID(grid), label, 0, 0, 1, 1);
-     gtk_grid_attach(GTK_GRID(grid), spin, 1, 0, 1, 1);
-     
-     gtk_container_add(GTK_CONTAINER(content_area), grid);
-     
-     g_signal_connect(dialog, "response",
-                     G_CALLBACK(on_delay_dialog_response),
-                     spin);
-     
-     gtk_widget_show_all(dialog);
+ static guint64 zigzag64(gint64 value) {
+     return ((guint64)value << 1) ^ (guint64)(value >> 63);
  }
  
- void on_delay_dialog_response(GtkDialog *dialog, gint response_id, gpointer user_data) {
-     GtkSpinButton *spin = GTK_SPIN_BUTTON(user_data);
-     
-     if (response_id == GTK_RESPONSE_ACCEPT) {
-         int delay = gtk_spin_button_get_value_as_int(spin);
-         handleWeatherDelay(delay);
-         update_flight_list();
-         update_runway_list();
-         update_crew_list();
-         update_schedule_list();
-         gtk_label_set_text(GTK_LABEL(notification_label), "Weather delay simulated");
+ static void thriftField(GByteArray *out, int *lastField, int field, ThriftType type) {
+     guint8 header = (guint8)type;
+     if (field > *lastField && field - *lastField <= 15) {
+         header |= (guint8)((field - *lastField) << 4);
+         g_byte_array_append(out, &header, 1);
+     } else {
+         g_byte_array_append(out, &header, 1);
+         thriftVarint(out, zigzag64(field));
      }
-     
-     gtk_widget_destroy(GTK_WIDGET(dialog));
+     *lastField = field;
  }
  
- void on_weather_delay_clicked(GtkWidget *widget, gpointer data) {
-     show_delay_dialog();
+ static void thriftI32(GByteArray *out, int *lastField, int field, gint32 value) {
+     thriftField(out, lastField, field, THRIFT_I32);
+     thriftVarint(out, zigzag64(value));
  }
  
- void on_emergency_landing_clicked(GtkWidget *widget, gpointer data) {
-     handleEmergencyLanding();
-     update_flight_list();
-     update_runway_list();
-     update_crew_list();
-     update_schedule_list();
-     gtk_label_set_text(GTK_LABEL(notification_label), "Emergency landing simulated");
+ static void thriftI64(GByteArray *out, int *lastField, int field, gint64 value) {
+     thriftField(out, lastField, field, THRIFT_I64);
+     thriftVarint(out, zigzag64(value));
  }
  
- void on_flight_cancellation_clicked(GtkWidget *widget, gpointer data) {
-     handleFlightCancellation();
-     update_flight_list();
-     update_schedule_list();
-     gtk_label_set_text(GTK_LABEL(notification_label), "Flight cancellation simulated");
+ static void thriftBinary(GByteArray *out, int *lastField, int field, const void *data, size_t length) {
+     thriftField(out, lastField, field, THRIFT_BINARY);
+     thriftVarint(out, length);
+     g_byte_array_append(out, data, length);
  }
  
- void on_reschedule_clicked(GtkWidget *widget, gpointer data) {
-     rescheduleFlights();
-     update_flight_list();
-     update_runway_list();
-     update_crew_list();
-     update_schedule_list();
-     gtk_label_set_text(GTK_LABEL(notification_label), "All flights rescheduled");
+ static void thriftList(GByteArray *out, int *lastField, int field, ThriftType elementType, int count) {
+     thriftField(out, lastField, field, THRIFT_LIST);
+     guint8 header = (guint8)(count < 15 ? count << 4 | elementType : 0xf0 | elementType);
+     g_byte_array_append(out, &header, 1);
+     if (count >= 15) thriftVarint(out, count);
  }
  
- void on_search_clicked(GtkWidget *widget, gpointer data) {
-     const char *search_term = gtk_entry_get_text(GTK_ENTRY(search_entry));
-     GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(search_results));
-     gtk_text_buffer_set_text(buffer, "", -1);
- 
-     GtkTextIter iter;
-     gtk_text_buffer_get_start_iter(buffer, &iter);
+ static void thriftStop(GByteArray *out) {
+     static const guint8 stop = 0;
+     g_byte_array_append(out, &stop, 1);
+ }
  
-     if (strlen(search_term) == 0) {
-         gtk_text_buffer_insert(buffer, &iter, "Please enter a search term", -1);
-         return;
-     }
+ static int bitWidth(guint32 value) {
+     return value ? g_bit_storage(value) : 0;
+ }
  
-     bool found = false;
-     for (int i = 0; i < flightCount; i++) {
-         if (strstr(flights[i].flightID, search_term) != NULL) {
-             char line[512];
-             const char* statusStr;
-             switch(flights[i].status) {
-                 case SCHEDULED: statusStr = "Scheduled"; break;
-                 case DELAYED: statusStr = "Delayed"; break;
-                 case CANCELLED: statusStr = "Cancelled"; break;
-                 case EMERGENCY_STATUS: statusStr = "Emergency"; break;
-                 default: statusStr = "Unknown";
-             }
-             
-             sprintf(line, "Flight %s: %s to %s\n  Departure: %02d:%02d (%s)\n  Arrival: %02d:%02d\n\n",
-                    flights[i].flightID,
-                    flights[i].origin,
-                    flights[i].destination,
-                    flights[i].departureTime.hour,
-                    flights[i].departureTime.minute,
-                    statusStr,
-                    flights[i].arrivalTime.hour,
-                    flights[i].arrivalTime.minute);
-             gtk_text_buffer_insert(buffer, &iter, line, -1);
-             found = true;
+ // Appends count values of the given bit width, LSB first, padded with
+ // zeros to whole groups of eight.
+ static void packBits(GByteArray *out, const guint32 *values, int count, int padded, int width) {
+     guint64 pending = 0;
+     int bits = 0;
+     for (int i = 0; i < padded; i++) {
+         pending |= (guint64)(i < count ? values[i] : 0) << bits;
+         bits += width;
+         while (bits >= 8) {
+             guint8 byte = (guint8)pending;
+             g_byte_array_append(out, &byte, 1);
+             pending >>= 8;
+             bits -= 8;
          }
      }
- 
-     if (!found) {
-         gtk_text_buffer_insert(buffer, &iter, "No flights found matching the search term", -1);
-     }
  }
  
- void on_generate_flights_report_clicked(GtkWidget *widget, gpointer data) {
-     GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(report_text));
-     gtk_text_buffer_set_text(buffer, "", -1);
- 
-     GtkTextIter iter;
-     gtk_text_buffer_get_start_iter(buffer, &iter);
- 
-     char line[512];
-     sprintf(line, "FLIGHT REPORT\n=============\n\n");
-     gtk_text_buffer_insert(buffer, &iter, line, -1);
- 
-     sprintf(line, "Total flights: %d\n", flightCount);
-     gtk_text_buffer_insert(buffer, &iter, line, -1);
- 
-     int scheduled = 0, delayed = 0, cancelled = 0, emergency = 0;
-     for (int i = 0; i < flightCount; i++) {
-         switch(flights[i].status) {
-             case SCHEDULED: scheduled++; break;
-             case DELAYED: delayed++; break;
-             case CANCELLED: cancelled++; break;
-             case EMERGENCY_STATUS: emergency++; break;
+ static void encodeDeltaBinaryPacked(GByteArray *out, const gint32 *values, int count) {
+     putVarint(out, 128);
+     putVarint(out, 4);
+     putVarint(out, count);
+     thriftVarint(out, zigzag64(count > 0 ? values[0] : 0));
+ 
+     for (int block = 1; block < count; block += 128) {
+         int n = MIN(128, count - block);
+         guint32 deltas[128];
+         gint32 minDelta = G_MAXINT32;
+         for (int i = 0; i < n; i++) {
+             gint32 delta = (gint32)((guint32)values[block + i] - (guint32)values[block + i - 1]);
+             deltas[i] = (guint32)delta;
+             minDelta = MIN(minDelta, delta);
          }
-     }
+         thriftVarint(out, zigzag64(minDelta));
  
-     sprintf(line, "Scheduled: %d\nDelayed: %d\nCancelled: %d\nEmergency: %d\n\n",
-            scheduled, delayed, cancelled, emergency);
-     gtk_text_buffer_insert(buffer, &iter, line, -1);
-     gtk_text_buffer_insert(buffer, &iter, "Flight Details:\n", -1);
-     for (int i = 0; i < flightCount; i++) {
-         const char* statusStr;
-         switch(flights[i].status) {
-             case SCHEDULED: statusStr = "Scheduled"; break;
-             case DELAYED: statusStr = "Delayed"; break;
-             case CANCELLED: statusStr = "Cancelled"; break;
-             case EMERGENCY_STATUS: statusStr = "Emergency"; break;
-             default: statusStr = "Unknown";
+         guint8 widths[4] = {0};
+         for (int i = 0; i < n; i++) {
+             deltas[i] -= (guint32)minDelta;
+             widths[i / 32] = MAX(widths[i / 32], bitWidth(deltas[i]));
+         }
+         g_byte_array_append(out, widths, 4);
+         for (int m = 0; m * 32 < n; m++) {
+             packBits(out, deltas + m * 32, MIN(32, n - m * 32), 32, widths[m]);
          }
-         
-         sprintf(line, "%s: %s to %s, %02d:%02d (%s)\n",
-                flights[i].flightID,
-                flights[i].origin,
-                flights[i].destination,
-                flights[i].departureTime.hour,
-                flights[i].departureTime.minute,
-                statusStr);
-         gtk_text_buffer_insert(buffer, &iter, line, -1);
      }
- 
-     gtk_label_set_text(GTK_LABEL(notification_label), "Flight report generated");
  }
  
- void on_generate_runways_report_clicked(GtkWidget *widget, gpointer data) {
-     GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(report_text));
-     gtk_text_buffer_set_text(buffer, "", -1);
- 
-     GtkTextIter iter;
-     gtk_text_buffer_get_start_iter(buffer, &iter);
+ static void writeParquetBytes(ParquetWriter *pw, const void *data, size_t size) {
+     if (size > 0 && !pw->failed && fwrite(data, size, 1, pw->file) != 1) pw->failed = true;
+     pw->offset += size;
+ }
  
-     char line[512];
-     sprintf(line, "RUNWAY UTILIZATION REPORT\n========================\n\n");
-     gtk_text_buffer_insert(buffer, &iter, line, -1);
+ static void writeParquetPage(ParquetWriter *pw, bool dictionaryPage, const GByteArray *body,
+                              int count, int encoding) {
+     GByteArray *header = g_byte_array_new();
+     int field = 0, inner = 0;
+     thriftI32(header, &field, 1, dictionaryPage ? 2 : 0);
+     thriftI32(header, &field, 2, body->len);
+     thriftI32(header, &field, 3, body->len);
+     thriftField(header, &field, dictionaryPage ? 7 : 5, THRIFT_STRUCT);
+     thriftI32(header, &inner, 1, count);
+     thriftI32(header, &inner, 2, encoding);
+     if (!dictionaryPage) {
+         thriftI32(header, &inner, 3, 3);
+         thriftI32(header, &inner, 4, 3);
+     }
+     thriftStop(header);
+     thriftStop(header);
+     writeParquetBytes(pw, header->data, header->len);
+     writeParquetBytes(pw, body->data, body->len);
+     g_byte_array_free(header, TRUE);
+ }
  
-     for (int i = 0; i < runwayCount; i++) {
-         const char* typeStr;
-         switch(runways[i].type) {
-             case ALL_FLIGHTS: typeStr = "All Flights"; break;
-             case INTERNATIONAL_ONLY: typeStr = "International Only"; break;
-             case CARGO_ONLY: typeStr = "Cargo Only"; break;
-             default: typeStr = "Unknown";
+ // Writes one column chunk of the current row group and appends its
+ // ColumnChunk metadata to meta. Returns the chunk size in bytes.
+ static gint64 writeParquetColumn(ParquetWriter *pw, int column, GByteArray *meta) {
+     const ExportColumn *col = &exportColumns[column];
+     const gint32 *values = pw->values[column];
+     gint64 start = pw->offset, dictionaryOffset = -1;
+     GByteArray *body = g_byte_array_new();
+     guint8 minValue[4], maxValue[4];
+     const void *minBytes = minValue, *maxBytes = maxValue;
+     size_t minLength = 4, maxLength = 4;
+     int encoding;
+ 
+     if (col->type == PARQUET_BYTE_ARRAY) {
+         GPtrArray *dictionary = pw->dictionaries[column];
+         const char *min = "", *max = "";
+         for (guint i = 0; i < dictionary->len; i++) {
+             const char *text = g_ptr_array_index(dictionary, i);
+             guint32 length = GUINT32_TO_LE((guint32)strlen(text));
+             g_byte_array_append(body, (const guint8 *)&length, 4);
+             g_byte_array_append(body, (const guint8 *)text, strlen(text));
+             if (i == 0 || strcmp(text, min) < 0) min = text;
+             if (i == 0 || strcmp(text, max) > 0) max = text;
          }
+         dictionaryOffset = pw->offset;
+         writeParquetPage(pw, true, body, dictionary->len, 0);
+ 
+         g_byte_array_set_size(body, 0);
+         guint8 width = (guint8)MAX(1, bitWidth(dictionary->len - 1));
+         g_byte_array_append(body, &width, 1);
+         int groups = (pw->rows + 7) / 8;
+         putVarint(body, (guint32)groups << 1 | 1);
+         packBits(body, (const guint32 *)values, pw->rows, groups * 8, width);
+         encoding = 8;
+         minBytes = min;
+         maxBytes = max;
+         minLength = strlen(min);
+         maxLength = strlen(max);
+     } else if (col->type == PARQUET_BOOLEAN) {
+         gint32 min = 1, max = 0;
+         guint8 byte = 0;
+         for (int i = 0; i < pw->rows; i++) {
+             byte |= (guint8)((values[i] != 0) << (i % 8));
+             if (i % 8 == 7 || i == pw->rows - 1) {
+                 g_byte_array_append(body, &byte, 1);
+                 byte = 0;
+             }
+             min = MIN(min, values[i] != 0);
+             max = MAX(max, values[i] != 0);
+         }
+         encoding = 0;
+         minValue[0] = (guint8)min;
+         maxValue[0] = (guint8)max;
+         minLength = maxLength = 1;
+     } else {
+         gint32 min = G_MAXINT32, max = G_MININT32;
+         for (int i = 0; i < pw->rows; i++) {
+             min = MIN(min, values[i]);
+             max = MAX(max, values[i]);
+         }
+         encodeDeltaBinaryPacked(body, values, pw->rows);
+         encoding = 5;
+         guint32 le = GUINT32_TO_LE((guint32)min);
+         memcpy(minValue, &le, 4);
+         le = GUINT32_TO_LE((guint32)max);
+         memcpy(maxValue, &le, 4);
+     }
+     gint64 dataOffset = pw->offset;
+     writeParquetPage(pw, false, body, pw->rows, encoding);
+     g_byte_array_free(body, TRUE);
+     gint64 size = pw->offset - start;
+ 
+     int field = 0, metaField = 0, statsField = 0;
+     thriftI64(meta, &field, 2, start);
+     thriftField(meta, &field, 3, THRIFT_STRUCT);
+     thriftI32(meta, &metaField, 1, col->type);
+     if (dictionaryOffset >= 0) {
+         thriftList(meta, &metaField, 2, THRIFT_I32, 2);
+         thriftVarint(meta, zigzag64(0));
+         thriftVarint(meta, zigzag64(8));
+     } else {
+         thriftList(meta, &metaField, 2, THRIFT_I32, 1);
+         thriftVarint(meta, zigzag64(encoding));
+     }
+     thriftList(meta, &metaField, 3, THRIFT_BINARY, 1);
+     thriftVarint(meta, strlen(col->name));
+     g_byte_array_append(meta, (const guint8 *)col->name, strlen(col->name));
+     thriftI32(meta, &metaField, 4, 0);
+     thriftI64(meta, &metaField, 5, pw->rows);
+     thriftI64(meta, &metaField, 6, size);
+     thriftI64(meta, &metaField, 7, size);
+     thriftI64(meta, &metaField, 9, dataOffset);
+     if (dictionaryOffset >= 0) thriftI64(meta, &metaField, 11, dictionaryOffset);
+     thriftField(meta, &metaField, 12, THRIFT_STRUCT);
+     thriftI64(meta, &statsField, 3, 0);
+     thriftBinary(meta, &statsField, 5, maxBytes, maxLength);
+     thriftBinary(meta, &statsField, 6, minBytes, minLength);
+     thriftStop(meta);
+     thriftStop(meta);
+     thriftStop(meta);
+     return size;
+ }
  
-         sprintf(line, "Runway %d (%s): %s\n", 
-                runways[i].id, typeStr,
-                runways[i].isAvailable ? "Available" : "In Use");
-         gtk_text_buffer_insert(buffer, &iter, line, -1);
- 
-         if (!runways[i].isAvailable) {
-             sprintf(line, "  Next available at %02d:%02d\n\n", 
-                    runways[i].nextAvailableTime.hour, 
-                    runways[i].nextAvailableTime.minute);
-             gtk_text_buffer_insert(buffer, &iter, line, -1);
-         } else {
-             gtk_text_buffer_insert(buffer, &iter, "\n", -1);
+ static void flushParquetRowGroup(ParquetWriter *pw) {
+     if (pw->rows == 0) return;
+     GByteArray *columns = g_byte_array_new();
+     gint64 bytes = 0;
+     for (int c = 0; c < EXPORT_COLUMNS; c++) {
+         bytes += writeParquetColumn(pw, c, columns);
+         if (pw->dictionaries[c]) {
+             g_hash_table_remove_all(pw->dictionaryIndex[c]);
+             g_ptr_array_set_size(pw->dictionaries[c], 0);
          }
      }
  
-     gtk_label_set_text(GTK_LABEL(notification_label), "Runway report generated");
+     int field = 0;
+     thriftList(pw->rowGroups, &field, 1, THRIFT_STRUCT, EXPORT_COLUMNS);
+     g_byte_array_append(pw->rowGroups, columns->data, columns->len);
+     thriftI64(pw->rowGroups, &field, 2, bytes);
+     thriftI64(pw->rowGroups, &field, 3, pw->rows);
+     thriftStop(pw->rowGroups);
+     g_byte_array_free(columns, TRUE);
+ 
+     pw->rowGroupCount++;
+     pw->totalRows += pw->rows;
+     pw->rows = 0;
  }
  
- void on_generate_crew_report_clicked(GtkWidget *widget, gpointer data) {
-     GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(report_text));
-     gtk_text_buffer_set_text(buffer, "", -1);
+ static gint32 exportString(ParquetWriter *pw, int column, const char *text) {
+     gpointer found;
+     if (g_hash_table_lookup_extended(pw->dictionaryIndex[column], text, NULL, &found)) return GPOINTER_TO_INT(found);
+     char *copy = g_strdup(text);
+     gint32 index = pw->dictionaries[column]->len;
+     g_ptr_array_add(pw->dictionaries[column], copy);
+     g_hash_table_insert(pw->dictionaryIndex[column], copy, GINT_TO_POINTER(index));
+     return index;
+ }
  
-     GtkTextIter iter;
-     gtk_text_buffer_get_start_iter(buffer, &iter);
+ static bool exportArchivedRow(const ArchivedFlight *row, void *context) {
+     ParquetWriter *pw = context;
+     const Flight *f = &row->flight;
+     int r = pw->rows++;
+     pw->values[0][r] = row->day;
+     pw->values[1][r] = exportString(pw, 1, f->flightID);
+     pw->values[2][r] = exportString(pw, 2, f->origin);
+     pw->values[3][r] = exportString(pw, 3, f->destination);
+     pw->values[4][r] = exportString(pw, 4, f->aircraftType);
+     pw->values[5][r] = f->departureTime.hour * 60 + f->departureTime.minute;
+     pw->values[6][r] = f->arrivalTime.hour * 60 + f->arrivalTime.minute;
+     pw->values[7][r] = exportString(pw, 7, flightStatusName(f->status));
+     pw->values[8][r] = exportString(pw, 8, flightPriorityName(f->priority));
+     pw->values[9][r] = f->runwayAssigned;
+     pw->values[10][r] = f->crewAssigned;
+     pw->values[11][r] = f->delayMinutes;
+     pw->values[12][r] = f->isCargo;
+     if (pw->rows == EXPORT_ROW_GROUP_ROWS) flushParquetRowGroup(pw);
+     return !pw->failed;
+ }
  
-     char line[512];
-     sprintf(line, "CREW STATUS REPORT\n==================\n\n");
-     gtk_text_buffer_insert(buffer, &iter, line, -1);
+ static void writeParquetFooter(ParquetWriter *pw) {
+     GByteArray *footer = g_byte_array_new();
+     int field = 0, element;
+     thriftI32(footer, &field, 1, 1);
+     thriftList(footer, &field, 2, THRIFT_STRUCT, EXPORT_COLUMNS + 1);
+     element = 0;
+     thriftBinary(footer, &element, 4, "schema", 6);
+     thriftI32(footer, &element, 5, EXPORT_COLUMNS);
+     thriftStop(footer);
+     for (int c = 0; c < EXPORT_COLUMNS; c++) {
+         element = 0;
+         thriftI32(footer, &element, 1, exportColumns[c].type);
+         thriftI32(footer, &element, 3, 0);
+         thriftBinary(footer, &element, 4, exportColumns[c].name, strlen(exportColumns[c].name));
+         if (exportColumns[c].convertedType >= 0) thriftI32(footer, &element, 6, exportColumns[c].convertedType);
+         thriftStop(footer);
+     }
+     thriftI64(footer, &field, 3, pw->totalRows);
+     thriftList(footer, &field, 4, THRIFT_STRUCT, pw->rowGroupCount);
+     g_byte_array_append(footer, pw->rowGroups->data, pw->rowGroups->len);
+     static const char createdBy[] = "fms flight archive export";
+     thriftBinary(footer, &field, 6, createdBy, strlen(createdBy));
+     // Type-defined (unsigned byte-wise) ordering, which makes the min/max
+     // statistics of string columns usable.
+     thriftList(footer, &field, 7, THRIFT_STRUCT, EXPORT_COLUMNS);
+     for (int c = 0; c < EXPORT_COLUMNS; c++) {
+         element = 0;
+         thriftField(footer, &element, 1, THRIFT_STRUCT);
+         thriftStop(footer);
+         thriftStop(footer);
+     }
+     thriftStop(footer);
  
-     int available = 0, on_duty = 0;
-     for (int i = 0; i < crewCount; i++) {
-         if (crews[i].isAvailable) {
-             available++;
-         } else {
-             on_duty++;
+     guint32 length = GUINT32_TO_LE(footer->len);
+     writeParquetBytes(pw, footer->data, footer->len);
+     writeParquetBytes(pw, &length, 4);
+     writeParquetBytes(pw, "PAR1", 4);
+     g_byte_array_free(footer, TRUE);
+ }
+ 
+ // Returns the number of rows written, or -1 on failure.
+ int exportArchiveColumnar(const ExportOptions *options) {
+     TRACE_SCOPE("exportArchiveColumnar", "io");
+     char tempPath[256];
+     snprintf(tempPath, sizeof(tempPath), "%s.tmp", options->path);
+     ParquetWriter *pw = g_new0(ParquetWriter, 1);
+     pw->file = fopen(tempPath, "wb");
+     if (!pw->file) {
+         g_free(pw);
+         return -1;
+     }
+     pw->rowGroups = g_byte_array_new();
+     for (int c = 0; c < EXPORT_COLUMNS; c++) {
+         pw->values[c] = g_new(gint32, EXPORT_ROW_GROUP_ROWS);
+         if (exportColumns[c].type == PARQUET_BYTE_ARRAY) {
+             pw->dictionaries[c] = g_ptr_array_new_with_free_func(g_free);
+             pw->dictionaryIndex[c] = g_hash_table_new(g_str_hash, g_str_equal);
          }
      }
  
-     sprintf(line, "Available crew: %d\nOn duty: %d\n\n", available, on_duty);
-     gtk_text_buffer_insert(buffer, &iter, line, -1);
+     writeParquetBytes(pw, "PAR1", 4);
+     scanArchive(NULL, options->fromDay, options->toDay, exportArchivedRow, pw);
+     flushParquetRowGroup(pw);
+     writeParquetFooter(pw);
  
-     sprintf(line, "Crew approaching duty limits:\n");
-     gtk_text_buffer_insert(buffer, &iter, line, -1);
+     bool ok = fclose(pw->file) == 0 && !pw->failed;
+     if (ok) ok = rename(tempPath, options->path) == 0;
+     int rows = ok ? (int)pw->totalRows : -1;
  
-     bool any_approaching = false;
-     for (int i = 0; i < crewCount; i++) {
-         if (crews[i].dutyMinutesToday > MAX_DUTY_TIME * 0.8) {
-             sprintf(line, "%s: %d/%d minutes\n", 
-                    crews[i].name, 
-                    crews[i].dutyMinutesToday, 
-                    MAX_DUTY_TIME);
-             gtk_text_buffer_insert(buffer, &iter, line, -1);
-             any_approaching = true;
+     for (int c = 0; c < EXPORT_COLUMNS; c++) {
+         g_free(pw->values[c]);
+         if (pw->dictionaries[c]) {
+             g_hash_table_destroy(pw->dictionaryIndex[c]);
+             g_ptr_array_free(pw->dictionaries[c], TRUE);
          }
      }
- 
-     if (!any_approaching) {
-         gtk_text_buffer_insert(buffer, &iter, "None\n", -1);
-     }
- 
-     gtk_label_set_text(GTK_LABEL(notification_label), "Crew report generated");
+     g_byte_array_free(pw->rowGroups, TRUE);
+     g_free(pw);
+     return rows;
  }
  
  void on_flight_selected(GtkTreeSelection *selection, gpointer data) {
@@ -1211,15 +6493,14 @@ void scheduleCrew() {
      GtkTreeIter iter;
  
      if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
-         Flight *flight;
-         gtk_tree_model_get(model, &iter, 1, &flight, -1);
-         selectedFlightIndex = -1;
-         for (int i = 0; i < flightCount; i++) {
-             if (strcmp(flights[i].flightID, flight->flightID) == 0) {
-                 selectedFlightIndex = i;
-                 break;
-             }
+         int index;
+         gtk_tree_model_get(model, &iter, FLIGHT_COL_INDEX, &index, -1);
+         if (index < 0 || index >= flightCount) {
+             selectedFlightIndex = -1;
+             return;
          }
+         selectedFlightIndex = index;
+         Flight *flight = &flights[index];
  
          GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(flight_details_text));
          gtk_text_buffer_set_text(buffer, "", -1);
@@ -1285,23 +6566,223 @@ void scheduleCrew() {
  }
  
  
- void update_flight_list() {
-     GtkListStore *store = gtk_list_store_new(2, G_TYPE_STRING, G_TYPE_POINTER);
+ // FlightModel is a list-only GtkTreeModel that reads rows straight out of
+ // flights[]. Iterators carry the row index, so nothing is copied and the
+ // view only asks for the rows it draws. Mutations report the rows they touch
+ // through the flight_model_row_* calls, which emit the matching signals.
+ static void flight_model_tree_model_init(GtkTreeModelIface *iface);
+ 
+ G_DEFINE_TYPE_WITH_CODE(FlightModel, flight_model, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_MODEL, flight_model_tree_model_init))
+ 
+ static void flight_model_init(FlightModel *model) {
+     model->stamp = g_random_int();
+     model->rowCount = 0;
+ }
+ 
+ static void flight_model_class_init(FlightModelClass *klass) {
+ }
+ 
+ static GtkTreeModelFlags flight_model_get_flags(GtkTreeModel *tree_model) {
+     return GTK_TREE_MODEL_LIST_ONLY;
+ }
+ 
+ static gint flight_model_get_n_columns(GtkTreeModel *tree_model) {
+     return FLIGHT_MODEL_N_COLUMNS;
+ }
+ 
+ static GType flight_model_get_column_type(GtkTreeModel *tree_model, gint column) {
+     switch (column) {
+         case FLIGHT_COL_ID:
+         case FLIGHT_COL_ORIGIN:
+         case FLIGHT_COL_DESTINATION:
+         case FLIGHT_COL_CREW:
+             return G_TYPE_STRING;
+         case FLIGHT_COL_INDEX:
+         case FLIGHT_COL_DEPARTURE:
+         case FLIGHT_COL_ARRIVAL:
+         case FLIGHT_COL_STATUS:
+         case FLIGHT_COL_RUNWAY:
+             return G_TYPE_INT;
+         default:
+             return G_TYPE_INVALID;
+     }
+ }
+ 
+ static gboolean flight_model_iter_at(FlightModel *model, GtkTreeIter *iter, int index) {
+     if (index < 0 || index >= model->rowCount) {
+         iter->stamp = 0;
+         return FALSE;
+     }
+     iter->stamp = model->stamp;
+     iter->user_data = GINT_TO_POINTER(index);
+     iter->user_data2 = NULL;
+     iter->user_data3 = NULL;
+     return TRUE;
+ }
+ 
+ static gboolean flight_model_get_iter(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreePath *path) {
+     if (gtk_tree_path_get_depth(path) != 1) return FALSE;
+     return flight_model_iter_at((FlightModel *)tree_model, iter, gtk_tree_path_get_indices(path)[0]);
+ }
+ 
+ static GtkTreePath* flight_model_get_path(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+     return gtk_tree_path_new_from_indices(GPOINTER_TO_INT(iter->user_data), -1);
+ }
+ 
+ static void flight_model_get_value(GtkTreeModel *tree_model, GtkTreeIter *iter, gint column, GValue *value) {
+     int index = GPOINTER_TO_INT(iter->user_data);
+     g_value_init(value, flight_model_get_column_type(tree_model, column));
+     if (index < 0 || index >= flightCount) return;
+ 
+     Flight *flight = &flights[index];
+     switch (column) {
+         case FLIGHT_COL_ID:
+             g_value_set_static_string(value, flight->flightID);
+             break;
+         case FLIGHT_COL_INDEX:
+             g_value_set_int(value, index);
+             break;
+         case FLIGHT_COL_DEPARTURE:
+             g_value_set_int(value, flight->departureTime.hour * 60 + flight->departureTime.minute);
+             break;
+         case FLIGHT_COL_ARRIVAL:
+             g_value_set_int(value, flight->arrivalTime.hour * 60 + flight->arrivalTime.minute);
+             break;
+         case FLIGHT_COL_ORIGIN:
+             g_value_set_static_string(value, flight->origin);
+             break;
+         case FLIGHT_COL_DESTINATION:
+             g_value_set_static_string(value, flight->destination);
+             break;
+         case FLIGHT_COL_STATUS:
+             g_value_set_int(value, flight->status);
+             break;
+         case FLIGHT_COL_RUNWAY:
+             g_value_set_int(value, flight->runwayAssigned);
+             break;
+         case FLIGHT_COL_CREW:
+             g_value_set_static_string(value, flight->crewAssigned == -1 ? "None" :
+                                              crews[flight->crewAssigned].name);
+             break;
+     }
+ }
+ 
+ static gboolean flight_model_iter_next(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+     return flight_model_iter_at((FlightModel *)tree_model, iter, GPOINTER_TO_INT(iter->user_data) + 1);
+ }
+ 
+ static gboolean flight_model_iter_children(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreeIter *parent) {
+     if (parent) return FALSE;
+     return flight_model_iter_at((FlightModel *)tree_model, iter, 0);
+ }
+ 
+ static gboolean flight_model_iter_has_child(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+     return FALSE;
+ }
+ 
+ static gint flight_model_iter_n_children(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+     return iter ? 0 : ((FlightModel *)tree_model)->rowCount;
+ }
+ 
+ static gboolean flight_model_iter_nth_child(GtkTreeModel *tree_model, GtkTreeIter *iter,
+                                             GtkTreeIter *parent, gint n) {
+     if (parent) return FALSE;
+     return flight_model_iter_at((FlightModel *)tree_model, iter, n);
+ }
+ 
+ static gboolean flight_model_iter_parent(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreeIter *child) {
+     return FALSE;
+ }
+ 
+ static void flight_model_tree_model_init(GtkTreeModelIface *iface) {
+     iface->get_flags = flight_model_get_flags;
+     iface->get_n_columns = flight_model_get_n_columns;
+     iface->get_column_type = flight_model_get_column_type;
+     iface->get_iter = flight_model_get_iter;
+     iface->get_path = flight_model_get_path;
+     iface->get_value = flight_model_get_value;
+     iface->iter_next = flight_model_iter_next;
+     iface->iter_children = flight_model_iter_children;
+     iface->iter_has_child = flight_model_iter_has_child;
+     iface->iter_n_children = flight_model_iter_n_children;
+     iface->iter_nth_child = flight_model_iter_nth_child;
+     iface->iter_parent = flight_model_iter_parent;
+ }
+ 
+ FlightModel* flight_model_new() {
+     FlightModel *model = g_object_new(flight_model_get_type(), NULL);
+     model->rowCount = flightCount;
+     return model;
+ }
+ 
+ void flight_model_row_inserted(int index) {
+     if (!flightModel) return;
+ 
      GtkTreeIter iter;
+     flightModel->rowCount++;
+     flight_model_iter_at(flightModel, &iter, index);
+     GtkTreePath *path = gtk_tree_path_new_from_indices(index, -1);
+     gtk_tree_model_row_inserted(GTK_TREE_MODEL(flightModel), path, &iter);
+     gtk_tree_path_free(path);
+ }
  
-     for (int i = 0; i < flightCount; i++) {
-         gtk_list_store_append(store, &iter);
-         gtk_list_store_set(store, &iter, 
-                           0, flights[i].flightID,
-                           1, &flights[i],
-                           -1);
+ void flight_model_row_deleted(int index) {
+     if (!flightModel || flightModel->rowCount == 0) return;
+ 
+     flightModel->rowCount--;
+     GtkTreePath *path = gtk_tree_path_new_from_indices(index, -1);
+     gtk_tree_model_row_deleted(GTK_TREE_MODEL(flightModel), path);
+     gtk_tree_path_free(path);
+ }
+ 
+ void flight_model_row_changed(int index) {
+     if (!flightModel) return;
+ 
+     GtkTreeIter iter;
+     if (!flight_model_iter_at(flightModel, &iter, index)) return;
+     GtkTreePath *path = gtk_tree_path_new_from_indices(index, -1);
+     gtk_tree_model_row_changed(GTK_TREE_MODEL(flightModel), path, &iter);
+     gtk_tree_path_free(path);
+ }
+ 
+ void flight_model_rows_changed(int from, int to) {
+     for (int i = from; i < to; i++) {
+         flight_model_row_changed(i);
+     }
+ }
+
+ // Emits row-changed for rows whose contents differ between two published
+ // versions. Only runs on the GTK thread; inserts and deletes were already
+ // signalled by the mutation itself.
+ void flight_model_apply_delta(const ScheduleState *prev, const ScheduleState *next) {
+     if (!flightModel || !prev || !g_main_context_is_owner(g_main_context_default())) return;
+ 
+     int common = MIN(MIN(prev->flightCount, next->flightCount), flightModel->rowCount);
+     for (int i = 0; i < common; i++) {
+         if (memcmp(&prev->flights[i], &next->flights[i], sizeof(Flight)) != 0) {
+             flight_model_row_changed(i);
+         }
      }
+ }
+ 
+ // Brings the row count in line with flightCount after bulk loads, emitting
+ // inserts or deletes at the tail only.
+ void update_flight_list() {
+     TRACE_SCOPE(__func__, "ui");
+     if (!flightModel) return;
  
-     gtk_tree_view_set_model(GTK_TREE_VIEW(flight_list), GTK_TREE_MODEL(store));
-     g_object_unref(store);
+     while (flightModel->rowCount < flightCount) {
+         flight_model_row_inserted(flightModel->rowCount);
+     }
+     while (flightModel->rowCount > flightCount) {
+         flight_model_row_deleted(flightModel->rowCount - 1);
+     }
  }
  
  void update_runway_list() {
+    TRACE_SCOPE(__func__, "ui");
+    if (!runway_list) return;
     GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(runway_list));
     gtk_text_buffer_set_text(buffer, "", -1);
 
@@ -1335,6 +6816,8 @@ void scheduleCrew() {
 }
  
  void update_crew_list() {
+     TRACE_SCOPE(__func__, "ui");
+     if (!crew_list) return;
      GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(crew_list));
      gtk_text_buffer_set_text(buffer, "", -1);
  
@@ -1346,7 +6829,7 @@ void scheduleCrew() {
          sprintf(line, "%s - %s (%d/%d mins duty)\n", 
                 crews[i].name, 
                 crews[i].isAvailable ? "Available" : "On Duty",
-                crews[i].dutyMinutesToday, MAX_DUTY_TIME);
+                crews[i].dutyMinutesToday, config.maxDutyTime);
          gtk_text_buffer_insert(buffer, &iter, line, -1);
  
          sprintf(line, "  Qualifications: %s\n\n", crews[i].qualifications);
@@ -1354,53 +6837,92 @@ void scheduleCrew() {
      }
  }
  
+ // The schedule screen is a sort model over a filter model over FlightModel,
+ // so it follows the same row signals as the flight list and a refresh only
+ // needs to reconcile the row count. Cells are formatted into stack buffers
+ // from the row index.
  void update_schedule_list() {
-    GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(schedule_list));
-    gtk_text_buffer_set_text(buffer, "", -1);
-
-    GtkTextTag *mono_tag = gtk_text_buffer_create_tag(buffer, "monospace",
-                                                    "family", "Monospace",
-                                                    NULL);
-
-    GtkTextIter iter;
-    gtk_text_buffer_get_start_iter(buffer, &iter);
-
-    gtk_text_buffer_insert_with_tags(buffer, &iter, 
-        "Flight ID  Departure  Arrival   Route               Status         Runway  Crew\n", 
-        -1, mono_tag, NULL);
-    gtk_text_buffer_insert_with_tags(buffer, &iter, 
-        "--------  ---------  -------   -----               ------         ------  ----\n", 
-        -1, mono_tag, NULL);
-
-    for (int i = 0; i < flightCount; i++) {
-        char line[256];
-        const char* statusStr;
-        switch(flights[i].status) {
-            case SCHEDULED: statusStr = "Scheduled"; break;
-            case DELAYED: statusStr = g_strdup_printf("Delayed (%d)", flights[i].delayMinutes); break;
-            case CANCELLED: statusStr = "Cancelled"; break;
-            case EMERGENCY_STATUS: statusStr = "Emergency"; break;
-            default: statusStr = "Unknown";
-        }
-
-        const char* runwayStr = (flights[i].runwayAssigned == -1) ? "None" : 
-                               g_strdup_printf("Rwy %d", flights[i].runwayAssigned);
-        const char* crewName = (flights[i].crewAssigned == -1) ? "None" : crews[flights[i].crewAssigned].name;
-
-        snprintf(line, sizeof(line), 
-            "%-8s  %02d:%02d     %02d:%02d   %-5s to %-5s      %-14s %-7s %s\n",
-            flights[i].flightID,
-            flights[i].departureTime.hour, flights[i].departureTime.minute,
-            flights[i].arrivalTime.hour, flights[i].arrivalTime.minute,
-            flights[i].origin, flights[i].destination,
-            statusStr,
-            runwayStr,
-            crewName);
-
-        gtk_text_buffer_insert_with_tags(buffer, &iter, line, -1, mono_tag, NULL);
-    }
-}
-
+     TRACE_SCOPE(__func__, "ui");
+     update_flight_list();
+ }
+ 
+ static void schedule_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                                GtkTreeModel *model, GtkTreeIter *iter, gpointer data) {
+     int field = GPOINTER_TO_INT(data);
+     int index;
+     gtk_tree_model_get(model, iter, FLIGHT_COL_INDEX, &index, -1);
+     if (index < 0 || index >= flightCount) return;
+ 
+     Flight *flight = &flights[index];
+     char text[STR_LEN*2];
+     switch (field) {
+         case FLIGHT_COL_DEPARTURE:
+             snprintf(text, sizeof(text), "%02d:%02d", flight->departureTime.hour, flight->departureTime.minute);
+             break;
+         case FLIGHT_COL_ARRIVAL:
+             snprintf(text, sizeof(text), "%02d:%02d", flight->arrivalTime.hour, flight->arrivalTime.minute);
+             break;
+         case FLIGHT_COL_STATUS:
+             switch (flight->status) {
+                 case SCHEDULED: snprintf(text, sizeof(text), "Scheduled"); break;
+                 case DELAYED: snprintf(text, sizeof(text), "Delayed (%d)", flight->delayMinutes); break;
+                 case CANCELLED: snprintf(text, sizeof(text), "Cancelled"); break;
+                 case EMERGENCY_STATUS: snprintf(text, sizeof(text), "Emergency"); break;
+                 default: snprintf(text, sizeof(text), "Unknown");
+             }
+             break;
+         case FLIGHT_COL_RUNWAY:
+             if (flight->runwayAssigned == -1) {
+                 snprintf(text, sizeof(text), "None");
+             } else {
+                 snprintf(text, sizeof(text), "Rwy %d", flight->runwayAssigned);
+             }
+             break;
+         default:
+             text[0] = '\0';
+     }
+     g_object_set(renderer, "text", text, NULL);
+ }
+ 
+ static gboolean schedule_row_visible(GtkTreeModel *model, GtkTreeIter *iter, gpointer data) {
+     int index = GPOINTER_TO_INT(iter->user_data);
+     if (index < 0 || index >= flightCount) return FALSE;
+ 
+     Flight *flight = &flights[index];
+     gint status = gtk_combo_box_get_active(GTK_COMBO_BOX(schedule_status_combo));
+     if (status > 0 && flight->status != (FlightStatus)(status - 1)) return FALSE;
+ 
+     const char *term = gtk_entry_get_text(GTK_ENTRY(schedule_filter_entry));
+     if (term[0] == '\0') return TRUE;
+     return textContainsIgnoreCase(flight->flightID, term) ||
+            textContainsIgnoreCase(flight->origin, term) ||
+            textContainsIgnoreCase(flight->destination, term);
+ }
+ 
+ void on_schedule_filter_changed(GtkWidget *widget, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     gtk_tree_model_filter_refilter(GTK_TREE_MODEL_FILTER(scheduleFilterModel));
+ }
+ 
+ static void add_schedule_column(const char *title, int field, bool formatted) {
+     GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+     GtkTreeViewColumn *column;
+     if (formatted) {
+         column = gtk_tree_view_column_new();
+         gtk_tree_view_column_set_title(column, title);
+         gtk_tree_view_column_pack_start(column, renderer, TRUE);
+         gtk_tree_view_column_set_cell_data_func(column, renderer, schedule_cell_data,
+                                                 GINT_TO_POINTER(field), NULL);
+     } else {
+         column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", field, NULL);
+     }
+     gtk_tree_view_column_set_sort_column_id(column, field);
+     gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
+     gtk_tree_view_column_set_fixed_width(column, 110);
+     gtk_tree_view_column_set_resizable(column, TRUE);
+     gtk_tree_view_append_column(GTK_TREE_VIEW(schedule_list), column);
+ }
+ 
 void clearRunwayAssignments() {
     for (int i = 0; i < flightCount; i++) {
         flights[i].runwayAssigned = -1;
@@ -1413,9 +6935,6 @@ void clearRunwayAssignments() {
     }
     
     addNotification("All runway assignments cleared", false, false);
-    update_runway_list();
-    update_flight_list();
-    update_schedule_list();
 }
 
 void clearCrewAssignments() {
@@ -1431,25 +6950,502 @@ void clearCrewAssignments() {
     }
     
     addNotification("All crew assignments cleared", false, false);
-    update_crew_list();
-    update_flight_list();
-    update_schedule_list();
 }
 
 void on_clear_runways_clicked(GtkWidget *widget, gpointer data) {
+    TRACE_SCOPE(__func__, "ui");
+    beginScheduleAction("Clear runway assignments");
     clearRunwayAssignments();
+    commitScheduleWrite();
     gtk_label_set_text(GTK_LABEL(notification_label), "Runway assignments cleared");
 }
 
 void on_clear_crew_clicked(GtkWidget *widget, gpointer data) {
+    TRACE_SCOPE(__func__, "ui");
+    beginScheduleAction("Clear crew assignments");
     clearCrewAssignments();
+    commitScheduleWrite();
     gtk_label_set_text(GTK_LABEL(notification_label), "Crew assignments cleared");
 }
  
+ // The history mixes every role's actions, so undo and redo belong to the
+ // realtime events screen and are allowed only where that screen is.
+ static bool canUndoSchedule() {
+     const char *screen = gtk_stack_get_visible_child_name(GTK_STACK(stack));
+     return scheduleLoaded && !viewerProcess && currentUser.role == ADMIN && screen &&
+            strcmp(screen, "realtime_events") == 0;
+ }
+ 
+ void on_undo_clicked(GtkWidget *widget, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     if (!canUndoSchedule()) return;
+     beginScheduleWrite();
+     undoScheduleAction();
+     commitScheduleWrite();
+ }
+ 
+ void on_redo_clicked(GtkWidget *widget, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     if (!canUndoSchedule()) return;
+     beginScheduleWrite();
+     redoScheduleAction();
+     commitScheduleWrite();
+ }
+ 
+ // Ctrl+Z undoes; Ctrl+Shift+Z and Ctrl+Y redo. Elsewhere the keys are left to
+ // the focused widget.
+ gboolean on_window_key_press(GtkWidget *widget, GdkEventKey *event, gpointer data) {
+     if (!(event->state & GDK_CONTROL_MASK) || !canUndoSchedule()) return FALSE;
+     if (event->keyval == GDK_KEY_z && !(event->state & GDK_SHIFT_MASK)) {
+         on_undo_clicked(widget, NULL);
+         return TRUE;
+     }
+     if (event->keyval == GDK_KEY_Z || event->keyval == GDK_KEY_y) {
+         on_redo_clicked(widget, NULL);
+         return TRUE;
+     }
+     return FALSE;
+ }
+ 
  void show_notification(const char *message) {
      gtk_label_set_text(GTK_LABEL(notification_label), message);
  }
  
+ #ifndef FMS_NO_METRICS
+ // Writes every metric in Prometheus text format. The file is written under a
+ // temporary name and renamed, so a scraper never sees a partial file.
+ bool writeMetricsFile(const char *path) {
+     static const char *const latencyNames[LATENCY_METRIC_COUNT][2] = {
+         {"fms_assign_runways_seconds", "Duration of runway assignment passes"},
+         {"fms_schedule_crew_seconds", "Duration of crew scheduling passes"},
+         {"fms_reschedule_seconds", "Duration of full reschedules"},
+         {"fms_publish_seconds", "Duration of schedule version publication"},
+         {"fms_save_seconds", "Duration of data file writes"},
+         {"fms_load_seconds", "Duration of data file reads"},
+         {"fms_ui_refresh_seconds", "Duration of coalesced UI refresh passes"},
+         {"fms_timeline_draw_seconds", "Duration of timeline redraws"},
+         {"fms_report_seconds", "Duration of background report jobs"}
+     };
+     static const char *const counterNames[COUNTER_METRIC_COUNT][2] = {
+         {"fms_runway_candidates_evaluated_total", "Runway candidates checked by the runway planner"},
+         {"fms_crew_candidates_evaluated_total", "Crew candidates checked by the crew planner"},
+         {"fms_save_bytes_total", "Bytes written to data files"},
+         {"fms_load_bytes_total", "Bytes read from data files"},
+         {"fms_notifications_total", "Notifications raised"},
+         {"fms_arena_blocks_allocated_total", "Scratch arena blocks allocated"}
+     };
+ 
+     char tempPath[256];
+     snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+     FILE *file = fopen(tempPath, "w");
+     if (!file) return false;
+ 
+     for (int m = 0; m < LATENCY_METRIC_COUNT; m++) {
+         const LatencyHistogram *h = &latencyMetrics[m];
+         fprintf(file, "# HELP %s %s\n# TYPE %s histogram\n", latencyNames[m][0], latencyNames[m][1], latencyNames[m][0]);
+         gsize cumulative = 0;
+         for (int b = 0; b < LATENCY_BUCKETS - 1; b++) {
+             cumulative += (gsize)g_atomic_pointer_get(&h->buckets[b]);
+             fprintf(file, "%s_bucket{le=\"%g\"} %zu\n", latencyNames[m][0], (double)(1 << b) / G_USEC_PER_SEC, cumulative);
+         }
+         cumulative += (gsize)g_atomic_pointer_get(&h->buckets[LATENCY_BUCKETS - 1]);
+         fprintf(file, "%s_bucket{le=\"+Inf\"} %zu\n", latencyNames[m][0], cumulative);
+         fprintf(file, "%s_sum %.6f\n", latencyNames[m][0], (gsize)g_atomic_pointer_get(&h->sumMicroseconds) / 1e6);
+         fprintf(file, "%s_count %zu\n", latencyNames[m][0], (gsize)g_atomic_pointer_get(&h->count));
+     }
+ 
+     for (int c = 0; c < COUNTER_METRIC_COUNT; c++) {
+         fprintf(file, "# HELP %s %s\n# TYPE %s counter\n%s %zu\n", counterNames[c][0], counterNames[c][1],
+                 counterNames[c][0], counterNames[c][0], (gsize)g_atomic_pointer_get(&counterMetrics[c]));
+     }
+ 
+     // The loader and replication threads publish while this runs, so the
+     // state is pinned while its fields are read.
+     int readerSlot = registerStateReader();
+     if (readerSlot >= 0) {
+         const ScheduleState *state = pinScheduleState(readerSlot);
+         bool published = state != NULL;
+         guint64 version = published ? state->version : 0;
+         int publishedFlights = published ? state->flightCount : 0;
+         unpinScheduleState(readerSlot);
+         unregisterStateReader(readerSlot);
+ 
+         if (published) {
+             fprintf(file, "# HELP fms_schedule_version Published schedule version\n# TYPE fms_schedule_version gauge\n");
+             fprintf(file, "fms_schedule_version %" G_GUINT64_FORMAT "\n", version);
+             fprintf(file, "# HELP fms_flights Flights in the published schedule\n# TYPE fms_flights gauge\n");
+             fprintf(file, "fms_flights %d\n", publishedFlights);
+         }
+     }
+     fprintf(file, "# HELP fms_arena_high_water_bytes Largest scratch arena footprint of any planning pass\n");
+     fprintf(file, "# TYPE fms_arena_high_water_bytes gauge\nfms_arena_high_water_bytes %zu\n",
+             (gsize)g_atomic_pointer_get(&arenaHighWaterBytes));
+     fprintf(file, "# HELP fms_arena_reserved_bytes Memory held by scratch arenas\n");
+     fprintf(file, "# TYPE fms_arena_reserved_bytes gauge\nfms_arena_reserved_bytes %zu\n",
+             (gsize)g_atomic_pointer_get(&arenaReservedBytes));
+ 
+     int archiveSegmentCount, archived;
+     gsize archiveBytes;
+     archiveStats(&archiveSegmentCount, &archived, &archiveBytes);
+     fprintf(file, "# HELP fms_archived_flights Flights moved to the archive\n");
+     fprintf(file, "# TYPE fms_archived_flights gauge\nfms_archived_flights %d\n", archived);
+     fprintf(file, "# HELP fms_archive_bytes Encoded size of the flight archive\n");
+     fprintf(file, "# TYPE fms_archive_bytes gauge\nfms_archive_bytes %zu\n", archiveBytes);
+ 
+     bool ok = fclose(file) == 0;
+     return ok && rename(tempPath, path) == 0;
+ }
+ 
+ // FILENAME_METRICS belongs to the replication leader. Viewers and standby
+ // planners would overwrite it, so each writes a file named after its role and
+ // pid instead, and removes it on exit or once it becomes the leader.
+ static void metricsFilePath(char *path, size_t size) {
+     if (!viewerProcess && replicationListenFd >= 0) {
+         g_strlcpy(path, FILENAME_METRICS, size);
+     } else {
+         snprintf(path, size, "metrics-%s-%d.prom", viewerProcess ? "viewer" : "standby", (int)getpid());
+     }
+ }
+ 
+ gboolean export_metrics_tick(gpointer data) {
+     static char lastPath[64];
+     char path[64];
+     metricsFilePath(path, sizeof(path));
+     if (lastPath[0] && strcmp(lastPath, path) != 0) unlink(lastPath);
+     g_strlcpy(lastPath, path, sizeof(lastPath));
+     writeMetricsFile(path);
+     return G_SOURCE_CONTINUE;
+ }
+ 
+ void finishMetricsExport() {
+     char path[64];
+     metricsFilePath(path, sizeof(path));
+     if (strcmp(path, FILENAME_METRICS) == 0) {
+         writeMetricsFile(path);
+     } else {
+         unlink(path);
+     }
+ }
+ #endif
+ 
+ #ifndef FMS_NO_TRACING
+ static void retireTraceBuffer(gpointer data);
+ 
+ FILE *traceFile = NULL;
+ GAsyncQueue *traceQueue = NULL;
+ GThread *traceWriter = NULL;
+ GPtrArray *traceLiveBuffers = NULL;
+ GMutex traceLock;
+ gint traceNextTid = 0;
+ GPrivate traceBufferKey = G_PRIVATE_INIT(retireTraceBuffer);
+ 
+ static TraceBuffer* newTraceBuffer(int tid, const char *threadName) {
+     TraceBuffer *buffer = g_new(TraceBuffer, 1);
+     buffer->tid = tid;
+     buffer->threadName = threadName;
+     buffer->used = 0;
+     return buffer;
+ }
+ 
+ static TraceBuffer* currentTraceBuffer() {
+     TraceBuffer *buffer = g_private_get(&traceBufferKey);
+     if (buffer) return buffer;
+ 
+     buffer = newTraceBuffer(g_atomic_int_add(&traceNextTid, 1) + 1, NULL);
+     g_mutex_lock(&traceLock);
+     if (traceLiveBuffers) g_ptr_array_add(traceLiveBuffers, buffer);
+     g_mutex_unlock(&traceLock);
+     g_private_set(&traceBufferKey, buffer);
+     return buffer;
+ }
+ 
+ // Called with traceLock held.
+ static void queueTraceBuffer(TraceBuffer *buffer) {
+     if (traceQueue) g_async_queue_push(traceQueue, buffer);
+     else g_free(buffer);
+ }
+ 
+ static void retireTraceBuffer(gpointer data) {
+     TraceBuffer *buffer = data;
+     g_mutex_lock(&traceLock);
+     if (traceLiveBuffers) g_ptr_array_remove_fast(traceLiveBuffers, buffer);
+     queueTraceBuffer(buffer);
+     g_mutex_unlock(&traceLock);
+ }
+ 
+ void traceThreadName(const char *name) {
+     if (!g_atomic_int_get(&tracingEnabled)) return;
+     currentTraceBuffer()->threadName = name;
+ }
+ 
+ void traceRecord(const char *name, const char *category, gint64 start, gint64 end) {
+     TraceBuffer *buffer = currentTraceBuffer();
+     int used = buffer->used;
+ 
+     if (used == TRACE_BUFFER_EVENTS) {
+         TraceBuffer *fresh = newTraceBuffer(buffer->tid, buffer->threadName);
+         g_mutex_lock(&traceLock);
+         if (traceLiveBuffers) {
+             g_ptr_array_remove_fast(traceLiveBuffers, buffer);
+             g_ptr_array_add(traceLiveBuffers, fresh);
+         }
+         queueTraceBuffer(buffer);
+         g_mutex_unlock(&traceLock);
+         g_private_set(&traceBufferKey, fresh);
+         buffer = fresh;
+         used = 0;
+     }
+ 
+     TraceEvent *event = &buffer->events[used];
+     event->name = name;
+     event->category = category;
+     event->start = start;
+     event->duration = end - start;
+     g_atomic_int_set(&buffer->used, used + 1);
+ }
+ 
+ static gpointer trace_writer_thread(gpointer data) {
+     GHashTable *namedThreads = g_hash_table_new(g_direct_hash, g_direct_equal);
+     bool first = true;
+     int pid = (int)getpid();
+ 
+     while (true) {
+         TraceBuffer *buffer = g_async_queue_pop(traceQueue);
+         if (buffer->tid < 0) {
+             g_free(buffer);
+             break;
+         }
+ 
+         int used = g_atomic_int_get(&buffer->used);
+         if (buffer->threadName && !g_hash_table_lookup(namedThreads, GINT_TO_POINTER(buffer->tid))) {
+             g_hash_table_insert(namedThreads, GINT_TO_POINTER(buffer->tid), GINT_TO_POINTER(1));
+             fprintf(traceFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                     first ? "\n" : ",\n", pid, buffer->tid, buffer->threadName);
+             first = false;
+         }
+         for (int i = 0; i < used; i++) {
+             const TraceEvent *event = &buffer->events[i];
+             fprintf(traceFile, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%" G_GINT64_FORMAT
+                     ",\"dur\":%" G_GINT64_FORMAT ",\"pid\":%d,\"tid\":%d}",
+                     first ? "\n" : ",\n", event->name, event->category, event->start, event->duration,
+                     pid, buffer->tid);
+             first = false;
+         }
+         g_free(buffer);
+     }
+ 
+     g_hash_table_destroy(namedThreads);
+     return NULL;
+ }
+ 
+ bool startTracing(const char *path) {
+     traceFile = fopen(path, "w");
+     if (!traceFile) {
+         fprintf(stderr, "Cannot open trace file %s: %s\n", path, g_strerror(errno));
+         return false;
+     }
+     fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", traceFile);
+ 
+     g_mutex_lock(&traceLock);
+     traceQueue = g_async_queue_new();
+     traceLiveBuffers = g_ptr_array_new();
+     g_mutex_unlock(&traceLock);
+     traceWriter = g_thread_new("trace-writer", trace_writer_thread, NULL);
+     g_atomic_int_set(&tracingEnabled, 1);
+     return true;
+ }
+ 
+ // Flushes what every live thread has recorded so far and closes the file.
+ // Threads that are still running keep their buffers; only the published
+ // prefix is copied.
+ void stopTracing() {
+     if (!g_atomic_int_get(&tracingEnabled)) return;
+     g_atomic_int_set(&tracingEnabled, 0);
+ 
+     g_mutex_lock(&traceLock);
+     for (guint i = 0; i < traceLiveBuffers->len; i++) {
+         TraceBuffer *live = g_ptr_array_index(traceLiveBuffers, i);
+         int used = g_atomic_int_get(&live->used);
+         TraceBuffer *copy = newTraceBuffer(live->tid, live->threadName);
+         memcpy(copy->events, live->events, sizeof(TraceEvent) * used);
+         copy->used = used;
+         g_async_queue_push(traceQueue, copy);
+     }
+     g_async_queue_push(traceQueue, newTraceBuffer(-1, NULL));
+     g_mutex_unlock(&traceLock);
+ 
+     g_thread_join(traceWriter);
+ 
+     g_mutex_lock(&traceLock);
+     g_async_queue_unref(traceQueue);
+     traceQueue = NULL;
+     g_ptr_array_free(traceLiveBuffers, TRUE);
+     traceLiveBuffers = NULL;
+     g_mutex_unlock(&traceLock);
+ 
+     fputs("\n]}\n", traceFile);
+     fclose(traceFile);
+     traceFile = NULL;
+ }
+ #endif
+ 
+ // Startup shows the login screen first and loads the schedule (from the data
+ // files, or by following a leader until it goes away) on a worker thread that
+ // holds the write lock for the whole load. Logins wait for it to finish.
+ // Only the instance that wins replication leadership publishes the shared
+ // schedule for viewers.
+ gpointer load_schedule_thread(gpointer data) {
+     bool follower = GPOINTER_TO_INT(data);
+     traceThreadName("schedule-loader");
+     TRACE_SCOPE("loadSchedule", "io");
+ 
+     beginScheduleWrite();
+     if (!follower || !runReplicationFollower(REPLICATION_SOCKET)) {
+         loadDataFromFiles();
+     } else {
+         // The replica carries only the live tables; flights the leader
+         // archived are read back from its archive file.
+         loadArchive(FILENAME_ARCHIVE);
+     }
+     startHostedAirports();
+     commitScheduleWrite();
+     if (startReplicationLeader(REPLICATION_SOCKET)) {
+         createSharedSchedule();
+     }
+ 
+     g_idle_add(on_schedule_loaded, NULL);
+     return NULL;
+ }
+ 
+ gboolean on_schedule_loaded(gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     g_thread_join(scheduleLoader);
+     scheduleLoader = NULL;
+     scheduleLoaded = true;
+ 
+     update_flight_list();
+     flight_model_rows_changed(0, flightCount);
+     invalidateSearchIndex();
+     markScheduleChanged(CHANGED_FLIGHTS | CHANGED_RUNWAYS | CHANGED_CREW);
+ 
+     if (loginPending) {
+         on_login_clicked(NULL, NULL);
+     }
+     return G_SOURCE_REMOVE;
+ }
+ 
+ // Polls the planner's segment. When the planner goes away the last schedule
+ // stays on screen and the viewer keeps trying to map a new segment. A read
+ // that cannot get a stable copy is left for the next tick.
+ gboolean refresh_from_shared_schedule(gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     if (viewerSchedule && viewerSchedule->magic != SHARED_SCHEDULE_MAGIC) {
+         unmapSharedSchedule(viewerSchedule);
+         viewerSchedule = NULL;
+         addNotification("Planner stopped; showing the last published schedule", true, false);
+     }
+     if (!viewerSchedule) {
+         viewerSchedule = mapSharedSchedule();
+         if (!viewerSchedule) return G_SOURCE_CONTINUE;
+         viewerScheduleVersion = G_MAXUINT64;
+     }
+     if (viewerSchedule->version == viewerScheduleVersion) {
+         return G_SOURCE_CONTINUE;
+     }
+ 
+     if (!viewerFlights) {
+         viewerFlights = g_new0(Flight, config.maxFlights);
+         viewerRunways = g_new0(Runway, config.maxRunways);
+         viewerCrew = g_new0(Crew, config.maxCrew);
+     }
+ 
+     gint start;
+     guint64 version;
+     int newFlightCount, newRunwayCount, newCrewCount;
+     int attempts = 0;
+     do {
+         if (++attempts > SHARED_SCHEDULE_READ_ATTEMPTS || !sharedScheduleReadBegin(viewerSchedule, &start)) {
+             return G_SOURCE_CONTINUE;
+         }
+         version = viewerSchedule->version;
+         newFlightCount = CLAMP(viewerSchedule->flightCount, 0, MIN(config.maxFlights, viewerSchedule->flightCapacity));
+         newRunwayCount = CLAMP(viewerSchedule->runwayCount, 0, MIN(config.maxRunways, viewerSchedule->runwayCapacity));
+         newCrewCount = CLAMP(viewerSchedule->crewCount, 0, MIN(config.maxCrew, viewerSchedule->crewCapacity));
+         memcpy(viewerFlights, sharedScheduleFlights(viewerSchedule), sizeof(Flight) * newFlightCount);
+         memcpy(viewerRunways, sharedScheduleRunways(viewerSchedule), sizeof(Runway) * newRunwayCount);
+         memcpy(viewerCrew, sharedScheduleCrew(viewerSchedule), sizeof(Crew) * newCrewCount);
+     } while (sharedScheduleReadRetry(viewerSchedule, start));
+ 
+     // Committed like any other write, so reports, metrics and as-of queries
+     // that read the published state and its history see the planner's rows.
+     beginScheduleWrite();
+     flightCount = newFlightCount;
+     runwayCount = newRunwayCount;
+     crewCount = newCrewCount;
+     memcpy(flights, viewerFlights, sizeof(Flight) * flightCount);
+     memcpy(runways, viewerRunways, sizeof(Runway) * runwayCount);
+     memcpy(crews, viewerCrew, sizeof(Crew) * crewCount);
+     commitScheduleWrite();
+     viewerScheduleVersion = version;
+ 
+     update_flight_list();
+     invalidateSearchIndex();
+     return G_SOURCE_CONTINUE;
+ }
+ 
+ // Commits only record what changed; a single idle callback per frame then
+ // redraws the screens that show it. It runs just above GTK's redraw priority
+ // so a burst of commits produces one repaint. Hidden text screens are skipped
+ // because switch_to_screen() refreshes them on navigation.
+ void markScheduleChanged(guint changes) {
+     if (changes == 0) return;
+ 
+     g_atomic_int_or((guint *)&pendingChanges, changes);
+     if (g_atomic_int_compare_and_exchange(&refreshScheduled, 0, 1)) {
+         g_idle_add_full(G_PRIORITY_HIGH_IDLE + 10, flush_ui_refresh, NULL, NULL);
+     }
+ }
+ 
+ gboolean flush_ui_refresh(gpointer data) {
+     SCOPED_TIMER(METRIC_UI_REFRESH);
+     TRACE_SCOPE(__func__, "ui");
+     g_atomic_int_set(&refreshScheduled, 0);
+     guint changes = g_atomic_int_and((guint *)&pendingChanges, 0);
+     const char *visible = gtk_stack_get_visible_child_name(GTK_STACK(stack));
+     if (!visible) visible = "";
+ 
+     if (changes & CHANGED_FLIGHTS) {
+         update_flight_list();
+     }
+     if ((changes & CHANGED_RUNWAYS) && strcmp(visible, "runway_management") == 0) {
+         update_runway_list();
+     }
+     if ((changes & CHANGED_CREW) && strcmp(visible, "crew_management") == 0) {
+         update_crew_list();
+     }
+     if (changes) {
+         update_timeline();
+     }
+     return G_SOURCE_REMOVE;
+ }
+ 
+ gboolean drain_notifications_to_label(gpointer data) {
+     Notification n;
+     Notification latest;
+     bool found = false;
+ 
+     while (readNotification(labelSubscriber, &n)) {
+         if (n.isWarning || n.isError) {
+             latest = n;
+             found = true;
+         }
+     }
+     if (found) {
+         show_notification(latest.message);
+     }
+     return G_SOURCE_CONTINUE;
+ }
+ 
  
  void create_login_screen() {
     login_grid = gtk_grid_new();
@@ -1499,13 +7495,9 @@ gtk_grid_attach(GTK_GRID(login_grid), notification_label, 0, 4, 2, 1);
     gtk_stack_add_named(GTK_STACK(stack), login_grid, "login");
 }
  
-void create_main_menu() {
-
-    GtkWidget *existing_menu = gtk_stack_get_child_by_name(GTK_STACK(stack), "main_menu");
-    if (existing_menu) {
-        gtk_container_remove(GTK_CONTAINER(stack), existing_menu);
-    }
-
+// Main menus are built once per role and kept alive while another role's menu
+// is in the stack; logging in again only swaps the grid and updates the labels.
+static void build_main_menu(MainMenu *menu) {
     main_menu_grid = gtk_grid_new();
     gtk_grid_set_row_spacing(GTK_GRID(main_menu_grid), 10);
     gtk_grid_set_column_spacing(GTK_GRID(main_menu_grid), 10);
@@ -1516,21 +7508,12 @@ void create_main_menu() {
     GtkWidget *header = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
     gtk_widget_set_hexpand(header, TRUE);
 
-    char welcome_text[256];
-    sprintf(welcome_text, "Welcome, %s (%s)", 
-            currentUser.username,
-            currentUser.role == ADMIN ? "Admin" : 
-            currentUser.role == FLIGHT_SCHEDULER ? "Flight Scheduler" :
-            currentUser.role == CREW_SCHEDULER ? "Crew Scheduler" : "Viewer");
-    GtkWidget *welcome_label = gtk_label_new(welcome_text);
-    gtk_box_pack_start(GTK_BOX(header), welcome_label, FALSE, FALSE, 0);
+    menu->welcome_label = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(header), menu->welcome_label, FALSE, FALSE, 0);
 
-    Time now = getCurrentTime();
-    char time_str[10];
-    sprintf(time_str, "%02d:%02d", now.hour, now.minute);
-    GtkWidget *time_label = gtk_label_new(time_str);
-    gtk_widget_set_halign(time_label, GTK_ALIGN_END);
-    gtk_box_pack_end(GTK_BOX(header), time_label, FALSE, FALSE, 0);
+    menu->time_label = gtk_label_new("");
+    gtk_widget_set_halign(menu->time_label, GTK_ALIGN_END);
+    gtk_box_pack_end(GTK_BOX(header), menu->time_label, FALSE, FALSE, 0);
 
     gtk_grid_attach(GTK_GRID(main_menu_grid), header, 0, 0, 2, 1);
 
@@ -1582,6 +7565,11 @@ void create_main_menu() {
     gtk_grid_attach(GTK_GRID(main_menu_grid), search_button, 1, row, 1, 1);
     row++;
 
+    GtkWidget *timeline_button = gtk_button_new_with_label("Runway & Crew Timeline");
+    g_signal_connect(timeline_button, "clicked", G_CALLBACK(switch_to_screen), "timeline");
+    gtk_grid_attach(GTK_GRID(main_menu_grid), timeline_button, 0, row, 2, 1);
+    row++;
+
     if (currentUser.role == ADMIN || currentUser.role == VIEWER) {
         GtkWidget *reports_button = gtk_button_new_with_label("Reports");
         g_signal_connect(reports_button, "clicked", G_CALLBACK(switch_to_screen), "reports");
@@ -1589,13 +7577,45 @@ void create_main_menu() {
         row++;
     }
 
-    GtkWidget *logout_button = gtk_button_new_with_label("Logout");
-    g_signal_connect(logout_button, "clicked", G_CALLBACK(on_logout_clicked), NULL);
-    gtk_grid_attach(GTK_GRID(main_menu_grid), logout_button, 0, row, 2, 1);
+    GtkWidget *logout_button = gtk_button_new_with_label("Logout");
+    g_signal_connect(logout_button, "clicked", G_CALLBACK(on_logout_clicked), NULL);
+    gtk_grid_attach(GTK_GRID(main_menu_grid), logout_button, 0, row, 2, 1);
+
+    menu->grid = g_object_ref_sink(main_menu_grid);
+}
+
+void create_main_menu() {
+    MainMenu *menu = &mainMenus[currentUser.role];
+
+    GtkWidget *existing_menu = gtk_stack_get_child_by_name(GTK_STACK(stack), "main_menu");
+    if (existing_menu && existing_menu != menu->grid) {
+        gtk_container_remove(GTK_CONTAINER(stack), existing_menu);
+        existing_menu = NULL;
+    }
+
+    if (!menu->grid) {
+        build_main_menu(menu);
+    }
+    main_menu_grid = menu->grid;
 
-    gtk_stack_add_named(GTK_STACK(stack), main_menu_grid, "main_menu");
-    gtk_stack_set_visible_child_name(GTK_STACK(stack), "main_menu");
+    char welcome_text[256];
+    sprintf(welcome_text, "Welcome, %s (%s)", 
+            currentUser.username,
+            currentUser.role == ADMIN ? "Admin" : 
+            currentUser.role == FLIGHT_SCHEDULER ? "Flight Scheduler" :
+            currentUser.role == CREW_SCHEDULER ? "Crew Scheduler" : "Viewer");
+    gtk_label_set_text(GTK_LABEL(menu->welcome_label), welcome_text);
+
+    Time now = getCurrentTime();
+    char time_str[10];
+    sprintf(time_str, "%02d:%02d", now.hour, now.minute);
+    gtk_label_set_text(GTK_LABEL(menu->time_label), time_str);
+
+    if (!existing_menu) {
+        gtk_stack_add_named(GTK_STACK(stack), main_menu_grid, "main_menu");
+    }
     gtk_widget_show_all(main_menu_grid);
+    gtk_stack_set_visible_child_name(GTK_STACK(stack), "main_menu");
 }
  
  void create_flight_management() {
@@ -1626,13 +7646,16 @@ void create_main_menu() {
     GtkCellRenderer *flight_renderer = gtk_cell_renderer_text_new();
     GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes("Flight ID",
                                                                        flight_renderer,
-                                                                       "text", 0,
+                                                                       "text", FLIGHT_COL_ID,
                                                                        NULL);
     gtk_tree_view_append_column(GTK_TREE_VIEW(flight_list), column);
 
-    GtkListStore *flight_store = gtk_list_store_new(2, G_TYPE_STRING, G_TYPE_POINTER);
-    gtk_tree_view_set_model(GTK_TREE_VIEW(flight_list), GTK_TREE_MODEL(flight_store));
-    g_object_unref(flight_store);
+    gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(flight_list), TRUE);
+    gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
+    gtk_tree_view_column_set_fixed_width(column, 120);
+
+    if (!flightModel) flightModel = flight_model_new();
+    gtk_tree_view_set_model(GTK_TREE_VIEW(flight_list), GTK_TREE_MODEL(flightModel));
 
     GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(flight_list));
     g_signal_connect(selection, "changed", G_CALLBACK(on_flight_selected), NULL);
@@ -1916,6 +7939,16 @@ gtk_grid_attach(GTK_GRID(realtime_events_grid), reschedule_button, 0, 4, 1, 1);
     g_signal_connect(clear_crew_button, "clicked", G_CALLBACK(on_clear_crew_clicked), NULL);
     gtk_grid_attach(GTK_GRID(realtime_events_grid), clear_crew_button, 0, 6, 1, 1);
 
+    GtkWidget *undo_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    GtkWidget *undo_button = gtk_button_new_with_label("Undo");
+    g_signal_connect(undo_button, "clicked", G_CALLBACK(on_undo_clicked), NULL);
+    gtk_box_pack_start(GTK_BOX(undo_box), undo_button, TRUE, TRUE, 0);
+    GtkWidget *redo_button = gtk_button_new_with_label("Redo");
+    g_signal_connect(redo_button, "clicked", G_CALLBACK(on_redo_clicked), NULL);
+    gtk_box_pack_start(GTK_BOX(undo_box), redo_button, TRUE, TRUE, 0);
+    gtk_widget_set_sensitive(undo_box, currentUser.role != VIEWER);
+    gtk_grid_attach(GTK_GRID(realtime_events_grid), undo_box, 0, 8, 1, 1);
+
 
     gtk_grid_attach(GTK_GRID(realtime_events_grid), notification_label, 0, 7, 1, 1);
  
@@ -1953,17 +7986,49 @@ gtk_grid_attach(GTK_GRID(realtime_events_grid), reschedule_button, 0, 4, 1, 1);
      gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled_window),
                                    GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
  
-     schedule_list = gtk_text_view_new();
-     gtk_text_view_set_editable(GTK_TEXT_VIEW(schedule_list), FALSE);
-     gtk_text_view_set_cursor_visible(GTK_TEXT_VIEW(schedule_list), FALSE);
-     gtk_text_view_set_monospace(GTK_TEXT_VIEW(schedule_list), TRUE);
+     GtkWidget *filter_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+ 
+     schedule_filter_entry = gtk_search_entry_new();
+     gtk_entry_set_placeholder_text(GTK_ENTRY(schedule_filter_entry), "Filter by flight ID or airport");
+     g_signal_connect(schedule_filter_entry, "changed", G_CALLBACK(on_schedule_filter_changed), NULL);
+     gtk_box_pack_start(GTK_BOX(filter_box), schedule_filter_entry, TRUE, TRUE, 0);
+ 
+     schedule_status_combo = gtk_combo_box_text_new();
+     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(schedule_status_combo), "All statuses");
+     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(schedule_status_combo), "Scheduled");
+     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(schedule_status_combo), "Delayed");
+     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(schedule_status_combo), "Cancelled");
+     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(schedule_status_combo), "Emergency");
+     gtk_combo_box_set_active(GTK_COMBO_BOX(schedule_status_combo), 0);
+     g_signal_connect(schedule_status_combo, "changed", G_CALLBACK(on_schedule_filter_changed), NULL);
+     gtk_box_pack_start(GTK_BOX(filter_box), schedule_status_combo, FALSE, FALSE, 0);
+ 
+     gtk_grid_attach(GTK_GRID(schedule_grid), filter_box, 0, 1, 1, 1);
+ 
+     if (!flightModel) flightModel = flight_model_new();
+     scheduleFilterModel = gtk_tree_model_filter_new(GTK_TREE_MODEL(flightModel), NULL);
+     gtk_tree_model_filter_set_visible_func(GTK_TREE_MODEL_FILTER(scheduleFilterModel),
+                                            schedule_row_visible, NULL, NULL);
+     GtkTreeModel *sort_model = gtk_tree_model_sort_new_with_model(scheduleFilterModel);
+ 
+     schedule_list = gtk_tree_view_new_with_model(sort_model);
+     g_object_unref(sort_model);
+     gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(schedule_list), TRUE);
+     add_schedule_column("Flight ID", FLIGHT_COL_ID, false);
+     add_schedule_column("Departure", FLIGHT_COL_DEPARTURE, true);
+     add_schedule_column("Arrival", FLIGHT_COL_ARRIVAL, true);
+     add_schedule_column("Origin", FLIGHT_COL_ORIGIN, false);
+     add_schedule_column("Destination", FLIGHT_COL_DESTINATION, false);
+     add_schedule_column("Status", FLIGHT_COL_STATUS, true);
+     add_schedule_column("Runway", FLIGHT_COL_RUNWAY, true);
+     add_schedule_column("Crew", FLIGHT_COL_CREW, false);
      gtk_container_add(GTK_CONTAINER(scrolled_window), schedule_list);
-     gtk_grid_attach(GTK_GRID(schedule_grid), scrolled_window, 0, 1, 1, 1);
+     gtk_grid_attach(GTK_GRID(schedule_grid), scrolled_window, 0, 2, 1, 1);
  
 
      notification_label = gtk_label_new("");
      gtk_widget_set_halign(notification_label, GTK_ALIGN_START);
-     gtk_grid_attach(GTK_GRID(schedule_grid), notification_label, 0, 2, 1, 1);
+     gtk_grid_attach(GTK_GRID(schedule_grid), notification_label, 0, 3, 1, 1);
  
      gtk_stack_add_named(GTK_STACK(stack), schedule_grid, "schedule");
  }
@@ -1989,7 +8054,9 @@ gtk_grid_attach(GTK_GRID(realtime_events_grid), reschedule_button, 0, 4, 1, 1);
  
 
      search_entry = gtk_entry_new();
-     gtk_entry_set_placeholder_text(GTK_ENTRY(search_entry), "Enter flight ID");
+     gtk_entry_set_placeholder_text(GTK_ENTRY(search_entry),
+                                    "Flight ID, airport or aircraft type, or a filter such as status=delayed dep>=14:00");
+     g_signal_connect(search_entry, "changed", G_CALLBACK(on_search_clicked), NULL);
      gtk_grid_attach(GTK_GRID(search_flight_grid), search_entry, 0, 1, 1, 1);
  
 
@@ -2004,16 +8071,38 @@ gtk_grid_attach(GTK_GRID(realtime_events_grid), reschedule_button, 0, 4, 1, 1);
      gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled_window),
                                    GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
  
-     search_results = gtk_text_view_new();
-     gtk_text_view_set_editable(GTK_TEXT_VIEW(search_results), FALSE);
-     gtk_text_view_set_cursor_visible(GTK_TEXT_VIEW(search_results), FALSE);
+     searchPageStore = gtk_list_store_new(7, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+                                          G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+     search_results = gtk_tree_view_new_with_model(GTK_TREE_MODEL(searchPageStore));
+     g_object_unref(searchPageStore);
+     const char *search_titles[] = {"Flight ID", "Origin", "Destination", "Aircraft",
+                                    "Departure", "Arrival", "Status"};
+     for (int i = 0; i < 7; i++) {
+         GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+         GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes(search_titles[i],
+                                                                            renderer, "text", i, NULL);
+         gtk_tree_view_append_column(GTK_TREE_VIEW(search_results), column);
+     }
      gtk_container_add(GTK_CONTAINER(scrolled_window), search_results);
      gtk_grid_attach(GTK_GRID(search_flight_grid), scrolled_window, 0, 3, 1, 1);
  
+     GtkWidget *page_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+     search_prev_button = gtk_button_new_with_label("Previous");
+     g_signal_connect(search_prev_button, "clicked", G_CALLBACK(on_search_page_clicked), GINT_TO_POINTER(-1));
+     gtk_widget_set_sensitive(search_prev_button, FALSE);
+     gtk_box_pack_start(GTK_BOX(page_box), search_prev_button, FALSE, FALSE, 0);
+     search_page_label = gtk_label_new("");
+     gtk_box_pack_start(GTK_BOX(page_box), search_page_label, TRUE, TRUE, 0);
+     search_next_button = gtk_button_new_with_label("Next");
+     g_signal_connect(search_next_button, "clicked", G_CALLBACK(on_search_page_clicked), GINT_TO_POINTER(1));
+     gtk_widget_set_sensitive(search_next_button, FALSE);
+     gtk_box_pack_end(GTK_BOX(page_box), search_next_button, FALSE, FALSE, 0);
+     gtk_grid_attach(GTK_GRID(search_flight_grid), page_box, 0, 4, 1, 1);
+ 
 
      notification_label = gtk_label_new("");
      gtk_widget_set_halign(notification_label, GTK_ALIGN_START);
-     gtk_grid_attach(GTK_GRID(search_flight_grid), notification_label, 0, 4, 1, 1);
+     gtk_grid_attach(GTK_GRID(search_flight_grid), notification_label, 0, 5, 1, 1);
  
      gtk_stack_add_named(GTK_STACK(stack), search_flight_grid, "search_flight");
  }
@@ -2037,18 +8126,58 @@ gtk_grid_attach(GTK_GRID(realtime_events_grid), reschedule_button, 0, 4, 1, 1);
  
      gtk_grid_attach(GTK_GRID(reports_grid), header, 0, 0, 1, 1);
  
+     GtkWidget *options_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+     gtk_box_pack_start(GTK_BOX(options_box), gtk_label_new("Output:"), FALSE, FALSE, 0);
+     report_format_combo = gtk_combo_box_text_new();
+     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(report_format_combo), "Screen only");
+     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(report_format_combo), "CSV file");
+     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(report_format_combo), "JSON file");
+     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(report_format_combo), "HTML file");
+     gtk_combo_box_set_active(GTK_COMBO_BOX(report_format_combo), REPORT_TEXT);
+     gtk_box_pack_start(GTK_BOX(options_box), report_format_combo, FALSE, FALSE, 0);
+ 
+     report_filter_entry = gtk_entry_new();
+     gtk_entry_set_placeholder_text(GTK_ENTRY(report_filter_entry), "Flight filter, e.g. status=delayed runway=1");
+     gtk_widget_set_hexpand(report_filter_entry, TRUE);
+     gtk_box_pack_start(GTK_BOX(options_box), report_filter_entry, TRUE, TRUE, 0);
+ 
+     gtk_box_pack_start(GTK_BOX(options_box), gtk_label_new("As of:"), FALSE, FALSE, 0);
+     report_as_of_entry = gtk_entry_new();
+     gtk_entry_set_placeholder_text(GTK_ENTRY(report_as_of_entry), "HH:MM");
+     gtk_entry_set_width_chars(GTK_ENTRY(report_as_of_entry), 6);
+     gtk_box_pack_start(GTK_BOX(options_box), report_as_of_entry, FALSE, FALSE, 0);
+ 
+     gtk_box_pack_start(GTK_BOX(options_box), gtk_label_new("Compare to:"), FALSE, FALSE, 0);
+     report_compare_entry = gtk_entry_new();
+     gtk_entry_set_placeholder_text(GTK_ENTRY(report_compare_entry), "now");
+     gtk_entry_set_width_chars(GTK_ENTRY(report_compare_entry), 6);
+     gtk_box_pack_start(GTK_BOX(options_box), report_compare_entry, FALSE, FALSE, 0);
+     gtk_grid_attach(GTK_GRID(reports_grid), options_box, 0, 1, 1, 1);
+ 
 
      GtkWidget *flights_report_button = gtk_button_new_with_label("Generate Flights Report");
      g_signal_connect(flights_report_button, "clicked", G_CALLBACK(on_generate_flights_report_clicked), NULL);
-     gtk_grid_attach(GTK_GRID(reports_grid), flights_report_button, 0, 1, 1, 1);
+     gtk_grid_attach(GTK_GRID(reports_grid), flights_report_button, 0, 2, 1, 1);
  
      GtkWidget *runways_report_button = gtk_button_new_with_label("Generate Runways Report");
      g_signal_connect(runways_report_button, "clicked", G_CALLBACK(on_generate_runways_report_clicked), NULL);
-     gtk_grid_attach(GTK_GRID(reports_grid), runways_report_button, 0, 2, 1, 1);
+     gtk_grid_attach(GTK_GRID(reports_grid), runways_report_button, 0, 3, 1, 1);
  
      GtkWidget *crew_report_button = gtk_button_new_with_label("Generate Crew Report");
      g_signal_connect(crew_report_button, "clicked", G_CALLBACK(on_generate_crew_report_clicked), NULL);
-     gtk_grid_attach(GTK_GRID(reports_grid), crew_report_button, 0, 3, 1, 1);
+     gtk_grid_attach(GTK_GRID(reports_grid), crew_report_button, 0, 4, 1, 1);
+ 
+     GtkWidget *delays_report_button = gtk_button_new_with_label("Generate Delay Percentile Report");
+     g_signal_connect(delays_report_button, "clicked", G_CALLBACK(on_generate_delays_report_clicked), NULL);
+     gtk_grid_attach(GTK_GRID(reports_grid), delays_report_button, 0, 5, 1, 1);
+ 
+     GtkWidget *changes_report_button = gtk_button_new_with_label("Generate Changes Report");
+     g_signal_connect(changes_report_button, "clicked", G_CALLBACK(on_generate_changes_report_clicked), NULL);
+     gtk_grid_attach(GTK_GRID(reports_grid), changes_report_button, 0, 6, 1, 1);
+ 
+     GtkWidget *archive_report_button = gtk_button_new_with_label("Generate Archive Report");
+     g_signal_connect(archive_report_button, "clicked", G_CALLBACK(on_generate_archive_report_clicked), NULL);
+     gtk_grid_attach(GTK_GRID(reports_grid), archive_report_button, 0, 7, 1, 1);
  
 
      GtkWidget *scrolled_window = gtk_scrolled_window_new(NULL, NULL);
@@ -2061,16 +8190,298 @@ gtk_grid_attach(GTK_GRID(realtime_events_grid), reschedule_button, 0, 4, 1, 1);
      gtk_text_view_set_editable(GTK_TEXT_VIEW(report_text), FALSE);
      gtk_text_view_set_cursor_visible(GTK_TEXT_VIEW(report_text), FALSE);
      gtk_container_add(GTK_CONTAINER(scrolled_window), report_text);
-     gtk_grid_attach(GTK_GRID(reports_grid), scrolled_window, 0, 4, 1, 1);
+     gtk_grid_attach(GTK_GRID(reports_grid), scrolled_window, 0, 8, 1, 1);
  
 
      notification_label = gtk_label_new("");
      gtk_widget_set_halign(notification_label, GTK_ALIGN_START);
-     gtk_grid_attach(GTK_GRID(reports_grid), notification_label, 0, 5, 1, 1);
+     gtk_grid_attach(GTK_GRID(reports_grid), notification_label, 0, 9, 1, 1);
+     report_status_label = notification_label;
  
      gtk_stack_add_named(GTK_STACK(stack), reports_grid, "reports");
  }
  
+ // Runway and crew timeline. Occupied intervals are cached per row, sorted by
+ // start, and rebuilt only after the schedule changes. A redraw touches just
+ // the rows inside the clip rectangle and, in each row, the intervals that
+ // overlap the visible time range: a binary search finds the first interval
+ // that can still reach the left edge. When zoomed out past one
+ // TIMELINE_BUCKET_MINUTES bucket per few pixels, rows are drawn from
+ // precomputed per-bucket occupancy instead of individual intervals.
+ static void clearTimelineRows() {
+     for (int r = 0; r < timelineRowCount; r++) {
+         g_array_free(timelineRows[r].intervals, TRUE);
+     }
+     g_free(timelineRows);
+     timelineRows = NULL;
+     timelineRowCount = 0;
+ }
+ 
+ static void addTimelineInterval(TimelineRow *row, int start, int length, int flight) {
+     TimelineInterval interval = {start, start + length, flight};
+     g_array_append_val(row->intervals, interval);
+     row->maxLength = MAX(row->maxLength, length);
+ 
+     for (int b = start / TIMELINE_BUCKET_MINUTES;
+          b < TIMELINE_BUCKETS && b * TIMELINE_BUCKET_MINUTES < interval.end; b++) {
+         int bucketStart = b * TIMELINE_BUCKET_MINUTES;
+         int overlap = MIN(interval.end, bucketStart + TIMELINE_BUCKET_MINUTES) - MAX(start, bucketStart);
+         row->busy[b] = MIN(row->busy[b] + overlap, G_MAXUINT16);
+     }
+ }
+ 
+ static gint compareTimelineIntervals(gconstpointer a, gconstpointer b) {
+     return ((const TimelineInterval *)a)->start - ((const TimelineInterval *)b)->start;
+ }
+ 
+ void rebuildTimeline() {
+     TRACE_SCOPE(__func__, "ui");
+     clearTimelineRows();
+     timelineRunwayRows = runwayCount;
+     timelineRowCount = runwayCount + crewCount;
+     timelineRows = g_new0(TimelineRow, MAX(timelineRowCount, 1));
+     for (int r = 0; r < timelineRowCount; r++) {
+         timelineRows[r].intervals = g_array_new(FALSE, FALSE, sizeof(TimelineInterval));
+     }
+ 
+     for (int i = 0; i < flightCount; i++) {
+         const Flight *f = &flights[i];
+         if (f->status == CANCELLED) continue;
+ 
+         int start = f->departureTime.hour * 60 + f->departureTime.minute;
+         int airborne = calculateTimeDifferenceInMinutes(f->departureTime, f->arrivalTime);
+         if (f->runwayAssigned >= 0 && f->runwayAssigned < runwayCount) {
+             addTimelineInterval(&timelineRows[f->runwayAssigned], start, airborne + config.bufferTime, i);
+         }
+         if (f->crewAssigned >= 0 && f->crewAssigned < crewCount) {
+             addTimelineInterval(&timelineRows[timelineRunwayRows + f->crewAssigned], start, airborne, i);
+         }
+     }
+ 
+     for (int r = 0; r < timelineRowCount; r++) {
+         g_array_sort(timelineRows[r].intervals, compareTimelineIntervals);
+     }
+     timelineStale = false;
+ }
+ 
+ static void setFlightColor(cairo_t *cr, const Flight *f) {
+     switch (f->status) {
+         case DELAYED: cairo_set_source_rgb(cr, 0.93, 0.55, 0.15); break;
+         case EMERGENCY_STATUS: cairo_set_source_rgb(cr, 0.85, 0.20, 0.20); break;
+         default: cairo_set_source_rgb(cr, 0.25, 0.50, 0.85); break;
+     }
+ }
+ 
+ static double timelineX(double minute) {
+     return TIMELINE_LABEL_WIDTH + (minute - timelineViewStart) / timelineMinutesPerPixel;
+ }
+ 
+ static void drawTimelineRow(cairo_t *cr, const TimelineRow *row, double y, double viewEnd) {
+     double top = y + 3, height = TIMELINE_ROW_HEIGHT - 6;
+ 
+     if (timelineMinutesPerPixel * TIMELINE_LOD_PIXELS > TIMELINE_BUCKET_MINUTES) {
+         int first = MAX((int)(timelineViewStart / TIMELINE_BUCKET_MINUTES), 0);
+         int last = MIN((int)(viewEnd / TIMELINE_BUCKET_MINUTES), TIMELINE_BUCKETS - 1);
+         for (int b = first; b <= last; b++) {
+             if (row->busy[b] == 0) continue;
+             double load = MIN(row->busy[b] / (double)TIMELINE_BUCKET_MINUTES, 1.0);
+             cairo_set_source_rgba(cr, 0.25, 0.50, 0.85, 0.25 + 0.75 * load);
+             double x = timelineX(b * TIMELINE_BUCKET_MINUTES);
+             cairo_rectangle(cr, x, top, MAX(TIMELINE_BUCKET_MINUTES / timelineMinutesPerPixel, 1.0), height);
+             cairo_fill(cr);
+         }
+         return;
+     }
+ 
+     const TimelineInterval *intervals = (const TimelineInterval *)row->intervals->data;
+     int lo = 0, hi = row->intervals->len;
+     double reach = timelineViewStart - row->maxLength;
+     while (lo < hi) {
+         int mid = (lo + hi) / 2;
+         if (intervals[mid].start < reach) lo = mid + 1;
+         else hi = mid;
+     }
+ 
+     for (int i = lo; i < (int)row->intervals->len && intervals[i].start <= viewEnd; i++) {
+         const TimelineInterval *interval = &intervals[i];
+         if (interval->end < timelineViewStart || interval->flight >= flightCount) continue;
+ 
+         const Flight *f = &flights[interval->flight];
+         double x = timelineX(interval->start);
+         double width = MAX((interval->end - interval->start) / timelineMinutesPerPixel, 1.0);
+         setFlightColor(cr, f);
+         cairo_rectangle(cr, x, top, width, height);
+         cairo_fill(cr);
+ 
+         if (width > TIMELINE_LABEL_MIN_WIDTH) {
+             cairo_set_source_rgb(cr, 1, 1, 1);
+             cairo_move_to(cr, MAX(x, TIMELINE_LABEL_WIDTH) + 3, top + height - 4);
+             cairo_show_text(cr, f->flightID);
+         }
+     }
+ }
+ 
+ gboolean on_timeline_draw(GtkWidget *widget, cairo_t *cr, gpointer data) {
+     SCOPED_TIMER(METRIC_TIMELINE_DRAW);
+     TRACE_SCOPE(__func__, "ui");
+     if (timelineStale) rebuildTimeline();
+ 
+     double width = gtk_widget_get_allocated_width(widget);
+     double clipX1, clipY1, clipX2, clipY2;
+     cairo_clip_extents(cr, &clipX1, &clipY1, &clipX2, &clipY2);
+     double viewEnd = timelineViewStart + (width - TIMELINE_LABEL_WIDTH) * timelineMinutesPerPixel;
+ 
+     cairo_set_source_rgb(cr, 1, 1, 1);
+     cairo_paint(cr);
+     cairo_set_font_size(cr, 11);
+ 
+     int firstRow = MAX((int)((clipY1 - TIMELINE_HEADER_HEIGHT) / TIMELINE_ROW_HEIGHT), 0);
+     int lastRow = MIN((int)((clipY2 - TIMELINE_HEADER_HEIGHT) / TIMELINE_ROW_HEIGHT), timelineRowCount - 1);
+ 
+     cairo_save(cr);
+     cairo_rectangle(cr, TIMELINE_LABEL_WIDTH, clipY1, width - TIMELINE_LABEL_WIDTH, clipY2 - clipY1);
+     cairo_clip(cr);
+     for (int r = firstRow; r <= lastRow; r++) {
+         double y = TIMELINE_HEADER_HEIGHT + r * TIMELINE_ROW_HEIGHT;
+         if (r % 2) {
+             cairo_set_source_rgb(cr, 0.96, 0.96, 0.96);
+             cairo_rectangle(cr, TIMELINE_LABEL_WIDTH, y, width - TIMELINE_LABEL_WIDTH, TIMELINE_ROW_HEIGHT);
+             cairo_fill(cr);
+         }
+         drawTimelineRow(cr, &timelineRows[r], y, viewEnd);
+     }
+ 
+     // Hour grid; switches to 15-minute ticks when there is room for them.
+     int step = 60 / timelineMinutesPerPixel > 240 ? 15 : 60;
+     while (step / timelineMinutesPerPixel < 40) step *= 2;
+     cairo_set_line_width(cr, 1);
+     for (int minute = ((int)timelineViewStart / step) * step; minute <= viewEnd; minute += step) {
+         double x = (int)timelineX(minute) + 0.5;
+         cairo_set_source_rgba(cr, 0, 0, 0, 0.15);
+         cairo_move_to(cr, x, clipY1);
+         cairo_line_to(cr, x, clipY2);
+         cairo_stroke(cr);
+ 
+         char label[8];
+         snprintf(label, sizeof(label), "%02d:%02d", (minute / 60) % 24, minute % 60);
+         cairo_set_source_rgb(cr, 0.2, 0.2, 0.2);
+         cairo_move_to(cr, x + 2, 14);
+         cairo_show_text(cr, label);
+     }
+     cairo_restore(cr);
+ 
+     cairo_set_source_rgb(cr, 0.92, 0.92, 0.92);
+     cairo_rectangle(cr, 0, clipY1, TIMELINE_LABEL_WIDTH, clipY2 - clipY1);
+     cairo_fill(cr);
+     cairo_set_source_rgb(cr, 0, 0, 0);
+     for (int r = firstRow; r <= lastRow; r++) {
+         char label[STR_LEN + 16];
+         if (r < timelineRunwayRows) snprintf(label, sizeof(label), "Runway %d", runways[r].id);
+         else snprintf(label, sizeof(label), "%s", crews[r - timelineRunwayRows].name);
+         cairo_move_to(cr, 6, TIMELINE_HEADER_HEIGHT + r * TIMELINE_ROW_HEIGHT + TIMELINE_ROW_HEIGHT - 7);
+         cairo_show_text(cr, label);
+     }
+     return TRUE;
+ }
+ 
+ static void clampTimelineView(double width) {
+     double visible = MAX(width - TIMELINE_LABEL_WIDTH, 1);
+     timelineMinutesPerPixel = CLAMP(timelineMinutesPerPixel, TIMELINE_MIN_MINUTES_PER_PIXEL,
+                                     TIMELINE_SPAN_MINUTES / visible);
+     timelineViewStart = CLAMP(timelineViewStart, 0, TIMELINE_SPAN_MINUTES - visible * timelineMinutesPerPixel);
+ }
+ 
+ // Ctrl+wheel zooms around the pointer and Shift+wheel pans; a plain wheel is
+ // left to the scrolled window so the rows still scroll vertically.
+ gboolean on_timeline_scroll(GtkWidget *widget, GdkEventScroll *event, gpointer data) {
+     TRACE_SCOPE(__func__, "ui");
+     double delta = 0;
+     if (event->direction == GDK_SCROLL_UP) delta = -1;
+     else if (event->direction == GDK_SCROLL_DOWN) delta = 1;
+     else if (event->direction == GDK_SCROLL_SMOOTH) delta = event->delta_y;
+     if (delta == 0) return FALSE;
+ 
+     double width = gtk_widget_get_allocated_width(widget);
+     if (event->state & GDK_CONTROL_MASK) {
+         double anchor = timelineViewStart + (event->x - TIMELINE_LABEL_WIDTH) * timelineMinutesPerPixel;
+         timelineMinutesPerPixel *= delta > 0 ? 1 + 0.2 * MIN(delta, 1.0) : 1 / (1 - 0.2 * MAX(delta, -1.0));
+         clampTimelineView(width);
+         timelineViewStart = anchor - (event->x - TIMELINE_LABEL_WIDTH) * timelineMinutesPerPixel;
+     } else if (event->state & GDK_SHIFT_MASK) {
+         timelineViewStart += delta * 60 * timelineMinutesPerPixel;
+     } else {
+         return FALSE;
+     }
+     clampTimelineView(width);
+     gtk_widget_queue_draw(widget);
+     return TRUE;
+ }
+ 
+ gboolean on_timeline_button_press(GtkWidget *widget, GdkEventButton *event, gpointer data) {
+     timelineDragX = event->x;
+     timelineDragStart = timelineViewStart;
+     return TRUE;
+ }
+ 
+ gboolean on_timeline_motion(GtkWidget *widget, GdkEventMotion *event, gpointer data) {
+     if (!(event->state & GDK_BUTTON1_MASK)) return FALSE;
+     timelineViewStart = timelineDragStart - (event->x - timelineDragX) * timelineMinutesPerPixel;
+     clampTimelineView(gtk_widget_get_allocated_width(widget));
+     gtk_widget_queue_draw(widget);
+     return TRUE;
+ }
+ 
+ void update_timeline() {
+     TRACE_SCOPE(__func__, "ui");
+     timelineStale = true;
+     if (timeline_area) {
+         gtk_widget_set_size_request(timeline_area, -1,
+                                     TIMELINE_HEADER_HEIGHT + (runwayCount + crewCount) * TIMELINE_ROW_HEIGHT);
+         gtk_widget_queue_draw(timeline_area);
+     }
+ }
+ 
+ void create_timeline() {
+     timeline_grid = gtk_grid_new();
+     gtk_grid_set_row_spacing(GTK_GRID(timeline_grid), 10);
+     gtk_grid_set_column_spacing(GTK_GRID(timeline_grid), 10);
+     gtk_container_set_border_width(GTK_CONTAINER(timeline_grid), 10);
+ 
+     GtkWidget *header = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+     gtk_widget_set_hexpand(header, TRUE);
+ 
+     GtkWidget *title = gtk_label_new("Runway & Crew Timeline");
+     gtk_box_pack_start(GTK_BOX(header), title, FALSE, FALSE, 0);
+ 
+     GtkWidget *back_button = gtk_button_new_with_label("Back");
+     g_signal_connect(back_button, "clicked", G_CALLBACK(on_back_clicked), NULL);
+     gtk_box_pack_end(GTK_BOX(header), back_button, FALSE, FALSE, 0);
+ 
+     GtkWidget *hint = gtk_label_new("Drag or Shift+scroll to pan, Ctrl+scroll to zoom");
+     gtk_box_pack_end(GTK_BOX(header), hint, FALSE, FALSE, 10);
+ 
+     gtk_grid_attach(GTK_GRID(timeline_grid), header, 0, 0, 1, 1);
+ 
+     GtkWidget *scrolled_window = gtk_scrolled_window_new(NULL, NULL);
+     gtk_widget_set_hexpand(scrolled_window, TRUE);
+     gtk_widget_set_vexpand(scrolled_window, TRUE);
+     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled_window),
+                                   GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+ 
+     timeline_area = gtk_drawing_area_new();
+     gtk_widget_add_events(timeline_area, GDK_SCROLL_MASK | GDK_SMOOTH_SCROLL_MASK |
+                                          GDK_BUTTON_PRESS_MASK | GDK_BUTTON_MOTION_MASK);
+     g_signal_connect(timeline_area, "draw", G_CALLBACK(on_timeline_draw), NULL);
+     g_signal_connect(timeline_area, "scroll-event", G_CALLBACK(on_timeline_scroll), NULL);
+     g_signal_connect(timeline_area, "button-press-event", G_CALLBACK(on_timeline_button_press), NULL);
+     g_signal_connect(timeline_area, "motion-notify-event", G_CALLBACK(on_timeline_motion), NULL);
+     gtk_container_add(GTK_CONTAINER(scrolled_window), timeline_area);
+     gtk_grid_attach(GTK_GRID(timeline_grid), scrolled_window, 0, 1, 1, 1);
+ 
+     gtk_stack_add_named(GTK_STACK(stack), timeline_grid, "timeline");
+     update_timeline();
+ }
+ 
  void create_logout_screen() {
      logout_grid = gtk_grid_new();
      gtk_grid_set_row_spacing(GTK_GRID(logout_grid), 10);
@@ -2087,13 +8498,808 @@ gtk_grid_attach(GTK_GRID(realtime_events_grid), reschedule_button, 0, 4, 1, 1);
  
 
  
+ // Benchmark mode (--benchmark). Generates synthetic schedules from a seed and
+ // times the planning and persistence paths across a range of sizes, writing
+ // one JSON row per run. Departures cluster in hub banks around 07:00, 12:00,
+ // 17:00 and 21:00 over a uniform background, and aircraft types follow a
+ // weighted fleet mix. With a baseline file the results are compared run by run
+ // and the process exits non-zero on regression.
+ typedef struct {
+     const char *type;
+     int weight;
+     int minMinutes;
+     int maxMinutes;
+ } BenchAircraft;
+ 
+ static const BenchAircraft benchFleet[] = {
+     {"AirbusA320", 30, 60, 240}, {"Boeing737", 28, 60, 240}, {"Embraer190", 12, 45, 120},
+     {"Boeing787", 9, 300, 720}, {"AirbusA350", 8, 300, 720}, {"Boeing777", 7, 300, 780},
+     {"AirbusA380", 3, 420, 840}, {"Boeing747", 3, 420, 780}
+ };
+ 
+ static const char *const benchAirports[] = {
+     "DEL", "BOM", "BLR", "MAA", "CCU", "HYD", "DXB", "LHR", "SIN", "FRA", "JFK", "HKG"
+ };
+ 
+ static int benchBankMinute(GRand *rng) {
+     static const int banks[] = {7 * 60, 12 * 60, 17 * 60, 21 * 60};
+     if (g_rand_int_range(rng, 0, 100) >= 70) {
+         return g_rand_int_range(rng, 5 * 60, MINUTES_PER_DAY);
+     }
+     // Sum of three uniforms: a bell of roughly +/- 90 minutes around the bank.
+     int offset = g_rand_int_range(rng, -30, 31) + g_rand_int_range(rng, -30, 31) + g_rand_int_range(rng, -30, 31);
+     int minute = banks[g_rand_int_range(rng, 0, G_N_ELEMENTS(banks))] + offset;
+     return CLAMP(minute, 0, MINUTES_PER_DAY - 1);
+ }
+ 
+ static const BenchAircraft* benchPickAircraft(GRand *rng) {
+     int total = 0;
+     for (size_t i = 0; i < G_N_ELEMENTS(benchFleet); i++) total += benchFleet[i].weight;
+     int pick = g_rand_int_range(rng, 0, total);
+     for (size_t i = 0; i < G_N_ELEMENTS(benchFleet); i++) {
+         pick -= benchFleet[i].weight;
+         if (pick < 0) return &benchFleet[i];
+     }
+     return &benchFleet[0];
+ }
+ 
+ void generateSyntheticFlights(GRand *rng, Flight *flightSet, int n) {
+     for (int i = 0; i < n; i++) {
+         Flight *f = &flightSet[i];
+         const BenchAircraft *aircraft = benchPickAircraft(rng);
+         memset(f, 0, sizeof(Flight));
+ 
+         snprintf(f->flightID, STR_LEN, "SY%06d", i);
+         int origin = g_rand_int_range(rng, 0, G_N_ELEMENTS(benchAirports));
+         int destination = (origin + g_rand_int_range(rng, 1, G_N_ELEMENTS(benchAirports))) % G_N_ELEMENTS(benchAirports);
+         strcpy(f->origin, benchAirports[origin]);
+         strcpy(f->destination, benchAirports[destination]);
+         strcpy(f->aircraftType, aircraft->type);
+ 
+         int departure = benchBankMinute(rng);
+         f->departureTime.hour = departure / 60;
+         f->departureTime.minute = departure % 60;
+         f->arrivalTime = addMinutesToTime(f->departureTime,
+                                           g_rand_int_range(rng, aircraft->minMinutes, aircraft->maxMinutes + 1));
+         f->scheduledDeparture = f->departureTime;
+ 
+         int roll = g_rand_int_range(rng, 0, 1000);
+         f->priority = roll < 2 ? EMERGENCY : roll < 400 ? INTERNATIONAL : DOMESTIC;
+         f->isCargo = g_rand_int_range(rng, 0, 100) < 8;
+         f->status = SCHEDULED;
+         f->runwayAssigned = -1;
+         f->crewAssigned = -1;
+     }
+ }
+ 
+ void generateSyntheticCrew(GRand *rng, Crew *crewSet, int n) {
+     for (int i = 0; i < n; i++) {
+         Crew *c = &crewSet[i];
+         memset(c, 0, sizeof(Crew));
+         c->id = i;
+         snprintf(c->name, STR_LEN, "%s %05d", i % 2 ? "F/O" : "Capt.", i);
+         c->isAvailable = true;
+         snprintf(c->qualifications, STR_LEN, "%s,%s",
+                  benchPickAircraft(rng)->type, benchPickAircraft(rng)->type);
+     }
+ }
+ 
+ typedef struct {
+     int flights;
+     int runways;
+     int crew;
+     Flight *generatedFlights;
+     Runway *generatedRunways;
+     Crew *generatedCrew;
+     Flight *flightSet;
+     Runway *runwaySet;
+     Crew *crewSet;
+ } BenchCase;
+ 
+ static void benchReset(BenchCase *bench) {
+     memcpy(bench->flightSet, bench->generatedFlights, sizeof(Flight) * bench->flights);
+     memcpy(bench->runwaySet, bench->generatedRunways, sizeof(Runway) * bench->runways);
+     memcpy(bench->crewSet, bench->generatedCrew, sizeof(Crew) * bench->crew);
+ }
+ 
+ static void benchCaseInit(BenchCase *bench, guint32 seed, int nFlights, int nCrew) {
+     GRand *rng = g_rand_new_with_seed(seed);
+     bench->flights = nFlights;
+     bench->runways = CLAMP(nFlights / 200, 3, 64);
+     bench->crew = nCrew;
+     bench->generatedFlights = g_new(Flight, nFlights);
+     bench->generatedRunways = g_new(Runway, bench->runways);
+     bench->generatedCrew = g_new(Crew, nCrew);
+     bench->flightSet = g_new(Flight, nFlights);
+     bench->runwaySet = g_new(Runway, bench->runways);
+     bench->crewSet = g_new(Crew, nCrew);
+     generateSyntheticFlights(rng, bench->generatedFlights, nFlights);
+     initializeRunways(bench->generatedRunways, bench->runways);
+     generateSyntheticCrew(rng, bench->generatedCrew, nCrew);
+     g_rand_free(rng);
+ }
+ 
+ static void benchCaseFree(BenchCase *bench) {
+     g_free(bench->generatedFlights);
+     g_free(bench->generatedRunways);
+     g_free(bench->generatedCrew);
+     g_free(bench->flightSet);
+     g_free(bench->runwaySet);
+     g_free(bench->crewSet);
+ }
+ 
+ // Returns the fastest of a few runs in microseconds; large cases run once.
+ static gint64 benchRun(BenchCase *bench, const char *routine) {
+     int repeats = bench->flights <= 10000 && bench->crew <= 1000 ? 5 : 1;
+     gint64 best = G_MAXINT64;
+ 
+     for (int r = 0; r < repeats; r++) {
+         benchReset(bench);
+         gint64 started = g_get_monotonic_time();
+         if (strcmp(routine, "assign_runways") == 0) {
+             assignRunwaysFor(bench->flightSet, bench->flights, bench->runwaySet, bench->runways);
+         } else if (strcmp(routine, "schedule_crew") == 0) {
+             scheduleCrewFor(bench->flightSet, bench->flights, bench->crewSet, bench->crew);
+         } else if (strcmp(routine, "reschedule") == 0) {
+             rescheduleFlightsFor(bench->flightSet, bench->flights, bench->runwaySet, bench->runways,
+                                  bench->crewSet, bench->crew);
+         } else if (strcmp(routine, "save") == 0) {
+             saveRecordFile(BENCHMARK_SCRATCH_FILE, bench->flightSet, sizeof(Flight), bench->flights);
+         } else if (strcmp(routine, "load") == 0) {
+             loadRecordFile(BENCHMARK_SCRATCH_FILE, bench->flightSet, sizeof(Flight), bench->flights);
+         }
+         best = MIN(best, g_get_monotonic_time() - started);
+     }
+     return best;
+ }
+ 
+ typedef struct {
+     char routine[32];
+     int flights;
+     int crew;
+     gint64 microseconds;
+ } BenchResult;
+ 
+ static int loadBenchBaseline(const char *path, BenchResult *results, int maxResults) {
+     FILE *file = fopen(path, "r");
+     if (!file) return -1;
+ 
+     char line[512];
+     int count = 0;
+     while (count < maxResults && fgets(line, sizeof(line), file)) {
+         BenchResult *r = &results[count];
+         long long microseconds;
+         int runways;
+         if (sscanf(line, "{\"benchmark\":\"%31[^\"]\",\"flights\":%d,\"runways\":%d,\"crew\":%d,\"microseconds\":%lld",
+                    r->routine, &r->flights, &runways, &r->crew, &microseconds) == 5) {
+             r->microseconds = microseconds;
+             count++;
+         }
+     }
+     fclose(file);
+     return count;
+ }
+ 
+ int runBenchmarks(const BenchOptions *options) {
+     static const char *const columns[] = {"benchmark", "flights", "runways", "crew", "microseconds", "per_second"};
+     static const int flightSizes[] = {1000, 10000, 100000, 1000000};
+     static const int crewSizes[] = {10, 100, 1000, 10000};
+     static const char *const flightRoutines[] = {"assign_runways", "schedule_crew", "reschedule", "save", "load"};
+ 
+     BenchResult *results = g_new0(BenchResult, 64);
+     int resultCount = 0;
+ 
+     ReportWriter *out = g_new0(ReportWriter, 1);
+     out->format = REPORT_JSON;
+     out->file = fopen(options->outputPath, "w");
+     if (!out->file) {
+         fprintf(stderr, "Cannot open %s: %s\n", options->outputPath, g_strerror(errno));
+         g_free(out);
+         g_free(results);
+         return 1;
+     }
+     reportBeginDocument(out, "benchmark", "BENCHMARK");
+     reportSummaryInt(out, "seed", "Seed", options->seed);
+     reportSummaryInt(out, "budget_seconds", "Budget (s)", options->budgetSeconds);
+     reportEndSummary(out);
+     reportBeginTable(out, columns, G_N_ELEMENTS(columns));
+ 
+     // Flight-count curves, with crew scaled alongside, then a crew-count
+     // curve for the crew planner at a fixed 10k flights.
+     for (size_t routine = 0; routine <= G_N_ELEMENTS(flightRoutines); routine++) {
+         bool crewCurve = routine == G_N_ELEMENTS(flightRoutines);
+         const char *name = crewCurve ? "schedule_crew" : flightRoutines[routine];
+         size_t steps = crewCurve ? G_N_ELEMENTS(crewSizes) : G_N_ELEMENTS(flightSizes);
+ 
+         for (size_t step = 0; step < steps; step++) {
+             int nFlights = crewCurve ? 10000 : flightSizes[step];
+             int nCrew = crewCurve ? crewSizes[step] : CLAMP(nFlights / 100, 10, 10000);
+             if (nFlights > options->maxFlights) break;
+ 
+             BenchCase bench;
+             benchCaseInit(&bench, options->seed, nFlights, nCrew);
+             if (strcmp(name, "load") == 0) {
+                 saveRecordFile(BENCHMARK_SCRATCH_FILE, bench.generatedFlights, sizeof(Flight), nFlights);
+             }
+             gint64 microseconds = benchRun(&bench, name);
+             benchCaseFree(&bench);
+ 
+             BenchResult *r = &results[resultCount++];
+             strncpy(r->routine, name, sizeof(r->routine) - 1);
+             r->flights = nFlights;
+             r->crew = nCrew;
+             r->microseconds = microseconds;
+ 
+             reportBeginRow(out);
+             reportFieldText(out, name);
+             reportFieldInt(out, nFlights);
+             reportFieldInt(out, CLAMP(nFlights / 200, 3, 64));
+             reportFieldInt(out, nCrew);
+             reportFieldInt(out, microseconds);
+             reportFieldInt(out, microseconds > 0 ? (long)(nFlights * (gint64)G_USEC_PER_SEC / microseconds) : 0);
+             reportEndRow(out);
+ 
+             printf("%-15s flights=%-8d crew=%-6d %10.3f ms\n", name, nFlights, nCrew, microseconds / 1000.0);
+             fflush(stdout);
+             if (microseconds > options->budgetSeconds * G_USEC_PER_SEC) break;
+         }
+     }
+     remove(BENCHMARK_SCRATCH_FILE);
+ 
+     reportEndTable(out);
+     reportEndDocument(out);
+     reportFlush(out);
+     fclose(out->file);
+     g_free(out);
+     printf("Results written to %s\n", options->outputPath);
+ 
+     int regressions = 0;
+     if (options->baselinePath) {
+         BenchResult *baseline = g_new0(BenchResult, 64);
+         int baselineCount = loadBenchBaseline(options->baselinePath, baseline, 64);
+         if (baselineCount < 0) {
+             fprintf(stderr, "Cannot read baseline %s\n", options->baselinePath);
+             regressions = 1;
+         }
+         for (int i = 0; i < resultCount; i++) {
+             for (int b = 0; b < baselineCount; b++) {
+                 if (strcmp(results[i].routine, baseline[b].routine) != 0 ||
+                     results[i].flights != baseline[b].flights || results[i].crew != baseline[b].crew) {
+                     continue;
+                 }
+                 // Runs under a millisecond are too noisy to gate on.
+                 double limit = baseline[b].microseconds * (1 + options->tolerancePercent / 100.0);
+                 if (results[i].microseconds > 1000 && results[i].microseconds > limit) {
+                     printf("REGRESSION %s flights=%d crew=%d: %.3f ms vs baseline %.3f ms\n",
+                            results[i].routine, results[i].flights, results[i].crew,
+                            results[i].microseconds / 1000.0, baseline[b].microseconds / 1000.0);
+                     regressions++;
+                 }
+             }
+         }
+         if (baselineCount >= 0) {
+             printf("%d regression(s) against %s (tolerance %d%%)\n", regressions,
+                    options->baselinePath, options->tolerancePercent);
+         }
+         g_free(baseline);
+     }
+ 
+     g_free(results);
+     return regressions > 0 ? 1 : 0;
+ }
+ 
+ // Differential planner oracle (--oracle). Small random schedules are planned
+ // by the reference engine and by a candidate engine. The candidate fails a
+ // case if its plan breaks a runway or crew rule, or if it leaves more flights
+ // unplanned (or more delay) than the reference. Cases are seeded by index and
+ // spread over worker threads; the lowest failing case is shrunk and printed.
+ static const PlannerEngine plannerEngines[] = {
+     {"reference", assignRunwaysFor, scheduleCrewFor},
+     {"indexed", assignRunwaysIndexed, scheduleCrewIndexed}
+ };
+ 
+ typedef struct {
+     int flights;
+     int runways;
+     int crew;
+     Flight flightSet[ORACLE_MAX_FLIGHTS];
+     Runway runwaySet[ORACLE_MAX_RUNWAYS];
+     Crew crewSet[ORACLE_MAX_CREW];
+ } OracleCase;
+ 
+ typedef struct {
+     int unplanned;
+     int delayMinutes;
+ } OracleObjective;
+ 
+ static guint32 oracleCaseSeed(guint32 seed, int index) {
+     return seed ^ ((guint32)index * 2654435761u);
+ }
+ 
+ static Time oracleRandomTime(GRand *rng, int from, int span) {
+     int minute = (from + g_rand_int_range(rng, 0, span)) % MINUTES_PER_DAY;
+     Time t = {minute / 60, minute % 60};
+     return t;
+ }
+ 
+ static void generateOracleCase(GRand *rng, OracleCase *c) {
+     c->flights = g_rand_int_range(rng, 1, ORACLE_MAX_FLIGHTS + 1);
+     c->runways = g_rand_int_range(rng, 1, ORACLE_MAX_RUNWAYS + 1);
+     c->crew = g_rand_int_range(rng, 1, ORACLE_MAX_CREW + 1);
+ 
+     // Departures are squeezed into a short window (which may cross midnight)
+     // so flights compete for runways and crew.
+     int windowStart = g_rand_int_range(rng, 0, MINUTES_PER_DAY);
+     int window = g_rand_int_range(rng, 30, 8 * 60);
+ 
+     generateSyntheticFlights(rng, c->flightSet, c->flights);
+     for (int i = 0; i < c->flights; i++) {
+         Flight *f = &c->flightSet[i];
+         int duration = calculateTimeDifferenceInMinutes(f->departureTime, f->arrivalTime);
+         f->departureTime = oracleRandomTime(rng, windowStart, window);
+         f->arrivalTime = addMinutesToTime(f->departureTime, duration);
+         if (g_rand_int_range(rng, 0, 100) < 5) f->status = CANCELLED;
+     }
+ 
+     for (int r = 0; r < c->runways; r++) {
+         Runway *runway = &c->runwaySet[r];
+         runway->id = r;
+         runway->type = (RunwayType)g_rand_int_range(rng, ALL_FLIGHTS, CARGO_ONLY + 1);
+         runway->isAvailable = g_rand_int_range(rng, 0, 100) < 85;
+         runway->nextAvailableTime = oracleRandomTime(rng, windowStart, window);
+     }
+ 
+     generateSyntheticCrew(rng, c->crewSet, c->crew);
+     for (int i = 0; i < c->crew; i++) {
+         Crew *crew = &c->crewSet[i];
+         crew->isAvailable = g_rand_int_range(rng, 0, 100) < 85;
+         crew->dutyMinutesToday = g_rand_int_range(rng, 0, config.maxDutyTime + 60);
+         crew->lastFlightEnd = oracleRandomTime(rng, windowStart + MINUTES_PER_DAY - config.minRestTime, window);
+     }
+ }
+ 
+ static void runPlannerEngine(const PlannerEngine *engine, OracleCase *c) {
+     engine->assignRunways(c->flightSet, c->flights, c->runwaySet, c->runways);
+     engine->scheduleCrew(c->flightSet, c->flights, c->crewSet, c->crew);
+ }
+ 
+ // Collects the flights on one runway (or crew member) in departure order.
+ static int oracleFlightsOn(const OracleCase *plan, int index, bool runway, int *order) {
+     int n = 0;
+     for (int i = 0; i < plan->flights; i++) {
+         int assigned = runway ? plan->flightSet[i].runwayAssigned : plan->flightSet[i].crewAssigned;
+         if (assigned != index) continue;
+         int k = n++;
+         while (k > 0 && compareTime(plan->flightSet[order[k - 1]].departureTime, plan->flightSet[i].departureTime) > 0) {
+             order[k] = order[k - 1];
+             k--;
+         }
+         order[k] = i;
+     }
+     return n;
+ }
+ 
+ static bool runwayAccepts(const Runway *runway, const Flight *flight) {
+     switch (runway->type) {
+         case ALL_FLIGHTS: return true;
+         case INTERNATIONAL_ONLY: return flight->priority == INTERNATIONAL;
+         case CARGO_ONLY: return flight->isCargo;
+     }
+     return false;
+ }
+ 
+ // Checks a plan against the runway and crew rules, given the case it was
+ // planned from, and describes the first violation.
+ static bool oracleCheckRules(const OracleCase *input, const OracleCase *plan, char *why, size_t size) {
+     int order[ORACLE_MAX_FLIGHTS];
+ 
+     for (int i = 0; i < plan->flights; i++) {
+         const Flight *f = &plan->flightSet[i];
+         if (f->runwayAssigned < -1 || f->runwayAssigned >= plan->runways ||
+             f->crewAssigned < -1 || f->crewAssigned >= plan->crew) {
+             snprintf(why, size, "flight %s has an out-of-range assignment", f->flightID);
+             return false;
+         }
+         if (input->flightSet[i].status == CANCELLED && (f->runwayAssigned != -1 || f->crewAssigned != -1)) {
+             snprintf(why, size, "cancelled flight %s was planned", f->flightID);
+             return false;
+         }
+     }
+ 
+     for (int r = 0; r < input->runways; r++) {
+         const Runway *runway = &input->runwaySet[r];
+         int n = oracleFlightsOn(plan, r, true, order);
+         if (n > 0 && !runway->isAvailable) {
+             snprintf(why, size, "closed runway %d took flight %s", r, plan->flightSet[order[0]].flightID);
+             return false;
+         }
+         Time freeAt = runway->nextAvailableTime;
+         for (int k = 0; k < n; k++) {
+             const Flight *f = &plan->flightSet[order[k]];
+             if (!runwayAccepts(runway, f)) {
+                 snprintf(why, size, "flight %s is not allowed on %s runway %d",
+                          f->flightID, runwayTypeName(runway->type), r);
+                 return false;
+             }
+             if (compareTime(f->departureTime, freeAt) < 0) {
+                 snprintf(why, size, "flight %s departs %02d:%02d before runway %d is free at %02d:%02d (buffer_time)",
+                          f->flightID, f->departureTime.hour, f->departureTime.minute, r, freeAt.hour, freeAt.minute);
+                 return false;
+             }
+             freeAt = addMinutesToTime(f->arrivalTime, config.bufferTime);
+         }
+     }
+ 
+     for (int c = 0; c < input->crew; c++) {
+         const Crew *crew = &input->crewSet[c];
+         int n = oracleFlightsOn(plan, c, false, order);
+         if (n > 0 && !crew->isAvailable) {
+             snprintf(why, size, "unavailable crew %d took flight %s", c, plan->flightSet[order[0]].flightID);
+             return false;
+         }
+         int duty = crew->dutyMinutesToday;
+         Time lastEnd = crew->lastFlightEnd;
+         for (int k = 0; k < n; k++) {
+             const Flight *f = &plan->flightSet[order[k]];
+             if (duty >= config.maxDutyTime) {
+                 snprintf(why, size, "crew %d took flight %s after %d duty minutes (max_duty_time)", c, f->flightID, duty);
+                 return false;
+             }
+             Time earliestStart = addMinutesToTime(lastEnd, config.minRestTime);
+             if (compareTime(f->departureTime, earliestStart) < 0) {
+                 snprintf(why, size, "crew %d took flight %s at %02d:%02d before resting until %02d:%02d (min_rest_time)",
+                          c, f->flightID, f->departureTime.hour, f->departureTime.minute,
+                          earliestStart.hour, earliestStart.minute);
+                 return false;
+             }
+             lastEnd = f->arrivalTime;
+             duty += calculateTimeDifferenceInMinutes(f->departureTime, f->arrivalTime);
+         }
+     }
+     return true;
+ }
+ 
+ static OracleObjective oracleObjective(const OracleCase *plan) {
+     OracleObjective objective = {0, 0};
+     for (int i = 0; i < plan->flights; i++) {
+         const Flight *f = &plan->flightSet[i];
+         if (f->status == CANCELLED) continue;
+         objective.unplanned += (f->runwayAssigned == -1) + (f->crewAssigned == -1);
+         objective.delayMinutes += f->delayMinutes;
+     }
+     return objective;
+ }
+ 
+ // Plans one case with the reference and the candidate engine. Returns false,
+ // with a reason, when the candidate (or the reference itself) breaks a rule
+ // or the candidate's plan is worse than the reference plan.
+ static bool oracleRunCase(const OracleCase *input, const PlannerEngine *engine, char *why, size_t size) {
+     ARENA_PASS(arena);
+     OracleCase *reference = arenaAlloc(arena, sizeof(OracleCase));
+     OracleCase *candidate = arenaAlloc(arena, sizeof(OracleCase));
+     char detail[192];
+     bool ok = true;
+ 
+     *reference = *input;
+     *candidate = *input;
+     runPlannerEngine(&plannerEngines[0], reference);
+     runPlannerEngine(engine, candidate);
+ 
+     if (!oracleCheckRules(input, reference, detail, sizeof(detail))) {
+         snprintf(why, size, "%s: %s", plannerEngines[0].name, detail);
+         ok = false;
+     } else if (!oracleCheckRules(input, candidate, detail, sizeof(detail))) {
+         snprintf(why, size, "%s: %s", engine->name, detail);
+         ok = false;
+     } else {
+         OracleObjective expected = oracleObjective(reference);
+         OracleObjective actual = oracleObjective(candidate);
+         if (actual.unplanned > expected.unplanned ||
+             (actual.unplanned == expected.unplanned && actual.delayMinutes > expected.delayMinutes)) {
+             snprintf(why, size, "%s: %d unplanned, %d delay minutes; %s: %d unplanned, %d delay minutes",
+                      engine->name, actual.unplanned, actual.delayMinutes,
+                      plannerEngines[0].name, expected.unplanned, expected.delayMinutes);
+             ok = false;
+         }
+     }
+     return ok;
+ }
+ 
+ static int* oracleCount(OracleCase *c, int kind) {
+     return kind == 0 ? &c->flights : kind == 1 ? &c->runways : &c->crew;
+ }
+ 
+ static void oracleRemove(OracleCase *c, int kind, int start, int count) {
+     int *n = oracleCount(c, kind);
+     int tail = *n - start - count;
+     if (kind == 0) memmove(&c->flightSet[start], &c->flightSet[start + count], sizeof(Flight) * tail);
+     else if (kind == 1) memmove(&c->runwaySet[start], &c->runwaySet[start + count], sizeof(Runway) * tail);
+     else memmove(&c->crewSet[start], &c->crewSet[start + count], sizeof(Crew) * tail);
+     *n -= count;
+     for (int r = 0; r < c->runways; r++) c->runwaySet[r].id = r;
+     for (int i = 0; i < c->crew; i++) c->crewSet[i].id = i;
+ }
+ 
+ // Delta debugging: drop ever smaller runs of flights, runways and crew while
+ // the case keeps failing, until no single element can be removed.
+ static void shrinkOracleCase(OracleCase *c, const PlannerEngine *engine) {
+     OracleCase *trial = g_new(OracleCase, 1);
+     char why[256];
+     bool progress = true;
+ 
+     while (progress) {
+         progress = false;
+         for (int kind = 0; kind < 3; kind++) {
+             for (int chunk = MAX(*oracleCount(c, kind) / 2, 1); chunk >= 1; chunk /= 2) {
+                 int start = 0;
+                 while (start + chunk <= *oracleCount(c, kind)) {
+                     if (kind == 0 && *oracleCount(c, kind) == chunk) break;
+                     *trial = *c;
+                     oracleRemove(trial, kind, start, chunk);
+                     if (!oracleRunCase(trial, engine, why, sizeof(why))) {
+                         *c = *trial;
+                         progress = true;
+                     } else {
+                         start += chunk;
+                     }
+                 }
+             }
+         }
+     }
+     g_free(trial);
+ }
+ 
+ static void printOracleCase(const OracleCase *c, const PlannerEngine *engine) {
+     OracleCase *reference = g_new(OracleCase, 1);
+     OracleCase *candidate = g_new(OracleCase, 1);
+     *reference = *c;
+     *candidate = *c;
+     runPlannerEngine(&plannerEngines[0], reference);
+     runPlannerEngine(engine, candidate);
+ 
+     printf("  Runways:\n");
+     for (int r = 0; r < c->runways; r++) {
+         const Runway *runway = &c->runwaySet[r];
+         printf("    %d %-20s %-6s free %02d:%02d\n", r, runwayTypeName(runway->type),
+                runway->isAvailable ? "open" : "closed", runway->nextAvailableTime.hour, runway->nextAvailableTime.minute);
+     }
+     printf("  Crew:\n");
+     for (int i = 0; i < c->crew; i++) {
+         const Crew *crew = &c->crewSet[i];
+         printf("    %d %-11s duty %3d last %02d:%02d quals %s\n", i, crew->isAvailable ? "available" : "unavailable",
+                crew->dutyMinutesToday, crew->lastFlightEnd.hour, crew->lastFlightEnd.minute, crew->qualifications);
+     }
+     printf("  Flights (runway/crew: %s vs %s):\n", plannerEngines[0].name, engine->name);
+     for (int i = 0; i < c->flights; i++) {
+         const Flight *f = &c->flightSet[i];
+         printf("    %s %-11s %02d:%02d-%02d:%02d %-13s%s%s  %d/%d vs %d/%d\n", f->flightID, f->aircraftType,
+                f->departureTime.hour, f->departureTime.minute, f->arrivalTime.hour, f->arrivalTime.minute,
+                flightPriorityName(f->priority), f->isCargo ? " cargo" : "", f->status == CANCELLED ? " cancelled" : "",
+                reference->flightSet[i].runwayAssigned, reference->flightSet[i].crewAssigned,
+                candidate->flightSet[i].runwayAssigned, candidate->flightSet[i].crewAssigned);
+     }
+     g_free(reference);
+     g_free(candidate);
+ }
+ 
+ typedef struct {
+     const OracleOptions *options;
+     const PlannerEngine *engine;
+     gint64 deadline;
+     gint nextCase;
+     gint casesRun;
+     gint firstFailure;
+ } OracleRun;
+ 
+ static gpointer oracle_worker_thread(gpointer data) {
+     OracleRun *run = data;
+     OracleCase *input = g_new(OracleCase, 1);
+     GRand *rng = g_rand_new();
+     char why[256];
+     int ran = 0;
+     traceThreadName("oracle-worker");
+ 
+     while (true) {
+         int first = g_atomic_int_add(&run->nextCase, ORACLE_BATCH);
+         if (first >= run->options->cases || first >= g_atomic_int_get(&run->firstFailure)) break;
+         if (run->deadline && g_get_monotonic_time() > run->deadline) break;
+ 
+         int last = MIN(first + ORACLE_BATCH, run->options->cases);
+         for (int i = first; i < last; i++) {
+             g_rand_set_seed(rng, oracleCaseSeed(run->options->seed, i));
+             generateOracleCase(rng, input);
+             ran++;
+             if (!oracleRunCase(input, run->engine, why, sizeof(why))) {
+                 int current = g_atomic_int_get(&run->firstFailure);
+                 while (i < current && !g_atomic_int_compare_and_exchange(&run->firstFailure, current, i)) {
+                     current = g_atomic_int_get(&run->firstFailure);
+                 }
+                 break;
+             }
+         }
+     }
+ 
+     g_atomic_int_add(&run->casesRun, ran);
+     g_rand_free(rng);
+     g_free(input);
+     return NULL;
+ }
+ 
+ static bool runOracleEngine(const OracleOptions *options, const PlannerEngine *engine) {
+     OracleRun run = {options, engine, 0, 0, 0, G_MAXINT};
+     int threadCount = CLAMP(options->threads, 1, 256);
+     GThread **threads = g_new(GThread *, threadCount);
+     gint64 started = g_get_monotonic_time();
+     if (options->budgetSeconds > 0) run.deadline = started + (gint64)options->budgetSeconds * G_USEC_PER_SEC;
+ 
+     for (int t = 0; t < threadCount; t++) {
+         threads[t] = g_thread_new("oracle-worker", oracle_worker_thread, &run);
+     }
+     for (int t = 0; t < threadCount; t++) {
+         g_thread_join(threads[t]);
+     }
+     g_free(threads);
+     double seconds = (g_get_monotonic_time() - started) / 1e6;
+ 
+     if (run.firstFailure == G_MAXINT) {
+         printf("%s: %d cases agree with %s in %.1f s (%.0f cases/s)\n", engine->name, run.casesRun,
+                plannerEngines[0].name, seconds, seconds > 0 ? run.casesRun / seconds : 0.0);
+         return true;
+     }
+ 
+     OracleCase *failing = g_new(OracleCase, 1);
+     GRand *rng = g_rand_new_with_seed(oracleCaseSeed(options->seed, run.firstFailure));
+     generateOracleCase(rng, failing);
+     g_rand_free(rng);
+ 
+     int flights = failing->flights, runways = failing->runways, crew = failing->crew;
+     shrinkOracleCase(failing, engine);
+     char why[256];
+     oracleRunCase(failing, engine, why, sizeof(why));
+ 
+     printf("%s: FAILED case %d (seed %u) after %d cases\n", engine->name, run.firstFailure, options->seed, run.casesRun);
+     printf("  %s\n", why);
+     printf("  Shrunk from %d flights, %d runways, %d crew to %d, %d, %d:\n",
+            flights, runways, crew, failing->flights, failing->runways, failing->crew);
+     printOracleCase(failing, engine);
+     g_free(failing);
+     return false;
+ }
+ 
+ int runPlannerOracle(const OracleOptions *options) {
+     int failures = 0;
+     int engines = 0;
+ 
+     for (size_t e = 1; e < G_N_ELEMENTS(plannerEngines); e++) {
+         if (options->engineName && strcmp(options->engineName, plannerEngines[e].name) != 0) continue;
+         engines++;
+         if (!runOracleEngine(options, &plannerEngines[e])) failures++;
+     }
+     if (engines == 0) {
+         fprintf(stderr, "No planner engine named %s\n", options->engineName);
+         return 1;
+     }
+     return failures > 0 ? 1 : 0;
+ }
+ 
  int main(int argc, char *argv[]) {
-    gtk_init(&argc, &argv);
+    bool follower = false;
+    bool benchmark = false;
+    bool oracle = false;
+    const char *configPath = NULL;
+    ExportOptions exportOptions = {NULL, G_MININT, G_MAXINT};
+    BenchOptions bench = {42, FILENAME_BENCHMARK_RESULTS, NULL, 1000000, 10, 20};
+    OracleOptions oracleOptions = {1, 1000000, (int)g_get_num_processors(), 0, NULL};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--follower") == 0) {
+            follower = true;
+        } else if (strcmp(argv[i], "--viewer") == 0) {
+            viewerProcess = true;
+        } else if (strcmp(argv[i], "--notification-log") == 0) {
+            enableNotificationSpill(FILENAME_NOTIFICATION_LOG);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+#ifndef FMS_NO_TRACING
+            if (!startTracing(argv[++i])) return 1;
+            traceThreadName("main");
+#else
+            fprintf(stderr, "Tracing was disabled at build time; ignoring --trace\n");
+            i++;
+#endif
+        } else if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            configPath = argv[++i];
+        } else if (strcmp(argv[i], "--benchmark") == 0) {
+            benchmark = true;
+        } else if (strcmp(argv[i], "--bench-seed") == 0 && i + 1 < argc) {
+            bench.seed = (guint32)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--bench-output") == 0 && i + 1 < argc) {
+            bench.outputPath = argv[++i];
+        } else if (strcmp(argv[i], "--bench-baseline") == 0 && i + 1 < argc) {
+            bench.baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--bench-max-flights") == 0 && i + 1 < argc) {
+            bench.maxFlights = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-budget") == 0 && i + 1 < argc) {
+            bench.budgetSeconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-tolerance") == 0 && i + 1 < argc) {
+            bench.tolerancePercent = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--oracle") == 0) {
+            oracle = true;
+        } else if (strcmp(argv[i], "--oracle-seed") == 0 && i + 1 < argc) {
+            oracleOptions.seed = (guint32)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--oracle-cases") == 0 && i + 1 < argc) {
+            oracleOptions.cases = (int)CLAMP(strtol(argv[++i], NULL, 10), 1, G_MAXINT / 2);
+        } else if (strcmp(argv[i], "--oracle-threads") == 0 && i + 1 < argc) {
+            oracleOptions.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--oracle-seconds") == 0 && i + 1 < argc) {
+            oracleOptions.budgetSeconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--oracle-engine") == 0 && i + 1 < argc) {
+            oracleOptions.engineName = argv[++i];
+        } else if (strcmp(argv[i], "--export-history") == 0 && i + 1 < argc) {
+            exportOptions.path = argv[++i];
+        } else if ((strcmp(argv[i], "--export-from") == 0 || strcmp(argv[i], "--export-to") == 0) && i + 1 < argc) {
+            bool from = strcmp(argv[i], "--export-from") == 0;
+            struct tm date = {0};
+            if (sscanf(argv[++i], "%d-%d-%d", &date.tm_year, &date.tm_mon, &date.tm_mday) != 3) {
+                fprintf(stderr, "Export dates must be YYYY-MM-DD\n");
+                return 1;
+            }
+            date.tm_year -= 1900;
+            date.tm_mon -= 1;
+            int day = (int)(timegm(&date) / 86400);
+            if (from) exportOptions.fromDay = day;
+            else exportOptions.toDay = day;
+        }
+    }
+
+    if (!loadConfig(configPath ? configPath : FILENAME_CONFIG, configPath != NULL)) {
+        return 1;
+    }
+    allocateScheduleStorage();
+
+    if (benchmark) {
+        int status = runBenchmarks(&bench);
+#ifndef FMS_NO_TRACING
+        stopTracing();
+#endif
+        return status;
+    }
+    if (oracle) {
+        int status = runPlannerOracle(&oracleOptions);
+#ifndef FMS_NO_TRACING
+        stopTracing();
+#endif
+        return status;
+    }
+    if (exportOptions.path) {
+        gint64 started = g_get_monotonic_time();
+        int rows = -1;
+        if (!loadArchive(FILENAME_ARCHIVE)) {
+            fprintf(stderr, "Cannot export: %s could not be read\n", FILENAME_ARCHIVE);
+        } else if ((rows = exportArchiveColumnar(&exportOptions)) < 0) {
+            fprintf(stderr, "Cannot write %s: %s\n", exportOptions.path, g_strerror(errno));
+        } else {
+            printf("Exported %d archived flights to %s in %.2f s\n", rows, exportOptions.path,
+                   (g_get_monotonic_time() - started) / 1e6);
+        }
+#ifndef FMS_NO_TRACING
+        stopTracing();
+#endif
+        return rows < 0 ? 1 : 0;
+    }
 
+    gtk_init(&argc, &argv);
 
+    beginScheduleWrite();
     initializeSystem();
     initializeUsers();
-    loadDataFromFiles();
+    commitScheduleWrite();
+    if (viewerProcess) {
+        viewerSchedule = mapSharedSchedule();
+        if (!viewerSchedule) {
+            fprintf(stderr, "No live schedule segment found; is the planner running?\n");
+            return 1;
+        }
+        scheduleLoaded = true;
+    }
 
 
     window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -2101,6 +9307,7 @@ gtk_grid_attach(GTK_GRID(realtime_events_grid), reschedule_button, 0, 4, 1, 1);
     gtk_window_set_default_size(GTK_WINDOW(window), 1000, 700);
     gtk_window_set_position(GTK_WINDOW(window), GTK_WIN_POS_CENTER);
     g_signal_connect(window, "destroy", G_CALLBACK(gtk_main_quit), NULL);
+    g_signal_connect(window, "key-press-event", G_CALLBACK(on_window_key_press), NULL);
 
 
     stack = gtk_stack_new();
@@ -2108,20 +9315,37 @@ gtk_grid_attach(GTK_GRID(realtime_events_grid), reschedule_button, 0, 4, 1, 1);
     gtk_container_add(GTK_CONTAINER(window), stack);
 
     create_login_screen();
-    create_flight_management();
-    create_runway_management();
-    create_crew_management();
-    create_realtime_events();
-    create_schedule();
-    create_search_flight();
-    create_reports();
-    create_logout_screen();
 
     gtk_stack_set_visible_child_name(GTK_STACK(stack), "login");
 
+    labelSubscriber = subscribeNotifications(false);
+    g_timeout_add(200, drain_notifications_to_label, NULL);
+#ifndef FMS_NO_METRICS
+    g_timeout_add_seconds(METRICS_EXPORT_SECONDS, export_metrics_tick, NULL);
+#endif
+    if (viewerProcess) {
+        refresh_from_shared_schedule(NULL);
+        g_timeout_add(500, refresh_from_shared_schedule, NULL);
+    } else {
+        g_timeout_add_seconds(ARCHIVE_SWEEP_MINUTES * 60, archive_sweep_tick, NULL);
+    }
+
     gtk_widget_show_all(window);
+    if (!viewerProcess) {
+        scheduleLoader = g_thread_new("schedule-loader", load_schedule_thread, GINT_TO_POINTER(follower));
+    }
     gtk_main();
 
-    saveDataToFiles();
+    stopAirportPlanners();
+    if (!viewerProcess && scheduleLoaded) {
+        saveDataToFiles();
+    }
+    destroySharedSchedule();
+#ifndef FMS_NO_METRICS
+    finishMetricsExport();
+#endif
+#ifndef FMS_NO_TRACING
+    stopTracing();
+#endif
     return 0;
 }
\ No newline at end of file